@@ -3,6 +3,7 @@
 #include <libdariadb/utils/fs.h>
 #include <boost/program_options.hpp>
 #include <atomic>
+#include <chrono>
 #include <iomanip>
 #include <iostream>
 using namespace dariadb;
@@ -25,6 +26,8 @@ bool disable_bystep_benchmark = false;
 size_t read_benchmark_runs = 10;
 STRATEGY strategy = STRATEGY::COMPRESSED;
 size_t memory_limit = 0;
+size_t wal_shards = 1;
+bool append_scaling = false;
 
 class BenchCallback : public IReaderClb {
 public:
@@ -73,6 +76,9 @@ void parse_cmdline(int argc, char *argv[]) {
       "allocation area limit  in megabytes when strategy=MEMORY");
   aos("disable-bystep-benchmark", po::value<bool>(&disable_bystep_benchmark)
                                       ->default_value(disable_bystep_benchmark));
+  aos("wal-shards", po::value<size_t>(&wal_shards)->default_value(wal_shards),
+      "count of wal writers");
+  aos("append-scaling", "append speed by writers count benchmark.");
 
   po::variables_map vm;
   try {
@@ -102,6 +108,52 @@ void parse_cmdline(int argc, char *argv[]) {
     std::cout << "Dont clean storage." << std::endl;
     dont_clean = true;
   }
+
+  if (vm.count("append-scaling")) {
+    append_scaling = true;
+  }
+}
+
+/// append speed to wal with 1,2,4..hardware_concurrency writers.
+void append_scaling_benchmark(const std::string &storage_path) {
+  const size_t writes_per_thread = 200000;
+  std::cout << "Append scaling. wal shards: " << wal_shards << std::endl;
+
+  size_t max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+  for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+    if (dariadb::utils::fs::path_exists(storage_path)) {
+      dariadb::utils::fs::rm(storage_path);
+    }
+    auto settings = dariadb::storage::Settings::create(storage_path);
+    settings->strategy.setValue(STRATEGY::WAL);
+    settings->wal_shards.setValue(wal_shards);
+    settings->save();
+    std::unique_ptr<Engine> engine{new Engine(settings)};
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> writers;
+    for (size_t i = 0; i < threads; ++i) {
+      writers.emplace_back([&engine, i, writes_per_thread]() {
+        auto m = dariadb::Meas::empty(dariadb::Id(i));
+        for (size_t t = 0; t < writes_per_thread; ++t) {
+          m.time = dariadb::Time(t);
+          engine->append(m);
+        }
+      });
+    }
+    for (auto &t : writers) {
+      t.join();
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+
+    std::cout << "writers: " << threads
+              << " speed: " << size_t((threads * writes_per_thread) / elapsed.count())
+              << "/s" << std::endl;
+    engine = nullptr;
+  }
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
 }
 
 void show_info(Engine *storage) {
@@ -144,7 +196,11 @@ void show_info(Engine *storage) {
     persent_ss << (int64_t(100) * append_count) / dariadb_bench::all_writes << '%';
 
     std::stringstream drop_ss;
-    drop_ss << "[a:" << queue_sizes.dropper.wal << "]";
+    auto &dq = queue_sizes.dropper.queue;
+    drop_ss << "[a:" << queue_sizes.dropper.wal << " q:" << dq[Dropper::READ] << "/"
+            << dq[Dropper::SORT] << "/" << dq[Dropper::COMPRESS] << "/"
+            << dq[Dropper::WRITE] << " bp:" << queue_sizes.dropper.backpressure.waits
+            << "/" << queue_sizes.dropper.backpressure.rejected << "]";
     std::stringstream ss;
 
     ss // << "\r"
@@ -352,6 +408,11 @@ int main(int argc, char *argv[]) {
 
   parse_cmdline(argc, argv);
 
+  if (append_scaling) {
+    append_scaling_benchmark(storage_path);
+    return 0;
+  }
+
   if (readers_enable) {
     std::cout << "Readers enable. count: " << dariadb_bench::total_readers_count
               << std::endl;
@@ -374,6 +435,7 @@ int main(int argc, char *argv[]) {
 
     auto settings = dariadb::storage::Settings::create(storage_path);
     settings->strategy.setValue(strategy);
+    settings->wal_shards.setValue(wal_shards);
     settings->save();
 
     if ((strategy == STRATEGY::MEMORY || strategy == STRATEGY::CACHE) &&
@@ -43,7 +43,8 @@ void show_info() {
     auto dscr = mstore->description();
     std::cout << "\r"
               << " writes: " << append_count << " speed: " << writes_per_sec << "/sec"
-              << " [m:" << dscr.allocator_capacity << ", a:" << dscr.allocated << "]"
+              << " [m:" << dscr.allocator_capacity << ", a:" << dscr.allocated
+              << ", mb:" << dscr.allocator_mapped / (1024 * 1024) << "]"
               << " progress:" << (int64_t(100) * append_count) / dariadb_bench::all_writes
               << "%                ";
     std::cout.flush();
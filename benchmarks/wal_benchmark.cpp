@@ -6,6 +6,8 @@
 #include <libdariadb/utils/fs.h>
 
 #include <boost/program_options.hpp>
+#include <chrono>
+#include <sstream>
 
 namespace po = boost::program_options;
 
@@ -14,6 +16,37 @@ dariadb::Time write_time = 0;
 bool stop_info = false;
 dariadb::storage::WALManager_ptr wal_manager;
 
+/// measure latency of each append.
+class LatencyWriter : public dariadb::storage::IMeasWriter {
+public:
+  LatencyWriter(dariadb::storage::IMeasWriter *target) : _target(target) {
+    total_ns = 0;
+    max_ns = 0;
+  }
+
+  using dariadb::storage::IMeasWriter::append;
+  dariadb::Status append(const dariadb::Meas &value) override {
+    auto start = std::chrono::steady_clock::now();
+    auto result = _target->append(value);
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    total_ns += elapsed;
+    auto cur_max = max_ns.load();
+    while (elapsed > cur_max && !max_ns.compare_exchange_weak(cur_max, elapsed)) {
+    }
+    return result;
+  }
+
+  void flush() override { _target->flush(); }
+
+  std::atomic_llong total_ns;
+  std::atomic_llong max_ns;
+
+private:
+  dariadb::storage::IMeasWriter *_target;
+};
+
 void show_info() {
   clock_t t0 = clock();
 
@@ -46,6 +79,12 @@ int main(int argc, char *argv[]) {
   auto aos = desc.add_options();
   aos("help", "produce help message");
   aos("dont-clean", "dont clean storage path before start.");
+  std::string sync_mode = "NONE";
+  uint64_t sync_interval = 1000;
+  aos("sync", po::value<std::string>(&sync_mode)->default_value(sync_mode),
+      "wal sync mode: none, interval, every_batch, always.");
+  aos("sync-interval", po::value<uint64_t>(&sync_interval)->default_value(sync_interval),
+      "sync interval in ms for 'interval' mode.");
 
   po::variables_map vm;
   try {
@@ -77,6 +116,11 @@ int main(int argc, char *argv[]) {
     dariadb::utils::fs::mkdir(storage_path);
 
     auto settings = dariadb::storage::Settings::create(storage_path);
+    std::istringstream iss(sync_mode);
+    dariadb::storage::WAL_SYNC wal_sync;
+    iss >> wal_sync;
+    settings->wal_sync.setValue(wal_sync);
+    settings->wal_sync_interval.setValue(sync_interval);
 
     auto manifest = dariadb::storage::Manifest::create(settings);
 
@@ -90,7 +134,9 @@ int main(int argc, char *argv[]) {
 
     wal_manager = dariadb::storage::WALManager::create(_engine_env);
 
+    LatencyWriter latency_writer(wal_manager.get());
     auto wal = wal_manager.get();
+    auto start_time = std::chrono::steady_clock::now();
     std::thread info_thread(show_info);
 
     std::vector<std::thread> writers(dariadb_bench::total_threads_count);
@@ -99,7 +145,8 @@ int main(int argc, char *argv[]) {
     for (size_t i = 1; i < dariadb_bench::total_threads_count + 1; i++) {
       all_id_set.insert(pos);
       std::thread t{
-          dariadb_bench::thread_writer_rnd_stor, dariadb::Id(pos), &append_count, wal,
+          dariadb_bench::thread_writer_rnd_stor, dariadb::Id(pos), &append_count,
+          &latency_writer,
           dariadb::timeutil::current_time(),     &write_time};
       writers[pos++] = std::move(t);
     }
@@ -113,6 +160,18 @@ int main(int argc, char *argv[]) {
     stop_info = true;
     info_thread.join();
 
+    long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::steady_clock::now() - start_time)
+                            .count();
+    long long writes = append_count.load();
+    std::cout << "sync mode: " << settings->wal_sync.value() << std::endl;
+    std::cout << "throughput: " << (writes * 1000.0) / std::max(elapsed, 1LL)
+              << " writes/sec" << std::endl;
+    std::cout << "latency avg: "
+              << latency_writer.total_ns.load() / std::max(writes, 1LL) / 1000.0
+              << " us max: " << latency_writer.max_ns.load() / 1000.0 << " us"
+              << std::endl;
+
     dariadb_bench::readBenchark(all_id_set, wal, 10);
 
     manifest = nullptr;
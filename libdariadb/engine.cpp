@@ -2,30 +2,44 @@
 #include <libdariadb/engine.h>
 #include <libdariadb/flags.h>
 #include <libdariadb/storage/bystep/bystep_storage.h>
+#include <libdariadb/storage/callbacks.h>
 #include <libdariadb/storage/dropper.h>
 #include <libdariadb/storage/engine_environment.h>
+#include <libdariadb/storage/last_value_table.h>
+#include <libdariadb/storage/level_catalog.h>
 #include <libdariadb/storage/manifest.h>
 #include <libdariadb/storage/memstorage/memstorage.h>
 #include <libdariadb/storage/pages/page_manager.h>
 #include <libdariadb/storage/subscribe.h>
+#include <libdariadb/storage/tombstones.h>
+#include <libdariadb/storage/version_set.h>
 #include <libdariadb/timeutil.h>
 #include <libdariadb/utils/async/locker.h>
 #include <libdariadb/utils/async/thread_manager.h>
 #include <libdariadb/utils/exception.h>
 #include <libdariadb/utils/fs.h>
 #include <libdariadb/utils/logger.h>
+#include <libdariadb/utils/merge.h>
 #include <libdariadb/utils/strings.h>
 #include <libdariadb/utils/utils.h>
 #include <algorithm>
+#include <array>
 
 #include <cstring>
 #include <fstream>
-#include <shared_mutex>
+#include <iterator>
+#include <map>
+#include <mutex>
 
 using namespace dariadb;
 using namespace dariadb::storage;
 using namespace dariadb::utils::async;
 
+/// min count of ids, when query is splitted to parallel tasks.
+const size_t MIN_IDS_IN_GROUP = 8;
+/// max count of ids in one scan of foreach. values are buffered per scan.
+const size_t MAX_IDS_IN_BATCH = 64;
+
 class Engine::Private {
 public:
   Private(Settings_ptr settings, bool ignore_lock_file) {
@@ -34,6 +48,8 @@ public:
 
     _engine_env = EngineEnvironment::create();
     _engine_env->addResource(EngineEnvironment::Resource::SETTINGS, _settings.get());
+    _engine_env->addResource(EngineEnvironment::Resource::VERSIONS, &_versions);
+    _engine_env->addResource(EngineEnvironment::Resource::CATALOG, &_catalog);
 
     logger_info("engine: project version - ", version());
     logger_info("engine: storage format - ", format());
@@ -62,6 +78,9 @@ public:
     _manifest = Manifest::create(_settings);
     _engine_env->addResource(EngineEnvironment::Resource::MANIFEST, _manifest.get());
 
+    _tombstones = Tombstones::create(_manifest.get());
+    _engine_env->addResource(EngineEnvironment::Resource::TOMBSTONES, _tombstones.get());
+
     if (is_new_storage) {
       _manifest->set_format(std::to_string(format()));
     } else {
@@ -72,11 +91,17 @@ public:
     _page_manager = PageManager::create(_engine_env);
 
     if (_settings->load_min_max) {
-      _min_max_map = _page_manager->loadMinMax();
+      // catalog of pages is filled by the same pass over pages.
+      auto pages_mm = _page_manager->loadMinMax();
+      _catalog.extend(LEVEL::PAGES, pages_mm);
+      _last_values.load(pages_mm);
     }
 
     if (_strategy != STRATEGY::MEMORY) {
       _wal_manager = WALManager::create(_engine_env);
+      if (_settings->load_min_max) {
+        _catalog.extend(LEVEL::WAL, _wal_manager->loadMinMax());
+      }
 
       _dropper = std::make_unique<Dropper>(_engine_env, _page_manager, _wal_manager);
       _wal_manager->setDownlevel(_dropper.get());
@@ -84,7 +109,7 @@ public:
     }
 
     if (_strategy == STRATEGY::CACHE || _strategy == STRATEGY::MEMORY) {
-      _memstorage = MemStorage::create(_engine_env, _min_max_map.size());
+      _memstorage = MemStorage::create(_engine_env, _last_values.size());
       if (_strategy != STRATEGY::CACHE) {
         _memstorage->setDownLevel(_page_manager.get());
       }
@@ -96,10 +121,11 @@ public:
 
     if (_strategy == STRATEGY::WAL) {
       if (_settings->load_min_max) {
-        auto amm = _top_level_storage->loadMinMax();
-        minmax_append(_min_max_map, amm);
+        _last_values.load(_top_level_storage->loadMinMax());
       }
     }
+    // bounds of wal files are not loaded, so levels can not be pruned.
+    _catalog.setComplete(_settings->load_min_max);
 
     _bystep_storage = ByStepStorage::create(_engine_env);
 
@@ -125,6 +151,7 @@ public:
       _page_manager = nullptr;
       _manifest = nullptr;
       _dropper = nullptr;
+      _tombstones = nullptr;
       _stoped = true;
 
       _bystep_storage->stop();
@@ -176,26 +203,8 @@ public:
     }
   }
 
-  bool try_lock_storage() {
-    std::lock_guard<std::mutex> lock(_lock_locker);
-    if (_dropper != nullptr && _memstorage != nullptr) {
-      auto dl = _dropper->getLocker();
-      auto lp = _memstorage->getLockers();
-      return std::try_lock(*dl, *lp) == -1;
-    }
-
-    if (_dropper == nullptr && _memstorage != nullptr) {
-      auto lp = _memstorage->getLockers();
-      return lp->try_lock();
-    }
-
-    if (_dropper != nullptr && _memstorage == nullptr) {
-      auto dl = _dropper->getLocker();
-      return dl->try_lock();
-    }
-    THROW_EXCEPTION("engine: try_lock - bad engine configuration.");
-  }
-
+  /// used by writers of levels: erase and compaction.
+  /// readers use snapshots and are not blocked by dropping.
   void lock_storage() {
     std::lock_guard<std::mutex> lock(_lock_locker);
     if (_dropper != nullptr && _memstorage != nullptr) {
@@ -240,61 +249,42 @@ public:
     }
   }
 
+  /// values are moved only down: from memory or wal to pages, a page is added
+  /// before a source is removed. so levels, readed from top to down, are not
+  /// missing moved values, but can return them twice.
+  /// it is harmless for min and max, and they are readed without a version.
   Time minTime() {
-    lock_storage();
+    auto snapshot = _versions.pin();
 
-    auto pmin = _page_manager->minTime();
+    Time amin = _top_level_storage->minTime();
     if (_strategy == STRATEGY::CACHE) {
-      auto amin = this->_wal_manager->minTime();
-      pmin = std::min(pmin, amin);
+      amin = std::min(amin, this->_wal_manager->minTime());
     }
-    Time amin = _top_level_storage->minTime();
-
-    unlock_storage();
+    auto pmin = _page_manager->minTime();
     return std::min(pmin, amin);
   }
 
   Time maxTime() {
-    lock_storage();
+    auto snapshot = _versions.pin();
 
-    auto pmax = _page_manager->maxTime();
+    Time amax = _top_level_storage->maxTime();
     if (_strategy == STRATEGY::CACHE) {
-      auto amax = this->_wal_manager->maxTime();
-      pmax = std::max(pmax, amax);
+      amax = std::max(amax, this->_wal_manager->maxTime());
     }
-    Time amax = _top_level_storage->maxTime();
-
-    unlock_storage();
+    auto pmax = _page_manager->maxTime();
     return std::max(pmax, amax);
   }
 
+  /// levels without values of id are skipped.
   bool minMaxTime(dariadb::Id id, dariadb::Time *minResult, dariadb::Time *maxResult) {
     dariadb::Time subMin1 = dariadb::MAX_TIME, subMax1 = dariadb::MIN_TIME;
     dariadb::Time subMin3 = dariadb::MAX_TIME, subMax3 = dariadb::MIN_TIME;
-    bool pr, ar;
-    pr = ar = false;
-    auto pm = _page_manager.get();
-    AsyncTask pm_at = [&pr, &subMin1, &subMax1, id, pm](const ThreadInfo &ti) {
-      TKIND_CHECK(THREAD_KINDS::COMMON, ti.kind);
-      pr = pm->minMaxTime(id, &subMin1, &subMax1);
-      return false;
-    };
-    auto am = _top_level_storage.get();
-    AsyncTask am_at = [&ar, &subMin3, &subMax3, id, am](const ThreadInfo &ti) {
-      TKIND_CHECK(THREAD_KINDS::COMMON, ti.kind);
-      ar = am->minMaxTime(id, &subMin3, &subMax3);
-      return false;
-    };
-
-    lock_storage();
-
-    auto pm_async = ThreadManager::instance()->post(THREAD_KINDS::COMMON, AT(pm_at));
-    auto am_async = ThreadManager::instance()->post(THREAD_KINDS::COMMON, AT(am_at));
-
-    pm_async->wait();
-    am_async->wait();
-
-    unlock_storage();
+    auto snapshot = _versions.pin();
+    // top level first, see minTime.
+    auto ar = _catalog.intersects(top_level(), id, MIN_TIME, MAX_TIME) &&
+              _top_level_storage->minMaxTime(id, &subMin3, &subMax3);
+    auto pr = _catalog.intersects(LEVEL::PAGES, id, MIN_TIME, MAX_TIME) &&
+              _page_manager->minMaxTime(id, &subMin1, &subMax1);
 
     *minResult = dariadb::MAX_TIME;
     *maxResult = dariadb::MIN_TIME;
@@ -305,17 +295,15 @@ public:
   }
 
   Id2MinMax loadMinMax() {
-    this->lock_storage();
+    auto snapshot = _versions.pin();
 
-    auto p_mm = this->_page_manager->loadMinMax();
+    // top level first, see minTime.
+    auto t_mm = this->_top_level_storage->loadMinMax();
     if (_strategy == STRATEGY::CACHE) {
       auto a_mm = this->_wal_manager->loadMinMax();
-      minmax_append(p_mm, a_mm);
+      minmax_append(t_mm, a_mm);
     }
-    auto t_mm = this->_top_level_storage->loadMinMax();
-
-    this->unlock_storage();
-
+    auto p_mm = this->_page_manager->loadMinMax();
     minmax_append(p_mm, t_mm);
 
     auto bs_mm = _bystep_storage->loadMinMax();
@@ -330,45 +318,114 @@ public:
     if (isBystepId(value.id)) {
       result = _bystep_storage->append(value);
     } else {
+      catalog_append(value.id, value.time, value.time);
       result = _top_level_storage->append(value);
     }
 
     if (result.writed == 1) {
       _subscribe_notify.on_append(value);
-      _min_max_locker.lock();
-      auto insert_fres = _min_max_map.find(value.id);
-      if (insert_fres == _min_max_map.end()) {
-        _min_max_map[value.id].max = value;
-      } else {
-        insert_fres->second.updateMax(value);
+      _last_values.updateMax(value);
+    }
+
+    return result;
+  }
+
+  /// true - if level can ignore only first values of run, as written to past.
+  /// so written values of run are known from Status.
+  bool is_bulk_run(const MeasArray::const_iterator &begin,
+                   const MeasArray::const_iterator &end, bool is_bystep) const {
+    if (!is_bystep && _memstorage != nullptr &&
+        _settings->memory_reorder_window.value() != 0) {
+      return false;
+    }
+    return std::adjacent_find(begin, end, [](const Meas &l, const Meas &r) {
+             return l.time >= r.time;
+           }) == end;
+  }
+
+  /// values are grouped by id, runs of id are written in bulk.
+  /// subscribers and min/max are updated once per id.
+  Status append(const MeasArray::const_iterator &begin,
+                const MeasArray::const_iterator &end) {
+    MeasArray values(begin, end);
+    auto by_id = [](const Meas &l, const Meas &r) { return l.id < r.id; };
+    if (!std::is_sorted(values.cbegin(), values.cend(), by_id)) {
+      std::stable_sort(values.begin(), values.end(), by_id);
+    }
+
+    using Range = std::pair<MeasArray::const_iterator, MeasArray::const_iterator>;
+    std::vector<Range> writed;
+    Status result{};
+    auto it = values.cbegin();
+    auto values_end = values.cend();
+    while (it != values_end && result.error == APPEND_ERROR::OK) {
+      auto id = it->id;
+      auto run_end =
+          std::find_if(it, values_end, [id](const Meas &m) { return m.id != id; });
+      auto is_bystep = isBystepId(id);
+      if (!is_bulk_run(it, run_end, is_bystep)) {
+        for (; it != run_end && result.error == APPEND_ERROR::OK; ++it) {
+          result = result + append(*it);
+        }
+        continue;
       }
-      _min_max_locker.unlock();
+
+      if (!is_bystep) {
+        catalog_append(id, it->time, (run_end - 1)->time);
+      }
+      auto st = is_bystep ? _bystep_storage->append(it, run_end)
+                          : _top_level_storage->append(it, run_end);
+      // rejected value is the last processed.
+      auto past = st.error == APPEND_ERROR::OK ? st.ignored : st.ignored - 1;
+      if (st.writed != 0) {
+        writed.emplace_back(it + past, it + past + st.writed);
+      }
+      result = result + st;
+      it = st.error == APPEND_ERROR::OK ? run_end : it + st.writed + st.ignored;
     }
+    result.ignored += size_t(std::distance(it, values_end)); // after rejection.
 
+    if (!writed.empty()) {
+      for (auto &r : writed) {
+        _subscribe_notify.on_append(r.first, r.second);
+        _last_values.updateMax(*(r.second - 1));
+      }
+    }
     return result;
   }
 
+  /// level, which receives appended values.
+  LEVEL top_level() const { return _memstorage != nullptr ? LEVEL::MEMORY : LEVEL::WAL; }
+
+  /// catalog is extended before values are visible to readers.
+  void catalog_append(Id id, Time minTime, Time maxTime) {
+    if (_memstorage != nullptr) {
+      _catalog.extend(LEVEL::MEMORY, id, minTime, maxTime);
+    }
+    // when strategy=CACHE values are written to wal too.
+    if (_wal_manager != nullptr) {
+      _catalog.extend(LEVEL::WAL, id, minTime, maxTime);
+    }
+  }
+
   void subscribe(const IdArray &ids, const Flag &flag, const ReaderClb_ptr &clbk) {
     auto new_s = std::make_shared<SubscribeInfo>(ids, flag, clbk);
     _subscribe_notify.add(new_s);
   }
 
   Id2Meas currentValue(const IdArray &ids, const Flag &flag) {
-    lock_storage();
-
     Id2Meas a_result;
-    for (auto kv : _min_max_map) {
-      bool ids_check = false;
-      if (ids.size() == 0) {
-        ids_check = true;
-      } else {
-        if (std::count(ids.begin(), ids.end(), kv.first)) {
-          ids_check = true;
+    if (ids.empty()) {
+      _last_values.foreach([&a_result, flag](const Meas &m) {
+        if (m.inFlag(flag)) {
+          a_result.emplace(std::make_pair(m.id, m));
         }
-      }
-      if (ids_check) {
-        if (kv.second.max.inFlag(flag)) {
-          a_result.emplace(std::make_pair(kv.first, kv.second.max));
+      });
+    } else {
+      Meas m;
+      for (auto id : ids) {
+        if (_last_values.find(id, &m) && m.inFlag(flag)) {
+          a_result.emplace(std::make_pair(id, m));
         }
       }
     }
@@ -387,8 +444,6 @@ public:
         a_result[kv.first] = kv.second;
       }
     }
-
-    unlock_storage();
     return a_result;
   }
 
@@ -428,87 +483,315 @@ public:
     return result;
   }
 
-  /// when strategy=CACHE
-  void foreach_internal_cache(const QueryInterval &q, IReaderClb *p_clbk,
-                              IReaderClb *a_clbk) {
+  bool overloaded() const {
+    if (_memstorage != nullptr && _memstorage->description().backpressure.overloaded) {
+      return true;
+    }
+    if (_dropper != nullptr && _dropper->description().backpressure.overloaded) {
+      return true;
+    }
+    return _bystep_storage->description().backpressure.overloaded;
+  }
+
+  /// when strategy=CACHE. one scan of pages and wal for all ids, memstorage - per id.
+  void foreach_internal_cache(const QueryInterval &q, const QueryPlan &plan,
+                              IdFanOut_ReaderClb *p_clbk, IdFanOut_ReaderClb *a_clbk,
+                              IdFanOut_ReaderClb *m_clbk) {
     auto pm = _page_manager.get();
     auto mm = _memstorage.get();
     auto am = _wal_manager.get();
 
     auto memory_mm = mm->loadMinMax();
     auto sync_map = mm->getSyncMap();
+
+    IdArray disk_ids;
+    disk_ids.reserve(q.ids.size());
     QueryInterval local_q = q;
-    auto id = local_q.ids.front();
-    auto id_mm = memory_mm.find(local_q.ids.front());
-    if (id_mm == memory_mm.end()) {
-      pm->foreach (local_q, p_clbk);
-      am->foreach (local_q, a_clbk);
-    } else {
-      if ((id_mm->second.min.time) > local_q.from) {
+    local_q.ids.resize(1);
+    for (auto id : q.ids) {
+      auto id_mm = memory_mm.find(id);
+      if (id_mm == memory_mm.end()) {
+        disk_ids.push_back(id);
+        continue;
+      }
+      local_q.ids[0] = id;
+      local_q.from = q.from;
+      local_q.to = q.to;
+      if ((id_mm->second.min.time) > q.from) {
+        // older values are readed from disk, newer - from memory.
         auto min_mem_time = sync_map[id];
-        local_q.to = min_mem_time;
-        pm->foreach (local_q, p_clbk);
-        am->foreach (local_q, a_clbk);
+        disk_ids.push_back(id);
+        p_clbk->setLimit(id, min_mem_time);
+        a_clbk->setLimit(id, min_mem_time);
 
         if (min_mem_time < q.to) {
           if (min_mem_time != MIN_TIME) { // to read value after min_mem_time;
             min_mem_time += 1;
           }
           local_q.from = min_mem_time;
-          local_q.to = q.to;
-          mm->foreach (local_q, a_clbk);
+          mm->foreach (local_q, m_clbk);
         }
       } else {
-        mm->foreach (local_q, a_clbk);
+        mm->foreach (local_q, m_clbk);
       }
-      if (a_clbk->is_canceled()) {
+      if (m_clbk->is_canceled()) {
         return;
       }
     }
+
+    if (!disk_ids.empty()) {
+      local_q = q;
+      auto &p_ids = plan[LEVEL::PAGES].scan;
+      auto &w_ids = plan[LEVEL::WAL].scan;
+      if (!p_ids.empty()) {
+        local_q.ids = intersection(disk_ids, p_ids);
+        if (!local_q.ids.empty()) {
+          pm->foreach (local_q, p_clbk);
+        }
+      }
+      if (!w_ids.empty()) {
+        local_q.ids = intersection(disk_ids, w_ids);
+        if (!local_q.ids.empty()) {
+          am->foreach (local_q, a_clbk);
+        }
+      }
+    }
   }
 
-  /// when strategy!=CACHEs
-  void foreach_internal_two_level(const QueryInterval &q, IReaderClb *p_clbk,
-                                  IReaderClb *a_clbk) {
+  /// ids of 'ids', which are in 'filter'. order of 'ids' is kept.
+  static IdArray intersection(const IdArray &ids, const IdArray &filter) {
+    IdSet filter_set(filter.begin(), filter.end());
+    IdArray result;
+    result.reserve(std::min(ids.size(), filter.size()));
+    for (auto id : ids) {
+      if (filter_set.find(id) != filter_set.end()) {
+        result.push_back(id);
+      }
+    }
+    return result;
+  }
+
+  /// when strategy!=CACHE. levels without values of query are not readed.
+  void foreach_internal_two_level(const QueryInterval &q, const QueryPlan &plan,
+                                  IReaderClb *p_clbk, IReaderClb *a_clbk) {
     auto pm = _page_manager.get();
     auto tm = _top_level_storage.get();
-    if (!p_clbk->is_canceled()) {
-      pm->foreach (q, p_clbk);
+    auto local_q = q;
+    local_q.ids = plan[LEVEL::PAGES].scan;
+    if (!p_clbk->is_canceled() && !local_q.ids.empty()) {
+      pm->foreach (local_q, p_clbk);
     }
-    if (!a_clbk->is_canceled()) {
-      tm->foreach (q, a_clbk);
+    local_q.ids = plan[top_level()].scan;
+    if (!a_clbk->is_canceled() && !local_q.ids.empty()) {
+      tm->foreach (local_q, a_clbk);
     }
   }
 
-  void foreach_internal(const QueryInterval &q, IReaderClb *p_clbk, IReaderClb *a_clbk) {
-    AsyncTask pm_at = [p_clbk, a_clbk, q, this](const ThreadInfo &ti) {
-      TKIND_CHECK(THREAD_KINDS::COMMON, ti.kind);
-      if (!try_lock_storage()) {
-        return true;
+  /// levels to read for interval query. level is pruned for id, if catalog has
+  /// no values of id in query interval.
+  QueryPlan plan(const QueryInterval &q) {
+    QueryPlan result;
+    result[LEVEL::PAGES].exists = true;
+    result[LEVEL::WAL].exists = _wal_manager != nullptr;
+    result[LEVEL::MEMORY].exists = _memstorage != nullptr;
+    for (auto id : q.ids) {
+      if (isBystepId(id)) {
+        result.bystep.push_back(id);
+        continue;
       }
-      auto local_q = q;
-      local_q.ids.resize(1);
-      for (auto id : q.ids) {
-        local_q.from = q.from;
-        local_q.to = q.to;
-        local_q.ids[0] = id;
-
-        if (isBystepId(id)) {
-          _bystep_storage->foreach (local_q, a_clbk);
+      for (size_t i = 0; i < LEVELS_COUNT; ++i) {
+        auto &l = result.levels[i];
+        if (!l.exists) {
+          continue;
+        }
+        if (_catalog.intersects(LEVEL(i), id, q.from, q.to)) {
+          l.scan.push_back(id);
         } else {
-          if (this->strategy() == STRATEGY::CACHE) {
-            foreach_internal_cache(local_q, p_clbk, a_clbk);
-          } else {
-            foreach_internal_two_level(local_q, p_clbk, a_clbk);
-          }
+          l.pruned.push_back(id);
         }
       }
-      a_clbk->is_end();
-      this->unlock_storage();
+    }
+    return result;
+  }
+
+  /// each storage level is scanned once for all ids, values are collected per id.
+  /// all levels are readed in one version: q.version, if it pinned by caller, or
+  /// in the new pinned one.
+  void scan_levels(const QueryInterval &q, IdFanOut_ReaderClb *pages_clbk,
+                   IdFanOut_ReaderClb *top_clbk, IdFanOut_ReaderClb *mem_clbk) {
+    Snapshot_Ptr snapshot;
+    auto local_q = q;
+    if (q.version == NEWEST_VERSION) {
+      snapshot = _versions.pin();
+      local_q.version = snapshot->version();
+    }
+    auto p = plan(q);
+    if (!p.bystep.empty()) {
+      local_q.ids = p.bystep;
+      _bystep_storage->foreach (local_q, top_clbk);
+    }
+    if (p.bystep.size() != q.ids.size()) {
+      local_q.ids.clear();
+      for (auto id : q.ids) {
+        if (!isBystepId(id)) {
+          local_q.ids.push_back(id);
+        }
+      }
+      if (this->strategy() == STRATEGY::CACHE) {
+        foreach_internal_cache(local_q, p, pages_clbk, top_clbk, mem_clbk);
+      } else {
+        foreach_internal_two_level(local_q, p, pages_clbk, top_clbk);
+      }
+    }
+  }
+
+  /// pins version of levels for q, if it is not set by caller.
+  Snapshot_Ptr pin_query(QueryInterval &q) {
+    Snapshot_Ptr result;
+    if (q.version == NEWEST_VERSION) {
+      result = _versions.pin();
+      q.version = result->version();
+    }
+    return result;
+  }
+
+  /// ids of query, splitted to groups for parallel tasks. order of ids is kept.
+  std::vector<IdArray> split_ids(const IdArray &ids) const {
+    auto pool_size = ThreadManager::instance()->threads_count(THREAD_KINDS::COMMON);
+    auto fanout = size_t(_settings->query_fanout.value());
+    if (fanout == 0 || fanout > pool_size) {
+      fanout = pool_size;
+    }
+    // each group scans all levels, so small queries are not splitted.
+    auto groups = std::min(fanout, (ids.size() + MIN_IDS_IN_GROUP - 1) / MIN_IDS_IN_GROUP);
+    groups = std::max(groups, size_t(1));
+
+    std::vector<IdArray> result(groups);
+    auto per_group = ids.size() / groups;
+    auto rest = ids.size() % groups;
+    auto it = ids.begin();
+    for (size_t i = 0; i < groups; ++i) {
+      auto count = per_group + (i < rest ? 1 : 0);
+      result[i].assign(it, it + count);
+      it += count;
+    }
+    return result;
+  }
+
+  /// ids of one scan of foreach query.
+  struct QueryBatch {
+    QueryBatch(const IdArray &ids_, IReaderClb *p_clbk, IReaderClb *a_clbk)
+        : ids(ids_), pages_clbk(p_clbk), top_clbk(a_clbk), mem_clbk(a_clbk), done(false) {}
+    IdArray ids;
+    IdFanOut_ReaderClb pages_clbk;
+    IdFanOut_ReaderClb top_clbk;
+    IdFanOut_ReaderClb mem_clbk;
+    bool done;
+  };
+
+  /// batches of foreach query. at most 'window' batches are scanned or wait
+  /// for sending at once, so only values of them are buffered.
+  struct QueryBatches {
+    std::mutex locker;
+    QueryInterval q;
+    IReaderClb *p_clbk;
+    IReaderClb *a_clbk;
+    std::vector<IdArray> ids; // of batches, in order of query.
+    std::map<size_t, std::unique_ptr<QueryBatch>> batches; // posted, not sended.
+    size_t posted;
+    size_t sended;
+    size_t window;
+    Snapshot_Ptr snapshot;
+
+    QueryBatches(const QueryInterval &q_) : q(q_) {}
+  };
+
+  using QueryBatches_Ptr = std::shared_ptr<QueryBatches>;
+
+  /// ids, splitted to batches of 'batch_size' or less. order of ids is kept.
+  static std::vector<IdArray> chunk_ids(const IdArray &ids, size_t batch_size) {
+    batch_size = std::max(batch_size, size_t(1));
+    std::vector<IdArray> result;
+    result.reserve((ids.size() + batch_size - 1) / batch_size);
+    for (auto it = ids.begin(); it != ids.end();) {
+      auto count = std::min(batch_size, size_t(std::distance(it, ids.end())));
+      result.emplace_back(it, it + count);
+      it += count;
+    }
+    if (result.empty()) {
+      result.emplace_back();
+    }
+    return result;
+  }
+
+  /// ids of query, splitted to batches of MAX_IDS_IN_BATCH or less. order of ids is kept.
+  std::vector<IdArray> split_batches(const IdArray &ids, size_t *window) const {
+    auto groups = split_ids(ids);
+    *window = groups.size();
+    return chunk_ids(ids, std::min(MAX_IDS_IN_BATCH, groups.front().size()));
+  }
+
+  /// posts next batch of query. state->locker must be locked.
+  void post_batch(const QueryBatches_Ptr &state) {
+    auto num = state->posted++;
+    auto b = new QueryBatch(state->ids[num], state->p_clbk, state->a_clbk);
+    state->batches[num].reset(b);
+
+    AsyncTask at = [state, b, this](const ThreadInfo &ti) {
+      TKIND_CHECK(THREAD_KINDS::COMMON, ti.kind);
+      if (!state->a_clbk->is_canceled()) {
+        auto batch_q = state->q;
+        batch_q.ids = b->ids;
+        scan_levels(batch_q, &b->pages_clbk, &b->top_clbk, &b->mem_clbk);
+      }
+      std::lock_guard<std::mutex> lg(state->locker);
+      b->done = true;
+      send_ready(state);
       return false;
     };
+    ThreadManager::instance()->post(THREAD_KINDS::COMMON, AT(at));
+  }
+
+  /// finished batches are sended, when all batches before them are sended.
+  /// places of sended batches are taken by next ones. state->locker must be locked.
+  void send_ready(const QueryBatches_Ptr &state) {
+    auto it = state->batches.find(state->sended);
+    while (it != state->batches.end() && it->second->done) {
+      auto ready = it->second.get();
+      for (auto id : ready->ids) {
+        ready->pages_clbk.send(id);
+        ready->top_clbk.send(id);
+        ready->mem_clbk.send(id);
+      }
+      state->batches.erase(it);
+      state->sended++;
+      it = state->batches.find(state->sended);
+    }
+    if (state->sended == state->ids.size()) {
+      state->a_clbk->is_end();
+      return;
+    }
+    while (state->posted != state->ids.size() &&
+           state->posted < state->sended + state->window) {
+      post_batch(state);
+    }
+  }
 
-    ThreadManager::instance()->post(THREAD_KINDS::COMMON, AT(pm_at));
+  /// ids are scanned by parallel tasks in batches. values are sended to callbacks
+  /// id by id in order of query: pages, then upper levels.
+  void foreach_internal(const QueryInterval &q, IReaderClb *p_clbk, IReaderClb *a_clbk) {
+    auto state = std::make_shared<QueryBatches>(q);
+    state->snapshot = pin_query(state->q);
+    state->p_clbk = p_clbk;
+    state->a_clbk = a_clbk;
+    state->ids = split_batches(q.ids, &state->window);
+    state->posted = 0;
+    state->sended = 0;
+
+    std::lock_guard<std::mutex> lg(state->locker);
+    while (state->posted != state->ids.size() && state->posted < state->window) {
+      post_batch(state);
+    }
   }
 
   void foreach (const QueryInterval &q, IReaderClb * clbk) {
@@ -526,78 +809,142 @@ public:
     clbk->is_end();
   }
 
-  MeasList readInterval(const QueryInterval &q) {
-    auto p_clbk = std::make_unique<MList_ReaderClb>();
-    auto a_clbk = std::make_unique<MList_ReaderClb>();
-    this->foreach_internal(q, p_clbk.get(), a_clbk.get());
-    a_clbk->wait();
-    Id2MSet sub_result;
-    MeasList result;
-
-    mlist2mset(p_clbk->mlist, sub_result);
-    mlist2mset(a_clbk->mlist, sub_result);
-
+  /// values of q.ids are appended to 'result' id by id. per id buffers of levels
+  /// are merged by time straight into 'result': on equal time the value
+  /// of the lower level is kept.
+  template <class Container> void merge_group(const QueryInterval &q, Container &result) {
+    IdFanOut_ReaderClb pages_clbk(nullptr);
+    IdFanOut_ReaderClb top_clbk(nullptr);
+    IdFanOut_ReaderClb mem_clbk(nullptr);
+    scan_levels(q, &pages_clbk, &top_clbk, &mem_clbk);
+
+    std::array<IdFanOut_ReaderClb *, 3> levels{&pages_clbk, &top_clbk, &mem_clbk};
+    size_t total = 0;
+    for (auto l : levels) {
+      for (auto &kv : l->values) {
+        total += kv.second.size();
+      }
+    }
+    auto start = result.size();
+    result.resize(start + total);
+    auto out = result.begin() + start;
+    std::vector<MeasArray *> runs;
     for (auto id : q.ids) {
-      auto sublist = sub_result.find(id);
-      if (sublist == sub_result.end()) {
-        continue;
+      runs.clear();
+      for (auto l : levels) {
+        auto it = l->values.find(id);
+        if (it != l->values.end()) {
+          runs.push_back(&it->second);
+        }
       }
-      for (auto v : sublist->second) {
-        result.push_back(v);
+      out = utils::merge_runs(runs, out);
+      for (auto l : levels) {
+        l->values.erase(id);
       }
     }
+    result.erase(out, result.end());
+  }
+
+  /// groups of ids are merged by parallel tasks and appended to 'result' in order of query.
+  /// buffer of group is freed as soon as it is appended.
+  template <class Container> void read_merged(const QueryInterval &q, Container &result) {
+    auto local_q = q;
+    auto snapshot = pin_query(local_q);
+    auto groups = split_ids(q.ids);
+    if (groups.size() == 1) { // no copy of merged values.
+      merge_group(local_q, result);
+      return;
+    }
+    std::vector<MeasArray> group_values(groups.size());
+    std::vector<TaskResult_Ptr> handles;
+    handles.reserve(groups.size());
+    for (size_t i = 0; i < groups.size(); ++i) {
+      AsyncTask at = [&local_q, &groups, &group_values, i, this](const ThreadInfo &ti) {
+        TKIND_CHECK(THREAD_KINDS::COMMON, ti.kind);
+        auto group_q = local_q;
+        group_q.ids = groups[i];
+        merge_group(group_q, group_values[i]);
+        return false;
+      };
+      handles.push_back(ThreadManager::instance()->post(THREAD_KINDS::COMMON, AT(at)));
+    }
+    for (size_t i = 0; i < groups.size(); ++i) {
+      handles[i]->wait();
+      auto &values = group_values[i];
+      result.insert(result.end(), values.begin(), values.end());
+      values.clear();
+      values.shrink_to_fit();
+    }
+  }
 
+  MeasList readInterval(const QueryInterval &q) {
+    MeasList result;
+    read_merged(q, result);
     return result;
   }
 
+  /// all ids are readed in one version, which is pinned until cursor is closed.
+  /// each group of MAX_IDS_IN_BATCH ids is readed by one scan of levels.
+  Cursor_Ptr openCursor(const QueryInterval &q, size_t batch_size) {
+    auto snapshot = _versions.pin();
+    auto local_q = q;
+    local_q.version = snapshot->version();
+    auto reader = [this, local_q, snapshot](const IdArray &ids, MeasArray &out) {
+      auto group_q = local_q;
+      group_q.ids = ids;
+      read_merged(group_q, out);
+    };
+    return Cursor::create(chunk_ids(q.ids, MAX_IDS_IN_BATCH), batch_size, reader);
+  }
+
+  /// ids are resolved level by level, from the top one. each level is readed once
+  /// for all not resolved ids, which can have values before time point on it.
   Id2Meas readTimePoint(const QueryTimePoint &q) {
     Id2Meas result;
     result.reserve(q.ids.size());
     for (auto id : q.ids) {
-      result[id].flag = Flags::_NO_DATA;
+      auto &m = result[id];
+      m = Meas::empty(id);
+      m.flag = Flags::_NO_DATA;
+      m.time = q.time_point;
     }
 
-    auto pm = _page_manager.get();
-    auto mm = _top_level_storage.get();
-    auto am = _wal_manager.get();
-    AsyncTask pm_at = [&result, &q, this, pm, mm, am](const ThreadInfo &ti) {
+    AsyncTask pm_at = [&result, &q, this](const ThreadInfo &ti) {
       TKIND_CHECK(THREAD_KINDS::COMMON, ti.kind);
-      if (!try_lock_storage()) {
-        return true;
-      }
-      for (auto id : q.ids) {
+      auto snapshot = _versions.pin();
+      QueryTimePoint local_q = q;
+      local_q.version = snapshot->version();
 
-        QueryTimePoint local_q = q;
-        local_q.ids.clear();
-        local_q.ids.push_back(id);
+      IdArray bystep_ids;
+      IdArray not_resolved;
+      not_resolved.reserve(q.ids.size());
+      for (auto id : q.ids) {
         if (isBystepId(id)) {
-          auto bsts = _bystep_storage->readTimePoint(local_q);
-          for (auto &kv : bsts) {
-            result[kv.first] = kv.second;
-          }
+          bystep_ids.push_back(id);
         } else {
-          dariadb::Time minT, maxT;
-
-          if (mm->minMaxTime(id, &minT, &maxT) &&
-              (minT < q.time_point || maxT < q.time_point)) {
-            auto subres = mm->readTimePoint(local_q);
-            result[id] = subres[id];
-          } else {
-            bool in_wal_level = false;
-            if (this->strategy() == STRATEGY::CACHE) {
-              auto subres = am->readTimePoint(local_q);
-              auto value = subres[id];
-              result[id] = value;
-              in_wal_level = value.flag != Flags::_NO_DATA;
-            }
-            if (!in_wal_level) {
-              auto subres = _page_manager->valuesBeforeTimePoint(local_q);
-              result[id] = subres[id];
-            }
-          }
+          not_resolved.push_back(id);
+        }
+      }
+      if (!bystep_ids.empty()) {
+        local_q.ids = bystep_ids;
+        for (auto &kv : _bystep_storage->readTimePoint(local_q)) {
+          result[kv.first] = kv.second;
+        }
+      }
+
+      // chunks of memory level can be dropped in the pinned version.
+      read_time_point_level(top_level(), _top_level_storage.get(), local_q,
+                            not_resolved, result);
+      if (this->strategy() == STRATEGY::CACHE) {
+        read_time_point_level(LEVEL::WAL, _wal_manager.get(), local_q, not_resolved,
+                              result);
+      }
+      local_q.ids = levelIds(LEVEL::PAGES, not_resolved, q.time_point);
+      if (!local_q.ids.empty()) {
+        for (auto &kv : _page_manager->valuesBeforeTimePoint(local_q)) {
+          result[kv.first] = kv.second;
         }
       }
-      unlock_storage();
       return false;
     };
 
@@ -606,6 +953,39 @@ public:
     return result;
   }
 
+  /// ids, which can have values before time point on level.
+  IdArray levelIds(LEVEL l, const IdArray &ids, Time time_point) const {
+    IdArray result;
+    result.reserve(ids.size());
+    for (auto id : ids) {
+      if (_catalog.intersects(l, id, MIN_TIME, time_point)) {
+        result.push_back(id);
+      }
+    }
+    return result;
+  }
+
+  /// one read of level for all 'ids'. found ids are removed from 'ids'.
+  void read_time_point_level(LEVEL l, IMeasSource *storage, QueryTimePoint &q,
+                             IdArray &ids, Id2Meas &result) {
+    q.ids = levelIds(l, ids, q.time_point);
+    if (q.ids.empty()) {
+      return;
+    }
+    auto subres = storage->readTimePoint(q);
+    IdArray rest;
+    rest.reserve(ids.size());
+    for (auto id : ids) {
+      auto it = subres.find(id);
+      if (it == subres.end() || it->second.flag == Flags::_NO_DATA) {
+        rest.push_back(id);
+      } else {
+        result[id] = it->second;
+      }
+    }
+    ids.swap(rest);
+  }
+
   void drop_part_wals(size_t count) {
     if (_wal_manager != nullptr) {
       logger_info("engine: drop_part_wals ", count);
@@ -636,6 +1016,105 @@ public:
     this->unlock_storage();
   }
 
+  void erase(const IdArray &ids, Time from, Time to) {
+    logger_info("engine: erase ", ids.size(), " ids from ", timeutil::to_string(from),
+                " to ", timeutil::to_string(to));
+    IdArray raw_ids;
+    this->lock_storage();
+    for (auto id : ids) {
+      if (isBystepId(id)) {
+        _bystep_storage->eraseOld(id, from, to);
+      } else {
+        raw_ids.push_back(id);
+      }
+    }
+    if (!raw_ids.empty()) {
+      // values written before are in sealed chunks and files, tombstones cover only them.
+      TombstoneRecord rec;
+      rec.from = from;
+      rec.to = to;
+      rec.page_seq = _page_manager->next_chunk_id();
+      rec.wal_seq = _wal_manager != nullptr ? _wal_manager->seal() : 0;
+      rec.memory_seq = _memstorage != nullptr ? _memstorage->seal(raw_ids, from, to) : 0;
+      for (auto id : raw_ids) {
+        rec.id = id;
+        _tombstones->append(rec);
+      }
+    }
+    this->unlock_storage();
+
+    // last values may be erased.
+    for (auto id : raw_ids) {
+      Meas current;
+      if (!_last_values.find(id, &current) ||
+          !utils::inInterval(from, to, current.time)) {
+        continue;
+      }
+
+      auto last = lastValue(id);
+      if (last.flag == Flags::_NO_DATA) {
+        _last_values.erase(id);
+      } else {
+        _last_values.set(last);
+      }
+    }
+  }
+
+  /// last not erased value from all levels.
+  Meas lastValue(Id id) {
+    QueryTimePoint qp({id}, 0, MAX_TIME);
+    std::vector<Meas> candidates;
+    auto snapshot = _versions.pin();
+    qp.version = snapshot->version();
+    candidates.push_back(_page_manager->valuesBeforeTimePoint(qp)[id]);
+    candidates.push_back(_top_level_storage->readTimePoint(qp)[id]);
+    if (_strategy == STRATEGY::CACHE) {
+      candidates.push_back(_wal_manager->readTimePoint(qp)[id]);
+    }
+    snapshot = nullptr;
+
+    Meas result;
+    result.flag = Flags::_NO_DATA;
+    for (auto &m : candidates) {
+      if (m.flag == Flags::_NO_DATA) {
+        continue;
+      }
+      if (result.flag == Flags::_NO_DATA || result.time < m.time) {
+        result = m;
+      }
+    }
+    return result;
+  }
+
+  bool has_data(IMeasStorage *storage, Id id, Time from, Time to) {
+    Time minT, maxT;
+    if (storage == nullptr || !storage->minMaxTime(id, &minT, &maxT)) {
+      return false;
+    }
+    return !(maxT < from || minT > to);
+  }
+
+  /// tombstone can be removed when erased values are not stored anywhere.
+  void tombstones_gc() {
+    if (_tombstones->empty()) {
+      return;
+    }
+    for (auto &rec : _tombstones->list()) {
+      QueryInterval qi({rec.id}, 0, rec.from, rec.to);
+      if (_page_manager->hasValues(qi, rec.page_seq)) {
+        continue;
+      }
+      if (has_data(_top_level_storage.get(), rec.id, rec.from, rec.to)) {
+        continue;
+      }
+      if (_strategy == STRATEGY::CACHE &&
+          has_data(_wal_manager.get(), rec.id, rec.from, rec.to)) {
+        continue;
+      }
+      _tombstones->remove(rec);
+    }
+  }
+
   STRATEGY strategy() const {
     ENSURE(_strategy == _settings->strategy.value());
     return this->_strategy;
@@ -645,6 +1124,7 @@ public:
     this->lock_storage();
     logger_info("engine: compacting to ", pagesCount + 1);
     _page_manager->compactTo(pagesCount);
+    tombstones_gc();
     this->unlock_storage();
   }
 
@@ -653,6 +1133,7 @@ public:
     logger_info("engine: compacting by time ", timeutil::to_string(from), "-",
                 timeutil::to_string(to));
     _page_manager->compactbyTime(from, to);
+    tombstones_gc();
     this->unlock_storage();
   }
 
@@ -676,6 +1157,11 @@ protected:
   std::mutex _flush_locker, _lock_locker;
   SubscribeNotificator _subscribe_notify;
 
+  /// versions of levels. destroyed after all levels.
+  VersionSet _versions;
+  /// per id bounds of levels. destroyed after all levels.
+  LevelCatalog _catalog;
+
   std::unique_ptr<Dropper> _dropper;
   PageManager_ptr _page_manager;
   WALManager_ptr _wal_manager;
@@ -685,13 +1171,13 @@ protected:
   Settings_ptr _settings;
   STRATEGY _strategy;
   Manifest_ptr _manifest;
+  Tombstones_ptr _tombstones;
   bool _stoped;
 
   IMeasStorage_ptr _top_level_storage; // wal or memory storage.
   ByStepStorage_ptr _bystep_storage;
 
-  Id2MinMax _min_max_map;
-  std::shared_mutex _min_max_locker;
+  LastValueTable _last_values;
 
   /// bystep to raw.
   Id2Step _id2steps;
@@ -720,6 +1206,17 @@ Status Engine::append(const Meas &value) {
   return _impl->append(value);
 }
 
+Status Engine::append(const MeasArray::const_iterator &begin,
+                      const MeasArray::const_iterator &end) {
+  return _impl->append(begin, end);
+}
+
+Status Engine::append(const MeasList::const_iterator &begin,
+                      const MeasList::const_iterator &end) {
+  MeasArray values(begin, end);
+  return _impl->append(values.cbegin(), values.cend());
+}
+
 void Engine::subscribe(const IdArray &ids, const Flag &flag, const ReaderClb_ptr &clbk) {
   _impl->subscribe(ids, flag, clbk);
 }
@@ -739,6 +1236,10 @@ Engine::Description Engine::description() const {
   return _impl->description();
 }
 
+bool Engine::overloaded() const {
+  return _impl->overloaded();
+}
+
 void Engine::foreach (const QueryInterval &q, IReaderClb * clbk) {
   return _impl->foreach (q, clbk);
 }
@@ -751,6 +1252,14 @@ MeasList Engine::readInterval(const QueryInterval &q) {
   return _impl->readInterval(q);
 }
 
+QueryPlan Engine::explain(const QueryInterval &q) {
+  return _impl->plan(q);
+}
+
+Cursor_Ptr Engine::openCursor(const QueryInterval &q, size_t batch_size) {
+  return _impl->openCursor(q, batch_size);
+}
+
 Id2Meas Engine::readTimePoint(const QueryTimePoint &q) {
   return _impl->readTimePoint(q);
 }
@@ -775,6 +1284,10 @@ void Engine::eraseOld(const Time &t) {
   return _impl->eraseOld(t);
 }
 
+void Engine::erase(const IdArray &ids, Time from, Time to) {
+  _impl->erase(ids, from, to);
+}
+
 void Engine::compactTo(uint32_t pagesCount) {
   _impl->compactTo(pagesCount);
 }
@@ -4,7 +4,9 @@
 #include <libdariadb/st_exports.h>
 #include <libdariadb/storage/bystep/description.h>
 #include <libdariadb/storage/bystep/step_kind.h>
+#include <libdariadb/storage/cursor.h>
 #include <libdariadb/storage/dropper.h>
+#include <libdariadb/storage/level_catalog.h>
 #include <libdariadb/storage/memstorage/description.h>
 #include <libdariadb/storage/settings.h>
 #include <libdariadb/storage/strategy.h>
@@ -35,13 +37,27 @@ public:
 
   using IMeasStorage::append;
   EXPORT Status append(const Meas &value) override;
+  /// values are grouped by id and written in bulk.
+  EXPORT Status append(const MeasArray::const_iterator &begin,
+                       const MeasArray::const_iterator &end) override;
+  EXPORT Status append(const MeasList::const_iterator &begin,
+                       const MeasList::const_iterator &end) override;
 
   EXPORT void flush() override;
   EXPORT void stop();
   EXPORT Description description() const;
+  /// true - if some level is above its high watermark. writes will wait or be rejected.
+  EXPORT bool overloaded() const;
 
   EXPORT virtual void foreach (const QueryInterval &q, IReaderClb * clbk) override;
   EXPORT virtual MeasList readInterval(const QueryInterval &q) override;
+  /// values are readed on demand, in batches. cursor must be closed (or destroyed)
+  /// before engine: it holds the version of levels, so old pages and wal files
+  /// are not removed, while cursor is open.
+  EXPORT Cursor_Ptr openCursor(const QueryInterval &q,
+                               size_t batch_size = Cursor::DEFAULT_BATCH_SIZE);
+  /// levels, which are readed by query, and levels skipped for each id.
+  EXPORT QueryPlan explain(const QueryInterval &q);
   EXPORT virtual Id2Meas readTimePoint(const QueryTimePoint &q) override;
   EXPORT virtual Id2Meas currentValue(const IdArray &ids, const Flag &flag) override;
   EXPORT virtual void foreach (const QueryTimePoint &q, IReaderClb * clbk) override;
@@ -61,6 +77,9 @@ public:
   EXPORT void fsck();
 
   EXPORT void eraseOld(const Time &t);
+  /// lazy erase of values in [from,to], written before call. values appended
+  /// to that interval later are visible.
+  EXPORT void erase(const IdArray &ids, Time from, Time to);
 
   EXPORT void compactTo(uint32_t pagesCount);
   EXPORT void compactbyTime(Time from, Time to);
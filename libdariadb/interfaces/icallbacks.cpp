@@ -14,6 +14,12 @@ void IReaderClb::is_end() {
   is_end_called = true;
 }
 
+void IReaderClb::call_batch(const Meas *begin, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    call(begin[i]);
+  }
+}
+
 void IReaderClb::wait() {
   // TODO make more smarter.
   while (!is_cancel && !is_end_called) {
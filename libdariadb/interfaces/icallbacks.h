@@ -17,6 +17,8 @@ public:
   EXPORT void cancel();                 // called by user if want to stop operation.
   EXPORT bool is_canceled() const;      // true - if  `cancel` was called.
   virtual void call(const Meas &m) = 0; // must be thread safety.
+  /// n values of one storage block. by default 'call' is called for each value.
+  EXPORT virtual void call_batch(const Meas *begin, size_t n);
 private:
   bool is_end_called;
   bool is_cancel;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <libdariadb/status.h>
 #include <string>
 
 namespace dariadb {
@@ -8,6 +9,8 @@ namespace storage {
 class IWALDropper {
 public:
   virtual void dropWAL(const std::string &fname) = 0;
+  /// wait for free space in drop queue before write to wal.
+  virtual APPEND_ERROR admit() { return APPEND_ERROR::OK; }
   virtual ~IWALDropper() {}
 };
 }
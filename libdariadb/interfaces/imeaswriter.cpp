@@ -15,6 +15,9 @@ Status IMeasWriter::append(const MeasArray::const_iterator &begin,
 
   for (auto it = begin; it != end; ++it) {
     ar = ar + this->append(*it);
+    if (ar.error != APPEND_ERROR::OK) {
+      break;
+    }
   }
   return ar;
 }
@@ -24,6 +27,9 @@ Status IMeasWriter::append(const MeasList::const_iterator &begin,
   dariadb::Status ar{};
   for (auto it = begin; it != end; ++it) {
     ar = ar + this->append(*it);
+    if (ar.error != APPEND_ERROR::OK) {
+      break;
+    }
   }
   return ar;
 }
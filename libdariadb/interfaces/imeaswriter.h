@@ -13,6 +13,8 @@ class IMeasWriter {
 public:
   EXPORT virtual Status append(const Meas &value);
   EXPORT virtual void flush();
+  /// stops on first value rejected by backpressure (Status::error),
+  /// so writed+ignored is a count of processed values.
   EXPORT virtual Status append(const MeasArray::const_iterator &begin,
                                const MeasArray::const_iterator &end);
   EXPORT virtual Status append(const MeasList::const_iterator &begin,
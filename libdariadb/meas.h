@@ -54,7 +54,10 @@ struct Meas {
     return (ids.size() == 0) || (std::count(ids.begin(), ids.end(), id));
   }
 
+  bool inIds(const IdSet &ids) const { return ids.empty() || ids.find(id) != ids.end(); }
+
   bool inQuery(const IdArray &ids, const Flag f) const { return inFlag(f) && inIds(ids); }
+  bool inQuery(const IdSet &ids, const Flag f) const { return inFlag(f) && inIds(ids); }
 
   bool inInterval(Time from, Time to) const { return utils::inInterval(from, to, time); }
 
@@ -1,19 +1,40 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace dariadb {
+/// why values were ignored.
+enum class APPEND_ERROR : uint8_t {
+  OK = 0,
+  OVERLOADED, // storage level is overloaded, rejected without waiting (fail-fast).
+  TIMEOUT,    // storage level is overloaded, timeout of waiting is expired.
+};
+
 struct Status {
   static Status empty() { return Status(); }
-  Status() { writed = ignored = 0; }
+  /// value rejected by backpressure.
+  static Status rejected(APPEND_ERROR err) {
+    Status result(0, 1);
+    result.error = err;
+    result.error_message = err == APPEND_ERROR::TIMEOUT ? "storage is overloaded: timeout"
+                                                        : "storage is overloaded";
+    return result;
+  }
+  Status() {
+    writed = ignored = 0;
+    error = APPEND_ERROR::OK;
+  }
   Status(size_t wr, size_t ig) {
     writed = wr;
     ignored = ig;
+    error = APPEND_ERROR::OK;
   }
   Status(const Status &other) {
     this->writed = other.writed;
     this->ignored = other.ignored;
+    this->error = other.error;
     this->error_message = other.error_message;
   }
 
@@ -21,6 +42,8 @@ struct Status {
     Status res;
     res.writed = writed + other.writed;
     res.ignored = ignored + other.ignored;
+    res.error = error != APPEND_ERROR::OK ? error : other.error;
+    res.error_message = error_message.empty() ? other.error_message : error_message;
     return res;
   }
 
@@ -28,6 +51,7 @@ struct Status {
     if (this != &other) {
       this->writed = other.writed;
       this->ignored = other.ignored;
+      this->error = other.error;
       this->error_message = other.error_message;
     }
     return *this;
@@ -47,6 +71,7 @@ struct Status {
   }
   size_t writed;
   size_t ignored;
+  APPEND_ERROR error;
   std::string error_message;
 };
 }
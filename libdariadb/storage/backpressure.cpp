@@ -0,0 +1,118 @@
+#include <libdariadb/storage/backpressure.h>
+#include <libdariadb/storage/settings.h>
+#include <libdariadb/utils/logger.h>
+#include <chrono>
+
+using namespace dariadb;
+using namespace dariadb::storage;
+
+namespace {
+/// waiting writer wakes up consumer of level with this period.
+const uint64_t KICK_PERIOD = 10; // ms
+}
+
+Backpressure::Params::Params(size_t high_, size_t low_, const Settings *s) {
+  high = high_;
+  low = std::min(low_, high_);
+  timeout = s->write_timeout.value();
+  fail_fast = s->write_fail_fast.value();
+}
+
+Backpressure::Backpressure(const std::string &name, const Params &p)
+    : _name(name), _params(p) {
+  _overloaded = false;
+  _stoped = false;
+  _level = 0;
+  _waits = 0;
+  _rejected = 0;
+  _wait_time = 0;
+}
+
+void Backpressure::update(size_t level) {
+  if (_params.high == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lg(_locker);
+  _level = level;
+  if (!_overloaded.load() && level >= _params.high) {
+    logger_info("engine: ", _name, " - overloaded, fill ", level);
+    _overloaded = true;
+  } else if (_overloaded.load() && level <= _params.low) {
+    logger_info("engine: ", _name, " - resumed, fill ", level);
+    _overloaded = false;
+    _cond.notify_all();
+  }
+}
+
+bool Backpressure::wait_for(const Kick &kick, uint64_t timeout) {
+  auto start = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> ul(_locker);
+  _waits++;
+  bool result = true;
+  while (_overloaded.load() && !_stoped) {
+    auto elapsed = uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                std::chrono::steady_clock::now() - start)
+                                .count());
+    if (timeout != 0 && elapsed >= timeout) {
+      result = false;
+      break;
+    }
+    auto slice = KICK_PERIOD;
+    if (timeout != 0) {
+      slice = std::min(slice, timeout - elapsed);
+    }
+    if (kick != nullptr) {
+      ul.unlock();
+      kick();
+      ul.lock();
+    }
+    _cond.wait_for(ul, std::chrono::milliseconds(slice));
+  }
+  _wait_time += uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(
+                             std::chrono::steady_clock::now() - start)
+                             .count());
+  return result;
+}
+
+APPEND_ERROR Backpressure::admit(const Kick &kick) {
+  if (!_overloaded.load()) {
+    return APPEND_ERROR::OK;
+  }
+  if (_params.fail_fast) {
+    if (kick != nullptr) {
+      kick();
+    }
+    std::lock_guard<std::mutex> lg(_locker);
+    _rejected++;
+    return APPEND_ERROR::OVERLOADED;
+  }
+  if (!wait_for(kick, _params.timeout)) {
+    std::lock_guard<std::mutex> lg(_locker);
+    _rejected++;
+    return APPEND_ERROR::TIMEOUT;
+  }
+  return APPEND_ERROR::OK;
+}
+
+void Backpressure::wait(const Kick &kick) {
+  if (_overloaded.load()) {
+    wait_for(kick, 0);
+  }
+}
+
+void Backpressure::stop() {
+  std::lock_guard<std::mutex> lg(_locker);
+  _stoped = true;
+  _cond.notify_all();
+}
+
+Backpressure::Description Backpressure::description() const {
+  std::lock_guard<std::mutex> lg(_locker);
+  Description result;
+  result.overloaded = _overloaded.load();
+  result.level = _level;
+  result.waits = _waits;
+  result.rejected = _rejected;
+  result.wait_time = _wait_time;
+  return result;
+}
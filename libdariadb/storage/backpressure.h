@@ -0,0 +1,76 @@
+#pragma once
+
+#include <libdariadb/st_exports.h>
+#include <libdariadb/status.h>
+#include <libdariadb/utils/utils.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace dariadb {
+namespace storage {
+
+class Settings;
+/**
+Admission control of one storage level (memstorage, drop queue, bystep queue).
+Level becomes overloaded, when its fill reaches the high watermark, and stays
+overloaded until the fill falls to the low watermark. Writers of overloaded
+level wait (with timeout) or are rejected at once (fail-fast).
+*/
+class Backpressure : public utils::NonCopy {
+public:
+  /// called by waiting writer, to wake up consumer of level.
+  using Kick = std::function<void()>;
+
+  struct Params {
+    size_t high;       // fill, when writers start waiting. 0 - level is unlimited.
+    size_t low;        // fill, when writers are resumed.
+    uint64_t timeout;  // max wait of writer in ms. 0 - without limit.
+    bool fail_fast;    // reject writes at once, while level is overloaded.
+    Params() : high(0), low(0), timeout(0), fail_fast(false) {}
+    /// watermarks of level with timeout and fail-fast from settings.
+    EXPORT Params(size_t high_, size_t low_, const Settings *s);
+  };
+
+  struct Description {
+    bool overloaded;
+    size_t level;       // current fill of level.
+    size_t waits;       // writes, which waited for level.
+    size_t rejected;    // writes, rejected by timeout or fail-fast.
+    uint64_t wait_time; // total time of waiting in ms.
+  };
+
+  EXPORT Backpressure(const std::string &name, const Params &p);
+
+  /// set current fill of level.
+  EXPORT void update(size_t level);
+  /// wait for level to be not overloaded, by timeout and fail-fast of level.
+  EXPORT APPEND_ERROR admit(const Kick &kick = nullptr);
+  /// wait for level to be not overloaded, without limit. for internal writers.
+  EXPORT void wait(const Kick &kick = nullptr);
+  /// wake up all writers. after stop writers are not waiting.
+  EXPORT void stop();
+
+  bool overloaded() const { return _overloaded.load(); }
+  const Params &params() const { return _params; }
+  EXPORT Description description() const;
+
+protected:
+  /// false - if timeout is expired.
+  bool wait_for(const Kick &kick, uint64_t timeout);
+
+  std::string _name;
+  Params _params;
+  std::atomic_bool _overloaded;
+  bool _stoped;
+  size_t _level;
+  size_t _waits;
+  size_t _rejected;
+  uint64_t _wait_time;
+  mutable std::mutex _locker;
+  std::condition_variable _cond;
+};
+}
+}
@@ -3,6 +3,7 @@
 #include <libdariadb/storage/bystep/bysteptrack.h>
 #include <libdariadb/storage/bystep/helpers.h>
 #include <libdariadb/storage/bystep/io_adapter.h>
+#include <libdariadb/storage/callbacks.h>
 #include <libdariadb/storage/chunk.h>
 #include <libdariadb/storage/settings.h>
 #include <libdariadb/timeutil.h>
@@ -27,7 +28,10 @@ struct ByStepStorage::Private : public IMeasStorage {
                        EngineEnvironment::Resource::SETTINGS)) {
     auto fname = utils::fs::append_path(_settings->bystep_path.value(), filename);
     logger_info("engine: opening  bystep storage...");
-    _io = std::make_unique<IOAdapter>(fname);
+    _io = std::make_unique<IOAdapter>(
+        fname, Backpressure::Params(size_t(_settings->bystep_queue_high.value()),
+                                    size_t(_settings->bystep_queue_low.value()),
+                                    _settings));
     logger_info("engine: bystep storage file opened.");
   }
 
@@ -78,6 +82,10 @@ struct ByStepStorage::Private : public IMeasStorage {
       logger_fatal("engine: bystep - write values id:", value.id, " with unknow step.");
       return Status(0, 1);
     }
+    auto err = _io->admit();
+    if (err != APPEND_ERROR::OK) {
+      return Status::rejected(err);
+    }
 
     auto vals_per_interval = bystep::step_to_size(stepKind_it->second);
     auto period_num =
@@ -271,17 +279,19 @@ struct ByStepStorage::Private : public IMeasStorage {
     auto values_size = bystep::step_to_size(step);
     auto zero_time = ByStepTrack::get_zero_time(period, step);
     auto v = Meas::empty(meas_id);
+    ReaderClb_Batch batch(clbk);
     for (size_t meas_num = 0; meas_num < values_size; ++meas_num) {
       v.time = zero_time;
       v.flag = Flags::_NO_DATA;
       zero_time += stepTime;
       if (v.time >= q.from && v.time < q.to) {
-        clbk->call(v);
+        batch.append(v);
       }
     }
   }
 
   void foreach_chunk(const QueryInterval &q, IReaderClb *clbk, const Chunk_Ptr &c) {
+    ReaderClb_Batch batch(clbk);
     auto rdr = c->getReader();
     while (!rdr->is_end()) {
       auto v = rdr->readNext();
@@ -289,7 +299,7 @@ struct ByStepStorage::Private : public IMeasStorage {
         if (!v.inFlag(q.flag)) {
           v.flag = Flags::_NO_DATA;
         }
-        clbk->call(v);
+        batch.append(v);
       }
     }
   }
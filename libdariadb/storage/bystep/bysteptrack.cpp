@@ -1,5 +1,6 @@
 #include <libdariadb/flags.h>
 #include <libdariadb/storage/bystep/bysteptrack.h>
+#include <libdariadb/storage/callbacks.h>
 #include <libdariadb/storage/bystep/helpers.h>
 
 #include <cstring>
@@ -129,13 +130,14 @@ void ByStepTrack::foreach (const QueryInterval &q, IReaderClb * clbk) {
   if (std::find(q.ids.begin(), q.ids.end(), _target_id) == q.ids.end()) {
     return;
   }
+  ReaderClb_Batch batch(clbk);
   for (size_t i = 0; i < _values.size(); ++i) {
     auto v = _values[i];
     if (v.time >= q.from && v.time < q.to) {
       if (!v.inFlag(q.flag)) {
         v.flag = Flags::_NO_DATA;
       }
-      clbk->call(v);
+      batch.append(v);
     }
   }
 }
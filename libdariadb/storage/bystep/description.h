@@ -1,11 +1,14 @@
 #pragma once
 
+#include <libdariadb/storage/backpressure.h>
+
 namespace dariadb {
 namespace storage {
 namespace bystep {
 
 struct Description {
   size_t in_queue;
+  Backpressure::Description backpressure;
 };
 }
 }
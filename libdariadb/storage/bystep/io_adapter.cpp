@@ -27,16 +27,22 @@ const char *BYSTEP_CREATE_SQL = "PRAGMA page_size = 4096;"
                                 "chunk_header blob,"
                                 "chunk_buffer blob);";
 
-class IOAdapter::Private {
-  // TODO move to settings.
-  const size_t MAX_QUEUE_SIZE = 1024;
+namespace {
+/// queue size, when the level is not limited by watermarks.
+const size_t DEFAULT_QUEUE_SIZE = 1024;
+/// period of waking up the write thread by waiting writer.
+const std::chrono::milliseconds KICK_PERIOD(10);
+}
 
+class IOAdapter::Private {
 public:
-  Private(const std::string &fname) {
+  Private(const std::string &fname, const Backpressure::Params &bp)
+      : _backpressure("bystep", bp) {
+    _queue_size = bp.high != 0 ? bp.high : DEFAULT_QUEUE_SIZE;
     _chunks_pos = 0;
     _chunks_pos_drop = 0;
-    _chunks_list = new ChunkMinMax[MAX_QUEUE_SIZE];
-    _chunks_list_drop = new ChunkMinMax[MAX_QUEUE_SIZE];
+    _chunks_list = new ChunkMinMax[_queue_size];
+    _chunks_list_drop = new ChunkMinMax[_queue_size];
     _db = nullptr;
     logger("engine: io_adapter - open ", fname);
     int rc = sqlite3_open(fname.c_str(), &_db);
@@ -54,6 +60,7 @@ public:
   void stop() {
     if (_db != nullptr) {
       flush();
+      _backpressure.stop();
       _stop_flag = true;
       while (!_is_stoped) {
         _cond_var.notify_all();
@@ -77,20 +84,20 @@ public:
     cmm.ch = ch;
     cmm.min = min;
     cmm.max = max;
-    while (true) {
-      _chunks_list_locker.lock();
-      if (_chunks_pos < MAX_QUEUE_SIZE) {
-        _chunks_list[_chunks_pos] = cmm;
-        _chunks_pos++;
-        _chunks_list_locker.unlock();
-        _cond_var.notify_all();
-        break;
-      } else {
-        _chunks_list_locker.unlock();
-        _cond_var.notify_all();
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-      }
+    std::unique_lock<std::mutex> lock(_chunks_list_locker);
+    while (_chunks_pos >= _queue_size) { // chunk is already packed - wait, not reject.
+      _cond_var.notify_all();
+      _space_cond.wait_for(lock, KICK_PERIOD);
     }
+    _chunks_list[_chunks_pos] = cmm;
+    _chunks_pos++;
+    _backpressure.update(_chunks_pos);
+    lock.unlock();
+    _cond_var.notify_all();
+  }
+
+  APPEND_ERROR admit() {
+    return _backpressure.admit([this]() { _cond_var.notify_all(); });
   }
 
   void _append(const Chunk_Ptr &ch, Time min, Time max) {
@@ -460,7 +467,7 @@ public:
 
       bool not_full = false;
       while (!_dropper_locker.try_lock()) {
-        if (_chunks_pos < MAX_QUEUE_SIZE) {
+        if (_chunks_pos < _queue_size) {
           not_full = true;
           break;
         }
@@ -475,7 +482,9 @@ public:
         std::swap(_chunks_list, _chunks_list_drop);
         _chunks_pos_drop = _chunks_pos;
         _chunks_pos = 0;
+        _backpressure.update(_chunks_pos);
         lock.unlock();
+        _space_cond.notify_all();
 
         auto start_time = clock();
         while (true) { // try drop disk, while not success.
@@ -498,7 +507,11 @@ public:
         for (size_t i = 0; i < _chunks_pos_drop; ++i) {
           _chunks_list_drop[i].ch = nullptr;
         }
-        _chunks_pos_drop = 0;
+        {
+          std::lock_guard<std::mutex> lg(_chunks_list_locker);
+          _chunks_pos_drop = 0;
+        }
+        _space_cond.notify_all();
         auto end = clock();
         auto elapsed = double(end - start_time) / CLOCKS_PER_SEC;
 
@@ -514,15 +527,10 @@ public:
 
   void flush() {
     logger_info("engine: io_adapter - flush start.");
-    while (true) { // TODO make more smarter.
-      _chunks_list_locker.lock();
-      auto is_empty = (_chunks_pos + _chunks_pos_drop) == 0;
-      _chunks_list_locker.unlock();
-      if (is_empty) {
-        break;
-      }
+    std::unique_lock<std::mutex> lock(_chunks_list_locker);
+    while ((_chunks_pos + _chunks_pos_drop) != 0) {
       _cond_var.notify_all();
-      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      _space_cond.wait_for(lock, KICK_PERIOD);
     }
     logger_info("engine: io_adapter - flush end.");
   }
@@ -532,6 +540,7 @@ public:
     _chunks_list_locker.lock();
     result.in_queue = _chunks_pos + _chunks_pos_drop;
     _chunks_list_locker.unlock();
+    result.backpressure = _backpressure.description();
     return result;
   }
 
@@ -564,6 +573,7 @@ public:
   sqlite3 *_db;
   bool _is_stoped;
   bool _stop_flag;
+  size_t _queue_size;
   // in queue
   ChunkMinMax *_chunks_list;
   size_t _chunks_pos;
@@ -572,11 +582,14 @@ public:
   size_t _chunks_pos_drop;
   std::mutex _chunks_list_locker;
   std::condition_variable _cond_var;
+  std::condition_variable _space_cond; // queue was swapped or dropped.
   std::mutex _dropper_locker;
   std::thread _write_thread;
+  Backpressure _backpressure;
 };
 
-IOAdapter::IOAdapter(const std::string &fname) : _impl(new IOAdapter::Private(fname)) {}
+IOAdapter::IOAdapter(const std::string &fname, const Backpressure::Params &bp)
+    : _impl(new IOAdapter::Private(fname, bp)) {}
 
 IOAdapter::~IOAdapter() {
   _impl = nullptr;
@@ -590,6 +603,10 @@ void IOAdapter::append(const Chunk_Ptr &ch, Time min, Time max) {
   _impl->append(ch, min, max);
 }
 
+APPEND_ERROR IOAdapter::admit() {
+  return _impl->admit();
+}
+
 ChunksList IOAdapter::readInterval(uint64_t period_from, uint64_t period_to, Id meas_id) {
   return _impl->readInterval(period_from, period_to, meas_id);
 }
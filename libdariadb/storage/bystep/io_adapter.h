@@ -2,6 +2,7 @@
 
 #include <libdariadb/interfaces/imeasstorage.h>
 #include <libdariadb/st_exports.h>
+#include <libdariadb/storage/backpressure.h>
 #include <libdariadb/storage/bystep/description.h>
 #include <libdariadb/storage/chunk.h>
 #include <list>
@@ -12,12 +13,16 @@ namespace storage {
 using ChunksList = std::list<Chunk_Ptr>;
 class IOAdapter {
 public:
-  EXPORT IOAdapter(const std::string &fname);
+  /// bp.high - size of write queue.
+  EXPORT IOAdapter(const std::string &fname,
+                   const Backpressure::Params &bp = Backpressure::Params());
   EXPORT ~IOAdapter();
   EXPORT bystep::Description description();
   EXPORT void stop();
   /// min/max - real min/max values. chunk can be not filled.
   EXPORT void append(const Chunk_Ptr &ch, Time min, Time max);
+  /// wait for free space in write queue before new value.
+  EXPORT APPEND_ERROR admit();
   EXPORT ChunksList readInterval(uint64_t period_from, uint64_t period_to, Id meas_id);
   EXPORT Chunk_Ptr readTimePoint(uint64_t period, Id meas_id);
   EXPORT Id2Meas currentValue();
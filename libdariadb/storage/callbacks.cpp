@@ -9,3 +9,62 @@ void MList_ReaderClb::call(const Meas &m) {
   std::lock_guard<utils::async::Locker> lg(_locker);
   mlist.push_back(m);
 }
+
+void MList_ReaderClb::call_batch(const Meas *begin, size_t n) {
+  std::lock_guard<utils::async::Locker> lg(_locker);
+  mlist.insert(mlist.end(), begin, begin + n);
+}
+
+IdFanOut_ReaderClb::IdFanOut_ReaderClb(IReaderClb *target_) : target(target_) {}
+
+void IdFanOut_ReaderClb::call(const Meas &m) {
+  if (target != nullptr && target->is_canceled()) {
+    this->cancel();
+    return;
+  }
+  std::lock_guard<utils::async::Locker> lg(_locker);
+  auto limit = limits.find(m.id);
+  if (limit != limits.end() && m.time > limit->second) {
+    return;
+  }
+  values[m.id].push_back(m);
+}
+
+void IdFanOut_ReaderClb::call_batch(const Meas *begin, size_t n) {
+  if (target != nullptr && target->is_canceled()) {
+    this->cancel();
+    return;
+  }
+  std::lock_guard<utils::async::Locker> lg(_locker);
+  // values of batch are usually of one id.
+  MeasArray *last_values = nullptr;
+  Id last_id = 0;
+  for (auto it = begin; it != begin + n; ++it) {
+    auto limit = limits.find(it->id);
+    if (limit != limits.end() && it->time > limit->second) {
+      continue;
+    }
+    if (last_values == nullptr || last_id != it->id) {
+      last_id = it->id;
+      last_values = &values[last_id];
+    }
+    last_values->push_back(*it);
+  }
+}
+
+void IdFanOut_ReaderClb::setLimit(Id id, Time to) {
+  std::lock_guard<utils::async::Locker> lg(_locker);
+  limits[id] = to;
+}
+
+void IdFanOut_ReaderClb::send(Id id) {
+  std::lock_guard<utils::async::Locker> lg(_locker);
+  auto fres = values.find(id);
+  if (fres == values.end()) {
+    return;
+  }
+  if (!target->is_canceled() && !fres->second.empty()) {
+    target->call_batch(fres->second.data(), fres->second.size());
+  }
+  values.erase(fres);
+}
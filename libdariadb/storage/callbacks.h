@@ -4,18 +4,70 @@
 #include <libdariadb/meas.h>
 #include <libdariadb/st_exports.h>
 #include <libdariadb/utils/async/locker.h>
+#include <libdariadb/utils/utils.h>
 #include <condition_variable>
 #include <memory>
+#include <unordered_map>
 
 namespace dariadb {
 namespace storage {
 
+/// collects values of storage level and sends them to callback by batches.
+class ReaderClb_Batch : public utils::NonCopy {
+public:
+  static const size_t DEFAULT_CAPACITY = 512;
+
+  ReaderClb_Batch(IReaderClb *clbk, size_t capacity = DEFAULT_CAPACITY)
+      : _clbk(clbk), _capacity(capacity) {
+    _values.reserve(_capacity);
+  }
+  ~ReaderClb_Batch() { flush(); }
+
+  void append(const Meas &m) {
+    _values.push_back(m);
+    if (_values.size() == _capacity) {
+      flush();
+    }
+  }
+
+  void flush() {
+    if (!_values.empty()) {
+      _clbk->call_batch(_values.data(), _values.size());
+      _values.clear();
+    }
+  }
+
+protected:
+  IReaderClb *_clbk;
+  size_t _capacity;
+  MeasArray _values;
+};
+
 struct MList_ReaderClb : public IReaderClb {
   EXPORT MList_ReaderClb();
   EXPORT void call(const Meas &m) override;
+  EXPORT void call_batch(const Meas *begin, size_t n) override;
 
   MeasList mlist;
   utils::async::Locker _locker;
 };
+
+/// routes values of one multi-id scan to per-id buffers.
+struct IdFanOut_ReaderClb : public IReaderClb {
+  /// target - receiver of values in 'send' call. can be nullptr, if 'values' are
+  /// taken directly.
+  EXPORT IdFanOut_ReaderClb(IReaderClb *target);
+  EXPORT void call(const Meas &m) override;
+  EXPORT void call_batch(const Meas *begin, size_t n) override;
+  /// values of 'id' with time greater than 'to' will be skipped.
+  EXPORT void setLimit(Id id, Time to);
+  /// send all buffered values of 'id' to target.
+  EXPORT void send(Id id);
+
+  std::unordered_map<Id, MeasArray> values;
+  std::unordered_map<Id, Time> limits;
+  IReaderClb *target;
+  utils::async::Locker _locker;
+};
 }
 }
@@ -161,8 +161,12 @@ public:
 };
 
 Chunk::ChunkReader_Ptr Chunk::getReader() {
+  return getReader(this->header->count);
+}
+
+Chunk::ChunkReader_Ptr Chunk::getReader(uint32_t count) {
   auto raw_res = new ChunkReader;
-  raw_res->count = this->header->count;
+  raw_res->count = count;
   raw_res->_chunk = this->shared_from_this();
   raw_res->_is_first = true;
   raw_res->bw = std::make_shared<compression::ByteBuffer>(this->bw->get_range());
@@ -92,6 +92,8 @@ public:
   EXPORT bool append(const Meas &m);
   EXPORT bool isFull() const;
   EXPORT ChunkReader_Ptr getReader();
+  /// reader of first value and 'count' values after it.
+  EXPORT ChunkReader_Ptr getReader(uint32_t count);
   EXPORT void close();
   EXPORT uint32_t calcChecksum();
   EXPORT uint32_t getChecksum();
@@ -0,0 +1,43 @@
+#include <libdariadb/storage/cursor.h>
+#include <algorithm>
+
+using namespace dariadb;
+using namespace dariadb::storage;
+
+Cursor_Ptr Cursor::create(const std::vector<IdArray> &groups, size_t batch_size,
+                          const Reader &reader) {
+  return Cursor_Ptr{new Cursor(groups, batch_size, reader)};
+}
+
+Cursor::Cursor(const std::vector<IdArray> &groups, size_t batch_size,
+               const Reader &reader)
+    : _groups(groups), _group_pos(0), _batch_size(std::max(batch_size, size_t(1))),
+      _reader(reader), _buffer_pos(0) {}
+
+Cursor::~Cursor() {
+  close();
+}
+
+bool Cursor::next(MeasBatch *batch) {
+  while (_buffer_pos == _buffer.size()) {
+    if (is_closed() || _group_pos == _groups.size()) {
+      close();
+      return false;
+    }
+    _buffer.clear();
+    _buffer_pos = 0;
+    _reader(_groups[_group_pos++], _buffer);
+  }
+  batch->data = _buffer.data() + _buffer_pos;
+  batch->size = std::min(_batch_size, _buffer.size() - _buffer_pos);
+  _buffer_pos += batch->size;
+  return true;
+}
+
+void Cursor::close() {
+  // reader holds pinned version of levels.
+  _reader = nullptr;
+  _buffer.clear();
+  _buffer.shrink_to_fit();
+  _buffer_pos = 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <libdariadb/meas.h>
+#include <libdariadb/st_exports.h>
+#include <libdariadb/storage/query_param.h>
+#include <libdariadb/utils/utils.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace dariadb {
+namespace storage {
+
+/// view of values, owned by cursor. valid until next call of Cursor::next.
+struct MeasBatch {
+  const Meas *data;
+  size_t size;
+
+  MeasBatch() : data(nullptr), size(0) {}
+  const Meas *begin() const { return data; }
+  const Meas *end() const { return data + size; }
+  bool empty() const { return size == 0; }
+  const Meas &operator[](size_t i) const { return data[i]; }
+};
+
+class Cursor;
+using Cursor_Ptr = std::shared_ptr<Cursor>;
+/**
+Pull-based reader of interval query. Values are returned in batches, id by id
+(in order of query ids), sorted by time. Ids are readed by groups, only values
+of one group are kept in memory.
+*/
+class Cursor : public utils::NonCopy {
+public:
+  static const size_t DEFAULT_BATCH_SIZE = 1024;
+  /// reads all values of ids to 'out': id by id in order of 'ids', sorted by time.
+  using Reader = std::function<void(const IdArray &ids, MeasArray &out)>;
+
+  /// groups - ids of query, splitted to groups of one read.
+  EXPORT static Cursor_Ptr create(const std::vector<IdArray> &groups, size_t batch_size,
+                                  const Reader &reader);
+  EXPORT ~Cursor();
+  /// false - if all values are readed or cursor is closed.
+  EXPORT bool next(MeasBatch *batch);
+  /// stop reading. not readed ids are skipped.
+  EXPORT void close();
+  bool is_closed() const { return !_reader; }
+
+protected:
+  Cursor(const std::vector<IdArray> &groups, size_t batch_size, const Reader &reader);
+
+  std::vector<IdArray> _groups;
+  size_t _group_pos;
+  size_t _batch_size;
+  Reader _reader;
+  MeasArray _buffer;
+  size_t _buffer_pos;
+};
+}
+}
@@ -3,7 +3,9 @@
 #include <libdariadb/storage/pages/page.h>
 #include <libdariadb/storage/settings.h>
 #include <libdariadb/utils/async/thread_manager.h>
-#include <ctime>
+#include <libdariadb/utils/radix_sort.h>
+#include <algorithm>
+#include <chrono>
 
 using namespace dariadb;
 using namespace dariadb::storage;
@@ -14,37 +16,71 @@ Dropper::Dropper(EngineEnvironment_ptr engine_env, PageManager_ptr page_manager,
                  WALManager_ptr wal_manager)
     : _page_manager(page_manager), _wal_manager(wal_manager), _engine_env(engine_env) {
   _stop = false;
-  _is_stoped = false;
+  _dropped = 0;
+  _in_work.fill(0);
+  _elapsed.fill(0);
   _settings =
       _engine_env->getResourceObject<Settings>(EngineEnvironment::Resource::SETTINGS);
-  _thread_handle = std::thread(&Dropper::drop_wal_internal, this);
+  _versions = nullptr;
+  if (_engine_env->hasResource(EngineEnvironment::Resource::VERSIONS)) {
+    _versions =
+        _engine_env->getResourceObject<VersionSet>(EngineEnvironment::Resource::VERSIONS);
+  }
+  _tombstones = nullptr;
+  if (_engine_env->hasResource(EngineEnvironment::Resource::TOMBSTONES)) {
+    _tombstones =
+        _engine_env->getResourceObject<Tombstones>(EngineEnvironment::Resource::TOMBSTONES);
+  }
+  _backpressure = std::make_unique<Backpressure>(
+      "dropper", Backpressure::Params(size_t(_settings->wal_drop_queue_high.value()),
+                                      size_t(_settings->wal_drop_queue_low.value()),
+                                      _settings));
+  for (size_t i = 0; i < STAGES_COUNT; ++i) {
+    _threads[i] = std::thread(&Dropper::stage_thread, this, STAGE(i));
+  }
 }
 
 Dropper::~Dropper() {
   logger("engine: dropper - stop begin.");
-  _stop = true;
-  while (!_is_stoped) {
-    _cond_var.notify_all();
+  _backpressure->stop();
+  {
+    std::lock_guard<std::mutex> lg(_queue_locker);
+    _stop = true;
+  }
+  _cond_var.notify_all();
+  for (auto &t : _threads) {
+    t.join();
   }
-  _thread_handle.join();
   logger("engine: dropper - stop end.");
 }
 
 Dropper::Description Dropper::description() const {
   std::lock_guard<std::mutex> lg(_queue_locker);
   Dropper::Description result;
-  result.wal = _files_queue.size();
+  result.wal = _files_queue.size() + _in_pipeline.size();
+  result.dropped = _dropped;
+  for (size_t i = 0; i < STAGES_COUNT; ++i) {
+    result.queue[i] = i == READ ? _files_queue.size() : _stage_queue[i].size();
+    result.elapsed[i] = _elapsed[i];
+  }
+  result.backpressure = _backpressure->description();
   return result;
 }
 
+APPEND_ERROR Dropper::admit() {
+  return _backpressure->admit();
+}
+
 void Dropper::dropWAL(const std::string &fname) {
   std::lock_guard<std::mutex> lg(_queue_locker);
-  if (std::count(_files_queue.begin(), _files_queue.end(), fname)) {
+  if (_in_pipeline.count(fname) != 0 ||
+      std::count(_files_queue.begin(), _files_queue.end(), fname)) {
     return;
   }
   auto storage_path = _settings->raw_path.value();
   if (utils::fs::path_exists(utils::fs::append_path(storage_path, fname))) {
     _files_queue.emplace_back(fname);
+    _backpressure->update(level());
     _cond_var.notify_all();
   }
 }
@@ -53,6 +89,12 @@ void Dropper::cleanStorage(const std::string &storagePath) {
   logger_info("engine: dropper - check storage.");
   auto wals_lst = fs::ls(storagePath, WAL_FILE_EXT);
   auto page_lst = fs::ls(storagePath, PAGE_FILE_EXT);
+  for (auto &partition : fs::ls(storagePath)) {
+    if (fs::is_directory(partition)) {
+      auto partition_pages = fs::ls(partition, PAGE_FILE_EXT);
+      page_lst.insert(page_lst.end(), partition_pages.begin(), partition_pages.end());
+    }
+  }
 
   for (auto &wal : wals_lst) {
     auto wal_fname = fs::filename(wal);
@@ -61,80 +103,157 @@ void Dropper::cleanStorage(const std::string &storagePath) {
       if (page_fname == wal_fname) {
         logger_info("engine: fsck wal drop not finished: ", wal_fname);
         logger_info("engine: fsck rm ", pagef);
-        PageManager::erase(storagePath, fs::extract_filename(pagef));
+        PageManager::erase(fs::parent_path(pagef), fs::extract_filename(pagef));
       }
     }
   }
 }
 
-void Dropper::drop_wal_internal() {
-  auto env = _engine_env;
-  auto sett = _settings;
-  _is_stoped = false;
-  while (!_stop) {
-    std::string fname;
+bool Dropper::can_take(STAGE stage) const {
+  auto input_empty =
+      stage == READ ? _files_queue.empty() : _stage_queue[stage].empty();
+  if (input_empty) {
+    return false;
+  }
+  if (stage == WRITE) {
+    return true;
+  }
+  auto next = stage + 1;
+  return _in_work[stage] + _stage_queue[next].size() < STAGE_QUEUE_CAP;
+}
+
+Dropper::Job_Ptr Dropper::take(STAGE stage) {
+  Job_Ptr result;
+  if (stage == READ) {
+    result = std::make_shared<Job>();
+    result->fname = _files_queue.front();
+    _files_queue.pop_front();
+    _in_pipeline.insert(result->fname);
+  } else {
+    result = _stage_queue[stage].front();
+    _stage_queue[stage].pop_front();
+  }
+  _in_work[stage]++;
+  return result;
+}
+
+void Dropper::stage_thread(STAGE stage) {
+  while (true) {
+    Job_Ptr job;
     {
       std::unique_lock<std::mutex> ul(_queue_locker);
-      _cond_var.wait(ul, [this]() { return !this->_files_queue.empty() || _stop; });
+      _cond_var.wait(ul, [this, stage]() { return _stop || can_take(stage); });
       if (_stop) {
         break;
       }
-      fname = _files_queue.front();
-      _files_queue.pop_front();
-    }
-    while (!this->_dropper_lock.try_lock() || _stop) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    }
-    if (_stop) {
-      break;
+      job = take(stage);
     }
-    AsyncTask at = [fname, this, env, sett](const ThreadInfo &ti) {
-      try {
-        TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
 
-        logger_info("engine: compressing ", fname);
-        auto start_time = clock();
-        auto storage_path = sett->raw_path.value();
-        auto full_path = fs::append_path(storage_path, fname);
+    auto start_time = std::chrono::steady_clock::now();
+    run_stage(stage, *job);
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                                 start_time)
+                       .count();
 
-        WALFile_Ptr wal=WALFile::open(env, full_path, true);
-
-        auto all = wal->readAll();
-
-        this->write_wal_to_page(fname, all);
-
-        auto end = clock();
-        auto elapsed = double(end - start_time) / CLOCKS_PER_SEC;
-
-        logger_info("engine: compressing ", fname, " done. elapsed time - ", elapsed);
-      } catch (std::exception &ex) {
-        THROW_EXCEPTION("Dropper::drop_wal_internal: ", ex.what());
+    {
+      std::lock_guard<std::mutex> lg(_queue_locker);
+      _in_work[stage]--;
+      _elapsed[stage] += elapsed;
+      if (stage == WRITE) {
+        _in_pipeline.erase(job->fname);
+        _dropped++;
+        _backpressure->update(level());
+      } else if (!_stop) {
+        _stage_queue[stage + 1].push_back(job);
       }
-      return false;
-    };
+    }
+    _cond_var.notify_all();
+  }
+}
 
-    auto handle = ThreadManager::instance()->post(THREAD_KINDS::DISK_IO, AT(at));
-    handle->wait();
-    this->_dropper_lock.unlock();
+void Dropper::run_stage(STAGE stage, Job &job) {
+  switch (stage) {
+  case READ:
+    read_wal(job);
+    break;
+  case SORT:
+    utils::radix_sort(*job.values);
+    break;
+  case COMPRESS:
+    job.pages = _page_manager->prepare(*job.values);
+    job.values = nullptr;
+    break;
+  case WRITE:
+    write_wal_to_page(job);
+    break;
+  default:
+    THROW_EXCEPTION("Dropper: unknown stage ", int(stage));
   }
-  _is_stoped = true;
 }
 
-void Dropper::write_wal_to_page(const std::string &fname, std::shared_ptr<MeasArray> ma) {
-  auto pm = _page_manager.get();
-  auto am = _wal_manager.get();
+void Dropper::read_wal(Job &job) {
+  job.tombstones_generation = _tombstones != nullptr ? _tombstones->generation() : 0;
+  auto env = _engine_env;
   auto sett = _settings;
+  AsyncTask at = [&job, env, sett](const ThreadInfo &ti) {
+    try {
+      TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
+      logger_info("engine: compressing ", job.fname);
+      auto storage_path = sett->raw_path.value();
+      auto full_path = fs::append_path(storage_path, job.fname);
 
-  auto storage_path = sett->raw_path.value();
-  auto full_path = fs::append_path(storage_path, fname);
+      WALFile_Ptr wal = WALFile::open(env, full_path, true);
+      job.values = wal->readAll();
+    } catch (std::exception &ex) {
+      THROW_EXCEPTION("Dropper::read_wal: ", ex.what());
+    }
+    return false;
+  };
+  auto handle = ThreadManager::instance()->post(THREAD_KINDS::DISK_IO, AT(at));
+  handle->wait();
+}
 
-  std::sort(ma->begin(), ma->end(), meas_time_compare_less());
+void Dropper::write_wal_to_page(Job &job) {
+  auto pm = _page_manager.get();
+  auto am = _wal_manager.get();
 
-  auto without_path = fs::extract_filename(fname);
+  auto without_path = fs::extract_filename(job.fname);
   auto page_fname = fs::filename(without_path);
 
-  pm->append(page_fname, *ma.get());
-  am->erase(fname);
+  while (!this->_dropper_lock.try_lock()) {
+    if (_stop) {
+      return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  // erase is under dropper lock: values of file, erased after read, are read again.
+  if (_tombstones != nullptr && _tombstones->generation() != job.tombstones_generation) {
+    try {
+      run_stage(READ, job);
+      run_stage(SORT, job);
+      run_stage(COMPRESS, job);
+    } catch (...) {
+      this->_dropper_lock.unlock();
+      throw;
+    }
+  }
+  auto versions = _versions;
+  AsyncTask at = [&job, &page_fname, pm, am, versions](const ThreadInfo &ti) {
+    try {
+      TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
+      // readers see values of file in wal or in page, not in both.
+      VersionSet::Edit edit(versions);
+      pm->append(page_fname, job.pages);
+      am->erase(job.fname);
+      logger_info("engine: compressing ", job.fname, " done.");
+    } catch (std::exception &ex) {
+      THROW_EXCEPTION("Dropper::write_wal_to_page: ", ex.what());
+    }
+    return false;
+  };
+  auto handle = ThreadManager::instance()->post(THREAD_KINDS::DISK_IO, AT(at));
+  handle->wait();
+  this->_dropper_lock.unlock();
 }
 
 void Dropper::flush() {
@@ -1,26 +1,42 @@
 #pragma once
 
+#include <libdariadb/storage/backpressure.h>
 #include <libdariadb/storage/engine_environment.h>
 #include <libdariadb/storage/pages/page_manager.h>
+#include <libdariadb/storage/tombstones.h>
+#include <libdariadb/storage/version_set.h>
 #include <libdariadb/storage/wal/wal_manager.h>
+#include <array>
 #include <condition_variable>
 #include <list>
 #include <mutex>
+#include <set>
 #include <string>
 #include <thread>
 
 namespace dariadb {
 namespace storage {
 
+/// wal files are dropped to pages by pipeline: read -> sort -> compress -> write.
+/// each stage has own thread, queues between stages are bounded.
 class Dropper : public dariadb::storage::IWALDropper {
 public:
+  enum STAGE { READ = 0, SORT, COMPRESS, WRITE, STAGES_COUNT };
+  /// max count of files in a stage queue and in work of previous stage.
+  static const size_t STAGE_QUEUE_CAP = 2;
+
   struct Description {
-    size_t wal;
+    size_t wal;     // files in queue and in pipeline.
+    size_t dropped; // files written to pages.
+    size_t queue[STAGES_COUNT];  // input queue depth of each stage.
+    double elapsed[STAGES_COUNT]; // total time of each stage (sec).
+    Backpressure::Description backpressure;
   };
   Dropper(EngineEnvironment_ptr engine_env, PageManager_ptr page_manager,
           WALManager_ptr wal_manager);
   ~Dropper();
   void dropWAL(const std::string &fname) override;
+  APPEND_ERROR admit() override;
 
   void flush();
   // 1. rm PAGE files with name exists WAL file.
@@ -30,21 +46,42 @@ public:
   std::mutex *getLocker() { return &_dropper_lock; }
 
 private:
-  void drop_wal_internal();
-  void write_wal_to_page(const std::string &fname, std::shared_ptr<MeasArray> ma);
+  struct Job {
+    std::string fname;
+    std::shared_ptr<MeasArray> values;
+    PageManager::PreparedPages pages;
+    uint64_t tombstones_generation; // erased values are skipped by read.
+  };
+  using Job_Ptr = std::shared_ptr<Job>;
+
+  void stage_thread(STAGE stage);
+  bool can_take(STAGE stage) const;
+  /// files in queue and in pipeline. under _queue_locker.
+  size_t level() const { return _files_queue.size() + _in_pipeline.size(); }
+  Job_Ptr take(STAGE stage);
+  void run_stage(STAGE stage, Job &job);
+  void read_wal(Job &job);
+  void write_wal_to_page(Job &job);
 
 private:
   mutable std::mutex _queue_locker;
   std::list<std::string> _files_queue;
+  std::set<std::string> _in_pipeline;
+  std::array<std::list<Job_Ptr>, STAGES_COUNT> _stage_queue; // READ queue is unused.
+  std::array<size_t, STAGES_COUNT> _in_work;
+  std::array<double, STAGES_COUNT> _elapsed;
+  size_t _dropped;
   bool _stop;
-  bool _is_stoped;
   std::condition_variable _cond_var;
-  std::thread _thread_handle;
+  std::array<std::thread, STAGES_COUNT> _threads;
   PageManager_ptr _page_manager;
   WALManager_ptr _wal_manager;
   EngineEnvironment_ptr _engine_env;
   Settings *_settings;
+  VersionSet *_versions;
+  Tombstones *_tombstones;
   std::mutex _dropper_lock;
+  std::unique_ptr<Backpressure> _backpressure;
 };
 }
 }
@@ -14,7 +14,10 @@ public:
   enum class Resource {
     // LOCK_MANAGER,
     SETTINGS,
-    MANIFEST
+    MANIFEST,
+    TOMBSTONES,
+    VERSIONS,
+    CATALOG
   };
 
 public:
@@ -23,6 +26,7 @@ public:
 
   EXPORT void addResource(Resource res, void *ptr);
   EXPORT void *getResourcePtr(Resource res) const;
+  EXPORT bool hasResource(Resource res) const;
 
   template <class T> T *getResourceObject(Resource res) const {
     return (T *)getResourcePtr(res);
@@ -0,0 +1,143 @@
+#include <libdariadb/storage/last_value_table.h>
+#include <cstring>
+#include <thread>
+
+using namespace dariadb;
+using namespace dariadb::storage;
+
+namespace {
+uint64_t value2bits(dariadb::Value v) {
+  uint64_t result;
+  static_assert(sizeof(result) == sizeof(v), "sizeof(Value)!=sizeof(uint64_t)");
+  memcpy(&result, &v, sizeof(v));
+  return result;
+}
+
+dariadb::Value bits2value(uint64_t bits) {
+  dariadb::Value result;
+  memcpy(&result, &bits, sizeof(bits));
+  return result;
+}
+}
+
+LastValueTable::Cell::Cell() : seq(0), exists(false), time(MIN_TIME), value(0), flag(0) {}
+
+LastValueTable::LastValueTable(size_t reserve) : _cells(reserve) {}
+
+LastValueTable::~LastValueTable() {}
+
+LastValueTable::Cell *LastValueTable::get_or_insert(Id id) {
+  auto exists = _cells.find(id);
+  if (exists != nullptr) {
+    return exists;
+  }
+  return _cells.insert(id, []() { return std::make_shared<Cell>(); });
+}
+
+void LastValueTable::write(Cell *c, const Meas &m, WRITE_MODE mode) {
+  // older value is dropped without taking of seqlock.
+  if (mode == WRITE_MODE::MAX && c->exists.load(std::memory_order_relaxed) &&
+      m.time <= c->time.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  auto seq = c->seq.load(std::memory_order_relaxed);
+  while (true) {
+    if ((seq & 1) != 0) {
+      std::this_thread::yield();
+      seq = c->seq.load(std::memory_order_relaxed);
+      continue;
+    }
+    if (c->seq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire,
+                                     std::memory_order_relaxed)) {
+      break;
+    }
+  }
+  std::atomic_thread_fence(std::memory_order_release);
+
+  auto exists = c->exists.load(std::memory_order_relaxed);
+  switch (mode) {
+  case WRITE_MODE::MAX:
+    if (exists && m.time <= c->time.load(std::memory_order_relaxed)) {
+      break;
+    }
+  // fallthrough
+  case WRITE_MODE::SET:
+    c->time.store(m.time, std::memory_order_relaxed);
+    c->value.store(value2bits(m.value), std::memory_order_relaxed);
+    c->flag.store(m.flag, std::memory_order_relaxed);
+    c->exists.store(true, std::memory_order_relaxed);
+    break;
+  case WRITE_MODE::ERASE:
+    c->exists.store(false, std::memory_order_relaxed);
+    break;
+  }
+
+  c->seq.store(seq + 2, std::memory_order_release);
+}
+
+bool LastValueTable::read(const Cell *c, Id id, Meas *output) {
+  while (true) {
+    auto seq = c->seq.load(std::memory_order_acquire);
+    if ((seq & 1) != 0) {
+      std::this_thread::yield();
+      continue;
+    }
+    auto exists = c->exists.load(std::memory_order_relaxed);
+    auto time = c->time.load(std::memory_order_relaxed);
+    auto value = c->value.load(std::memory_order_relaxed);
+    auto flag = c->flag.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (c->seq.load(std::memory_order_relaxed) != seq) {
+      continue;
+    }
+    if (exists) {
+      output->id = id;
+      output->time = time;
+      output->value = bits2value(value);
+      output->flag = flag;
+    }
+    return exists;
+  }
+}
+
+void LastValueTable::updateMax(const Meas &m) {
+  write(get_or_insert(m.id), m, WRITE_MODE::MAX);
+}
+
+void LastValueTable::set(const Meas &m) {
+  write(get_or_insert(m.id), m, WRITE_MODE::SET);
+}
+
+void LastValueTable::erase(Id id) {
+  auto cell = _cells.find(id);
+  if (cell != nullptr) {
+    write(cell, Meas::empty(id), WRITE_MODE::ERASE);
+  }
+}
+
+bool LastValueTable::find(Id id, Meas *output) const {
+  auto cell = _cells.find(id);
+  return cell != nullptr && read(cell, id, output);
+}
+
+void LastValueTable::foreach (const std::function<void(const Meas &)> &f) const {
+  Meas m;
+  _cells.foreach ([&f, &m](Id id, Cell *c) {
+    if (read(c, id, &m)) {
+      f(m);
+    }
+  });
+}
+
+size_t LastValueTable::size() const {
+  return _cells.size();
+}
+
+void LastValueTable::load(const Id2MinMax &mm) {
+  for (auto &kv : mm) {
+    auto m = kv.second.max;
+    m.id = kv.first;
+    updateMax(m);
+  }
+}
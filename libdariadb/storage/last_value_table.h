@@ -0,0 +1,56 @@
+#pragma once
+
+#include <libdariadb/meas.h>
+#include <libdariadb/st_exports.h>
+#include <libdariadb/utils/sharded_id_map.h>
+#include <atomic>
+#include <functional>
+
+namespace dariadb {
+namespace storage {
+
+/// Id -> last (max by time) value, ids are sharded by utils::ShardedIdMap.
+/// each value is guarded by own seqlock, so writers of different ids
+/// do not contend and readers never block writers.
+class LastValueTable : public utils::NonCopy {
+public:
+  EXPORT LastValueTable(size_t reserve = 0);
+  EXPORT ~LastValueTable();
+
+  /// set value of m.id, if m is newer than stored one.
+  EXPORT void updateMax(const Meas &m);
+  /// replace value of m.id unconditionally.
+  EXPORT void set(const Meas &m);
+  /// forget value of id. slot is kept and reused by next update.
+  EXPORT void erase(Id id);
+  /// false - if id has no value.
+  EXPORT bool find(Id id, Meas *output) const;
+  /// call f for each stored value. values added concurrently may be skipped.
+  EXPORT void foreach (const std::function<void(const Meas &)> &f) const;
+  /// count of known ids, erased ones too.
+  EXPORT size_t size() const;
+  /// not thread-safe.
+  EXPORT void load(const Id2MinMax &mm);
+
+protected:
+  /// seqlock: odd seq - writer is in progress.
+  struct Cell {
+    Cell();
+    std::atomic<uint64_t> seq;
+    std::atomic<bool> exists;
+    std::atomic<Time> time;
+    std::atomic<uint64_t> value; // bits of dariadb::Value
+    std::atomic<Flag> flag;
+  };
+
+  enum class WRITE_MODE { MAX, SET, ERASE };
+
+  Cell *get_or_insert(Id id);
+  static void write(Cell *c, const Meas &m, WRITE_MODE mode);
+  /// false - if value not exists.
+  static bool read(const Cell *c, Id id, Meas *output);
+
+  utils::ShardedIdMap<Cell> _cells;
+};
+}
+}
@@ -0,0 +1,123 @@
+#include <libdariadb/storage/level_catalog.h>
+#include <mutex>
+#include <sstream>
+
+using namespace dariadb;
+using namespace dariadb::storage;
+
+namespace {
+void atomic_min(std::atomic<Time> &target, Time value) {
+  auto cur = target.load(std::memory_order_relaxed);
+  while (value < cur && !target.compare_exchange_weak(cur, value)) {
+  }
+}
+
+void atomic_max(std::atomic<Time> &target, Time value) {
+  auto cur = target.load(std::memory_order_relaxed);
+  while (value > cur && !target.compare_exchange_weak(cur, value)) {
+  }
+}
+
+void ids_to_stream(std::ostream &stream, const IdArray &ids) {
+  stream << ids.size() << " [";
+  for (size_t i = 0; i < ids.size(); ++i) {
+    stream << (i == 0 ? "" : " ") << ids[i];
+  }
+  stream << "]";
+}
+}
+
+std::string dariadb::storage::to_string(const LEVEL &l) {
+  switch (l) {
+  case LEVEL::PAGES:
+    return "pages";
+  case LEVEL::WAL:
+    return "wal";
+  case LEVEL::MEMORY:
+    return "memory";
+  }
+  return "unknow";
+}
+
+LevelCatalog::Bounds::Bounds() {
+  for (size_t i = 0; i < LEVELS_COUNT; ++i) {
+    minTime[i].store(MAX_TIME);
+    maxTime[i].store(MIN_TIME);
+  }
+}
+
+LevelCatalog::LevelCatalog() : _shards(new Shard[SHARDS]), _complete(true) {}
+
+LevelCatalog::~LevelCatalog() {}
+
+LevelCatalog::Bounds *LevelCatalog::find(Id id) const {
+  auto &s = shard(id);
+  std::shared_lock<std::shared_mutex> lg(s.locker);
+  auto it = s.bounds.find(id);
+  // elements of unordered_map are not moved on rehash.
+  return it == s.bounds.end() ? nullptr : &it->second;
+}
+
+void LevelCatalog::extend(LEVEL l, Id id, Time minTime, Time maxTime) {
+  auto b = find(id);
+  if (b == nullptr) {
+    auto &s = shard(id);
+    std::lock_guard<std::shared_mutex> lg(s.locker);
+    b = &s.bounds[id];
+  }
+  atomic_min(b->minTime[size_t(l)], minTime);
+  atomic_max(b->maxTime[size_t(l)], maxTime);
+}
+
+void LevelCatalog::extend(LEVEL l, const Id2MinMax &mm) {
+  for (auto &kv : mm) {
+    extend(l, kv.first, kv.second.min.time, kv.second.max.time);
+  }
+}
+
+bool LevelCatalog::minMaxTime(LEVEL l, Id id, Time *minResult, Time *maxResult) const {
+  auto b = find(id);
+  if (b == nullptr) {
+    return false;
+  }
+  auto minTime = b->minTime[size_t(l)].load();
+  auto maxTime = b->maxTime[size_t(l)].load();
+  if (minTime > maxTime) {
+    return false;
+  }
+  *minResult = minTime;
+  *maxResult = maxTime;
+  return true;
+}
+
+bool LevelCatalog::intersects(LEVEL l, Id id, Time from, Time to) const {
+  if (!complete()) {
+    return true;
+  }
+  Time minTime, maxTime;
+  if (!minMaxTime(l, id, &minTime, &maxTime)) {
+    return false;
+  }
+  return minTime <= to && from <= maxTime;
+}
+
+std::string QueryPlan::to_string() const {
+  std::stringstream ss;
+  for (size_t i = 0; i < LEVELS_COUNT; ++i) {
+    auto &l = levels[i];
+    if (!l.exists) {
+      continue;
+    }
+    ss << storage::to_string(LEVEL(i)) << ": scan ";
+    ids_to_stream(ss, l.scan);
+    ss << ", pruned ";
+    ids_to_stream(ss, l.pruned);
+    ss << std::endl;
+  }
+  if (!bystep.empty()) {
+    ss << "bystep: scan ";
+    ids_to_stream(ss, bystep);
+    ss << std::endl;
+  }
+  return ss.str();
+}
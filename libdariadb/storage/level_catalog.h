@@ -0,0 +1,83 @@
+#pragma once
+
+#include <libdariadb/meas.h>
+#include <libdariadb/st_exports.h>
+#include <libdariadb/utils/utils.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace dariadb {
+namespace storage {
+
+enum class LEVEL : uint8_t { PAGES = 0, WAL, MEMORY };
+const size_t LEVELS_COUNT = 3;
+
+EXPORT std::string to_string(const LEVEL &l);
+
+/**
+Per id time bounds of values on storage levels.
+Bounds are only extended: after drop, erase or compaction they can be wider than
+values on level, but never narrower. So level, which bounds do not intersect
+the query interval, has no values of query.
+*/
+class LevelCatalog : public utils::NonCopy {
+public:
+  static const size_t SHARDS = 16;
+
+  EXPORT LevelCatalog();
+  EXPORT ~LevelCatalog();
+
+  EXPORT void extend(LEVEL l, Id id, Time minTime, Time maxTime);
+  void extend(LEVEL l, const Meas &m) { extend(l, m.id, m.time, m.time); }
+  EXPORT void extend(LEVEL l, const Id2MinMax &mm);
+  /// false - if level has no values of id.
+  EXPORT bool minMaxTime(LEVEL l, Id id, Time *minResult, Time *maxResult) const;
+  /// true - if level can contain values of id in [from, to].
+  /// not complete catalog always returns true.
+  EXPORT bool intersects(LEVEL l, Id id, Time from, Time to) const;
+
+  /// catalog is complete, when bounds of all values on levels are loaded.
+  void setComplete(bool value) { _complete.store(value); }
+  bool complete() const { return _complete.load(); }
+
+protected:
+  struct Bounds {
+    Bounds();
+    std::array<std::atomic<Time>, LEVELS_COUNT> minTime;
+    std::array<std::atomic<Time>, LEVELS_COUNT> maxTime;
+  };
+
+  struct Shard {
+    mutable std::shared_mutex locker;
+    std::unordered_map<Id, Bounds> bounds;
+  };
+
+  Shard &shard(Id id) const { return _shards[id % SHARDS]; }
+  Bounds *find(Id id) const;
+
+  std::unique_ptr<Shard[]> _shards;
+  std::atomic<bool> _complete;
+};
+
+/// levels, which are readed by interval query. ids are in order of query.
+struct QueryPlan {
+  struct Level {
+    bool exists = false; // level is used by strategy.
+    IdArray scan;
+    IdArray pruned;
+  };
+
+  std::array<Level, LEVELS_COUNT> levels;
+  IdArray bystep; // readed from bystep storage only.
+
+  Level &operator[](LEVEL l) { return levels[size_t(l)]; }
+  const Level &operator[](LEVEL l) const { return levels[size_t(l)]; }
+  /// text description of plan. one line per level.
+  EXPORT std::string to_string() const;
+};
+}
+}
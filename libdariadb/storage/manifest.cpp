@@ -20,7 +20,12 @@ const char *MANIFEST_CREATE_SQL =
     "CREATE TABLE IF NOT EXISTS params(id INTEGER PRIMARY KEY AUTOINCREMENT, name "
     "varchar(255), value varchar(255)); "
     "CREATE TABLE IF NOT EXISTS id2step(bystep_id INTEGER UNIQUE PRIMARY KEY, step "
-    "varchar(50)); ";
+    "varchar(50)); "
+    "CREATE TABLE IF NOT EXISTS partitions(name varchar(255) UNIQUE PRIMARY KEY, "
+    "min_time INTEGER, max_time INTEGER); "
+    "CREATE TABLE IF NOT EXISTS tombstones(id INTEGER PRIMARY KEY AUTOINCREMENT, "
+    "meas_id INTEGER, from_time INTEGER, to_time INTEGER, page_seq INTEGER, wal_seq "
+    "INTEGER); ";
 
 class Manifest::Private {
 public:
@@ -91,6 +96,13 @@ public:
         this->page_append(fname);
       }
     }
+
+    for (auto p : this->partition_list()) {
+      auto full_path = utils::fs::append_path(raw_storage_path, p.name);
+      if (!utils::fs::path_exists(full_path)) {
+        this->partition_rm(p.name);
+      }
+    }
   }
 
   std::list<std::string> page_list() {
@@ -160,6 +172,121 @@ public:
     } while (rc == SQLITE_SCHEMA);
   }
 
+  std::list<PartitionRecord> partition_list() {
+    std::lock_guard<utils::async::Locker> lg(_locker);
+    std::string sql = "SELECT name, min_time, max_time from partitions ORDER BY min_time;";
+    std::list<PartitionRecord> result{};
+    sqlite3_stmt *pStmt;
+    int rc;
+
+    do {
+      rc = sqlite3_prepare(db, sql.c_str(), -1, &pStmt, 0);
+      if (rc != SQLITE_OK) {
+        auto err_msg = std::string(sqlite3_errmsg(db));
+        THROW_EXCEPTION("engine: Manifest - ", err_msg);
+      }
+      while (1) {
+        rc = sqlite3_step(pStmt);
+        if (rc == SQLITE_ROW) {
+          PartitionRecord pr;
+          auto n = sqlite3_column_bytes(pStmt, 0);
+          auto pStr = sqlite3_column_text(pStmt, 0);
+          pr.name = std::string((char *)pStr, n);
+          pr.minTime = (Time)sqlite3_column_int64(pStmt, 1);
+          pr.maxTime = (Time)sqlite3_column_int64(pStmt, 2);
+          result.push_back(pr);
+        } else {
+          break;
+        }
+      }
+      rc = sqlite3_finalize(pStmt);
+    } while (rc == SQLITE_SCHEMA);
+    return result;
+  }
+
+  void partition_update(const std::string &name, Time minTime, Time maxTime) {
+    std::lock_guard<utils::async::Locker> lg(_locker);
+    const std::string insert_query =
+        "insert or ignore into partitions (name, min_time, max_time) values (?,?,?);";
+    const std::string update_query =
+        "update partitions set min_time=min(min_time, ?), max_time=max(max_time, ?) "
+        "where name = ?;";
+    sqlite3_stmt *pStmt;
+    int rc;
+    do {
+      rc = sqlite3_prepare(db, insert_query.c_str(), -1, &pStmt, 0);
+      if (rc != SQLITE_OK) {
+        auto err_msg = std::string(sqlite3_errmsg(db));
+        THROW_EXCEPTION("engine: manifest - ", err_msg);
+      }
+
+      sqlite3_bind_text(pStmt, 1, name.c_str(), (int)name.size(), SQLITE_STATIC);
+      sqlite3_bind_int64(pStmt, 2, (sqlite3_int64)minTime);
+      sqlite3_bind_int64(pStmt, 3, (sqlite3_int64)maxTime);
+      rc = sqlite3_step(pStmt);
+      assert(rc != SQLITE_ROW);
+      rc = sqlite3_finalize(pStmt);
+    } while (rc == SQLITE_SCHEMA);
+
+    do {
+      rc = sqlite3_prepare(db, update_query.c_str(), -1, &pStmt, 0);
+      if (rc != SQLITE_OK) {
+        auto err_msg = std::string(sqlite3_errmsg(db));
+        THROW_EXCEPTION("engine: manifest - ", err_msg);
+      }
+
+      sqlite3_bind_int64(pStmt, 1, (sqlite3_int64)minTime);
+      sqlite3_bind_int64(pStmt, 2, (sqlite3_int64)maxTime);
+      sqlite3_bind_text(pStmt, 3, name.c_str(), (int)name.size(), SQLITE_STATIC);
+      rc = sqlite3_step(pStmt);
+      assert(rc != SQLITE_ROW);
+      rc = sqlite3_finalize(pStmt);
+    } while (rc == SQLITE_SCHEMA);
+  }
+
+  void partition_rm(const std::string &name) {
+    std::lock_guard<utils::async::Locker> lg(_locker);
+    // pages of partition stored as "name/page_file".
+    const std::string prefix = name + "/";
+    const std::string pages_query = "delete from pages where substr(file, 1, ?) = ?;";
+    const std::string partition_query = "delete from partitions where name = ?;";
+    sqlite3_exec(db, "BEGIN TRANSACTION;", NULL, NULL, NULL);
+    try {
+      sqlite3_stmt *pStmt;
+      int rc;
+      do {
+        rc = sqlite3_prepare(db, pages_query.c_str(), -1, &pStmt, 0);
+        if (rc != SQLITE_OK) {
+          auto err_msg = std::string(sqlite3_errmsg(db));
+          THROW_EXCEPTION("engine: manifest - ", err_msg);
+        }
+
+        sqlite3_bind_int(pStmt, 1, (int)prefix.size());
+        sqlite3_bind_text(pStmt, 2, prefix.c_str(), (int)prefix.size(), SQLITE_STATIC);
+        rc = sqlite3_step(pStmt);
+        assert(rc != SQLITE_ROW);
+        rc = sqlite3_finalize(pStmt);
+      } while (rc == SQLITE_SCHEMA);
+
+      do {
+        rc = sqlite3_prepare(db, partition_query.c_str(), -1, &pStmt, 0);
+        if (rc != SQLITE_OK) {
+          auto err_msg = std::string(sqlite3_errmsg(db));
+          THROW_EXCEPTION("engine: manifest - ", err_msg);
+        }
+
+        sqlite3_bind_text(pStmt, 1, name.c_str(), (int)name.size(), SQLITE_STATIC);
+        rc = sqlite3_step(pStmt);
+        assert(rc != SQLITE_ROW);
+        rc = sqlite3_finalize(pStmt);
+      } while (rc == SQLITE_SCHEMA);
+      sqlite3_exec(db, "END TRANSACTION;", NULL, NULL, NULL);
+    } catch (...) {
+      sqlite3_exec(db, "ROLLBACK TRANSACTION;", NULL, NULL, NULL);
+      throw;
+    }
+  }
+
   std::list<std::string> wal_list() {
     std::lock_guard<utils::async::Locker> lg(_locker);
     std::string sql = "SELECT file from wal ORDER BY id;";
@@ -240,6 +367,90 @@ public:
     } while (rc == SQLITE_SCHEMA);
   }
 
+  std::list<TombstoneRecord> tombstone_list() {
+    std::lock_guard<utils::async::Locker> lg(_locker);
+    std::string sql =
+        "SELECT meas_id, from_time, to_time, page_seq, wal_seq from tombstones ORDER BY id;";
+    std::list<TombstoneRecord> result{};
+    sqlite3_stmt *pStmt;
+    int rc;
+
+    do {
+      rc = sqlite3_prepare(db, sql.c_str(), -1, &pStmt, 0);
+      if (rc != SQLITE_OK) {
+        auto err_msg = std::string(sqlite3_errmsg(db));
+        THROW_EXCEPTION("engine: Manifest - ", err_msg);
+      }
+      while (1) {
+        rc = sqlite3_step(pStmt);
+        if (rc == SQLITE_ROW) {
+          TombstoneRecord rec;
+          rec.id = (Id)sqlite3_column_int64(pStmt, 0);
+          rec.from = (Time)sqlite3_column_int64(pStmt, 1);
+          rec.to = (Time)sqlite3_column_int64(pStmt, 2);
+          rec.page_seq = (uint64_t)sqlite3_column_int64(pStmt, 3);
+          rec.wal_seq = (uint64_t)sqlite3_column_int64(pStmt, 4);
+          rec.memory_seq = 0;
+          result.push_back(rec);
+        } else {
+          break;
+        }
+      }
+      rc = sqlite3_finalize(pStmt);
+    } while (rc == SQLITE_SCHEMA);
+    return result;
+  }
+
+  void tombstone_append(const TombstoneRecord &rec) {
+    std::lock_guard<utils::async::Locker> lg(_locker);
+    const std::string sql_query =
+        "insert into tombstones (meas_id, from_time, to_time, page_seq, wal_seq) values "
+        "(?,?,?,?,?);";
+    sqlite3_stmt *pStmt;
+    int rc;
+    do {
+      rc = sqlite3_prepare(db, sql_query.c_str(), -1, &pStmt, 0);
+      if (rc != SQLITE_OK) {
+        auto err_msg = std::string(sqlite3_errmsg(db));
+        THROW_EXCEPTION("engine: manifest - ", err_msg);
+      }
+
+      sqlite3_bind_int64(pStmt, 1, (sqlite3_int64)rec.id);
+      sqlite3_bind_int64(pStmt, 2, (sqlite3_int64)rec.from);
+      sqlite3_bind_int64(pStmt, 3, (sqlite3_int64)rec.to);
+      sqlite3_bind_int64(pStmt, 4, (sqlite3_int64)rec.page_seq);
+      sqlite3_bind_int64(pStmt, 5, (sqlite3_int64)rec.wal_seq);
+      rc = sqlite3_step(pStmt);
+      assert(rc != SQLITE_ROW);
+      rc = sqlite3_finalize(pStmt);
+    } while (rc == SQLITE_SCHEMA);
+  }
+
+  void tombstone_rm(const TombstoneRecord &rec) {
+    std::lock_guard<utils::async::Locker> lg(_locker);
+    const std::string sql_query =
+        "delete from tombstones where meas_id = ? and from_time = ? and to_time = ? and "
+        "page_seq = ? and wal_seq = ?;";
+    sqlite3_stmt *pStmt;
+    int rc;
+    do {
+      rc = sqlite3_prepare(db, sql_query.c_str(), -1, &pStmt, 0);
+      if (rc != SQLITE_OK) {
+        auto err_msg = std::string(sqlite3_errmsg(db));
+        THROW_EXCEPTION("engine: manifest - ", err_msg);
+      }
+
+      sqlite3_bind_int64(pStmt, 1, (sqlite3_int64)rec.id);
+      sqlite3_bind_int64(pStmt, 2, (sqlite3_int64)rec.from);
+      sqlite3_bind_int64(pStmt, 3, (sqlite3_int64)rec.to);
+      sqlite3_bind_int64(pStmt, 4, (sqlite3_int64)rec.page_seq);
+      sqlite3_bind_int64(pStmt, 5, (sqlite3_int64)rec.wal_seq);
+      rc = sqlite3_step(pStmt);
+      assert(rc != SQLITE_ROW);
+      rc = sqlite3_finalize(pStmt);
+    } while (rc == SQLITE_SCHEMA);
+  }
+
   void set_format(const std::string &version) {
     std::lock_guard<utils::async::Locker> lg(_locker);
 
@@ -382,6 +593,18 @@ void Manifest::page_rm(const std::string &rec) {
   _impl->page_rm(rec);
 }
 
+std::list<PartitionRecord> Manifest::partition_list() {
+  return _impl->partition_list();
+}
+
+void Manifest::partition_update(const std::string &name, Time minTime, Time maxTime) {
+  _impl->partition_update(name, minTime, maxTime);
+}
+
+void Manifest::partition_rm(const std::string &name) {
+  _impl->partition_rm(name);
+}
+
 std::list<std::string> Manifest::wal_list() {
   return _impl->wal_list();
 }
@@ -394,6 +617,18 @@ void Manifest::wal_rm(const std::string &rec) {
   _impl->wal_rm(rec);
 }
 
+std::list<TombstoneRecord> Manifest::tombstone_list() {
+  return _impl->tombstone_list();
+}
+
+void Manifest::tombstone_append(const TombstoneRecord &rec) {
+  _impl->tombstone_append(rec);
+}
+
+void Manifest::tombstone_rm(const TombstoneRecord &rec) {
+  _impl->tombstone_rm(rec);
+}
+
 void Manifest::set_format(const std::string &version) {
   _impl->set_format(version);
 }
@@ -14,6 +14,26 @@ namespace dariadb {
 namespace storage {
 
 const std::string MANIFEST_FILE_NAME = "Manifest";
+
+/// time-partition of pages. pages of partition stored in "raw_path/name/".
+struct PartitionRecord {
+  std::string name;
+  Time minTime;
+  Time maxTime;
+};
+
+/// values of 'id' in [from,to], written before erase, are erased:
+/// values of page chunks with id < page_seq, of wal files with seq < wal_seq
+/// and of memory chunks with seq < memory_seq.
+struct TombstoneRecord {
+  Id id;
+  Time from;
+  Time to;
+  uint64_t page_seq;
+  uint64_t wal_seq;
+  uint64_t memory_seq; // not stored: memory is empty after start.
+};
+
 class Manifest;
 using Manifest_ptr = std::shared_ptr<Manifest>;
 class Manifest {
@@ -26,10 +46,20 @@ public:
   EXPORT void page_append(const std::string &rec);
   EXPORT void page_rm(const std::string &rec);
 
+  EXPORT std::list<PartitionRecord> partition_list();
+  /// insert partition or extend its time interval.
+  EXPORT void partition_update(const std::string &name, Time minTime, Time maxTime);
+  /// rm partition and all its pages in one transaction.
+  EXPORT void partition_rm(const std::string &name);
+
   EXPORT std::list<std::string> wal_list();
   EXPORT void wal_append(const std::string &rec);
   EXPORT void wal_rm(const std::string &rec);
 
+  EXPORT std::list<TombstoneRecord> tombstone_list();
+  EXPORT void tombstone_append(const TombstoneRecord &rec);
+  EXPORT void tombstone_rm(const TombstoneRecord &rec);
+
   EXPORT void set_format(const std::string &version);
   EXPORT std::string get_format();
 
@@ -1,55 +1,212 @@
 #include <libdariadb/storage/memstorage/allocators.h>
+#include <libdariadb/utils/exception.h>
 #include <cstring>
 #include <memory>
 
+#ifndef MSVC
+#include <sys/mman.h>
+#endif
+
 using namespace dariadb;
 using namespace dariadb::storage;
 
+namespace {
+#ifndef MSVC
+std::atomic<bool> hugetlb_disabled{false};
+#endif
+
+/// mapped - length of mapping, must be passed to unmap_region.
+uint8_t *map_region(size_t size, size_t *mapped) {
+  *mapped = size;
+#ifdef MSVC
+  auto result = new uint8_t[size];
+  memset(result, 0, size);
+  return result;
+#else
+  void *result = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  // needs reserved huge pages, else fails at once.
+  // length of hugetlb mapping must be multiple of huge page, else munmap fails.
+  if (!hugetlb_disabled.load()) {
+    auto huge_size = (size + MemChunkAllocator::SLAB_SIZE - 1) /
+                     MemChunkAllocator::SLAB_SIZE * MemChunkAllocator::SLAB_SIZE;
+    result = mmap(nullptr, huge_size, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (result == MAP_FAILED) {
+      hugetlb_disabled.store(true);
+    } else {
+      *mapped = huge_size;
+    }
+  }
+#endif
+  if (result == MAP_FAILED) {
+    result = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1,
+                  0);
+    if (result == MAP_FAILED) {
+      return nullptr;
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(result, size, MADV_HUGEPAGE);
+#endif
+  }
+  return static_cast<uint8_t *>(result);
+#endif
+}
+
+void unmap_region(uint8_t *region, size_t size) {
+#ifdef MSVC
+  (void)size;
+  delete[] region;
+#else
+  munmap(region, size);
+#endif
+}
+}
+
 MemChunkAllocator::MemChunkAllocator(size_t maxSize, uint32_t bufferSize)
     : _one_chunk_size(sizeof(ChunkHeader) + bufferSize),
-      _capacity((int)(float(maxSize) / _one_chunk_size)), _free_list(_capacity) {
+      _capacity((int)(float(maxSize) / _one_chunk_size)) {
   _maxSize = maxSize;
   _chunkSize = bufferSize;
   _allocated = size_t(0);
+  _mapped_slabs = size_t(0);
+  _hint = size_t(0);
 
-  size_t buffers_size = _capacity * (_chunkSize + sizeof(ChunkHeader));
-
-  _region = new uint8_t[buffers_size];
-  _headers = reinterpret_cast<ChunkHeader *>(_region);
-  _buffers = _region + _capacity * sizeof(ChunkHeader);
+  _slab_size = SLAB_SIZE;
+  while (_slab_size < _one_chunk_size) {
+    _slab_size += SLAB_SIZE;
+  }
+  _chunks_per_slab = _slab_size / _one_chunk_size;
+  if (_capacity < _chunks_per_slab) { // one small slab.
+    _chunks_per_slab = std::max(_capacity, size_t(1));
+    _slab_size = _chunks_per_slab * _one_chunk_size;
+  }
 
-  memset(_region, 0, buffers_size);
-  for (size_t i = 0; i < _capacity; ++i) {
-    auto res = _free_list.push(i);
-    if (!res) {
-      THROW_EXCEPTION("engine: MemChunkAllocator::ctor - bad capacity.");
-    }
+  auto slabs_count = (_capacity + _chunks_per_slab - 1) / _chunks_per_slab;
+  _slabs = std::vector<Slab>(slabs_count);
+  for (size_t i = 0; i < slabs_count; ++i) {
+    auto &s = _slabs[i];
+    s.state = SLAB_STATE::EMPTY;
+    s.used = size_t(0);
+    s.count = std::min(_chunks_per_slab, _capacity - i * _chunks_per_slab);
+    s.region = nullptr;
+    s.mapped = size_t(0);
+    s.free_list.reset(new boost::lockfree::queue<uint32_t>(s.count));
   }
 }
 
 MemChunkAllocator::~MemChunkAllocator() {
-  delete[] _region;
+  for (auto &s : _slabs) {
+    if (s.region != nullptr) {
+      unmap_region(s.region, s.mapped);
+    }
+  }
 }
 
-MemChunkAllocator::AllocatedData MemChunkAllocator::allocate() {
-  size_t pos;
-  if (!_free_list.pop(pos)) {
-    return EMPTY;
+bool MemChunkAllocator::try_allocate(size_t slab_num, AllocatedData *result) {
+  auto &s = _slabs[slab_num];
+  if (s.state.load() != SLAB_STATE::ACTIVE) {
+    return false;
   }
+  // 'used' is increased before state check: shrink() can't unmap slab under us.
+  s.used++;
+  uint32_t pos;
+  if (s.state.load() != SLAB_STATE::ACTIVE || !s.free_list->pop(pos)) {
+    s.used--;
+    return false;
+  }
+  auto headers = reinterpret_cast<ChunkHeader *>(s.region);
+  auto buffers = s.region + s.count * sizeof(ChunkHeader);
+  *result = AllocatedData(&headers[pos], &buffers[size_t(pos) * _chunkSize],
+                          slab_num * _chunks_per_slab + pos);
+  _hint = slab_num;
   _allocated++;
-  return AllocatedData(&_headers[pos], &_buffers[pos * _chunkSize], pos);
+  return true;
+}
+
+bool MemChunkAllocator::map_slab() {
+  std::lock_guard<std::mutex> lg(_slabs_locker);
+  for (auto &s : _slabs) {
+    auto state = s.state.load();
+    if (state == SLAB_STATE::ACTIVE && s.used.load() < s.count) {
+      return true; // other thread did it.
+    }
+  }
+  for (auto &s : _slabs) {
+    if (s.state.load() != SLAB_STATE::EMPTY) {
+      continue;
+    }
+    s.region = map_region(_slab_size, &s.mapped);
+    if (s.region == nullptr) {
+      return false;
+    }
+    for (uint32_t i = 0; i < s.count; ++i) {
+      if (!s.free_list->push(i)) {
+        THROW_EXCEPTION("engine: MemChunkAllocator - bad capacity.");
+      }
+    }
+    _mapped_slabs++;
+    s.state = SLAB_STATE::ACTIVE;
+    return true;
+  }
+  return false;
+}
+
+MemChunkAllocator::AllocatedData MemChunkAllocator::allocate() {
+  AllocatedData result;
+  auto slabs_count = _slabs.size();
+  do {
+    auto hint = _hint.load();
+    for (size_t i = 0; i < slabs_count; ++i) {
+      if (try_allocate((hint + i) % slabs_count, &result)) {
+        return result;
+      }
+    }
+  } while (map_slab());
+  return EMPTY;
 }
 
 void MemChunkAllocator::free(const MemChunkAllocator::AllocatedData &d) {
   auto header = d.header;
   auto buffer = d.buffer;
-  auto position = d.position;
   memset(header, 0, sizeof(ChunkHeader));
   memset(buffer, 0, _chunkSize);
 
-  _allocated--;
-  auto res = _free_list.push(position);
+  auto &s = _slabs[d.position / _chunks_per_slab];
+  auto res = s.free_list->push(uint32_t(d.position % _chunks_per_slab));
   if (!res) {
     THROW_EXCEPTION("engine: MemChunkAllocator::free - bad capacity.");
   }
+  _allocated--;
+  s.used--;
+}
+
+size_t MemChunkAllocator::shrink() {
+  std::lock_guard<std::mutex> lg(_slabs_locker);
+  size_t spare = 0;
+  size_t result = 0;
+  for (auto &s : _slabs) {
+    if (s.state.load() != SLAB_STATE::ACTIVE || s.used.load() != 0) {
+      continue;
+    }
+    if (spare < SPARE_SLABS) {
+      ++spare;
+      continue;
+    }
+    s.state = SLAB_STATE::RETIRING;
+    if (s.used.load() != 0) { // allocate() is in progress.
+      s.state = SLAB_STATE::ACTIVE;
+      continue;
+    }
+    uint32_t pos;
+    while (s.free_list->pop(pos)) {
+    }
+    unmap_region(s.region, s.mapped);
+    s.region = nullptr;
+    s.mapped = size_t(0);
+    _mapped_slabs--;
+    s.state = SLAB_STATE::EMPTY;
+    ++result;
+  }
+  return result;
 }
@@ -4,14 +4,23 @@
 #include <libdariadb/storage/chunk.h>
 #include <libdariadb/utils/async/locker.h>
 #include <libdariadb/utils/utils.h>
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include <boost/lockfree/queue.hpp>
 
 namespace dariadb {
 namespace storage {
 
+/// chunks are placed in slabs of huge page size. slabs are mapped on demand,
+/// idle slabs are returned to OS by shrink().
 struct MemChunkAllocator : public utils::NonCopy {
+  static const size_t SLAB_SIZE = 2 * 1024 * 1024;
+  /// count of empty slabs, not returned to OS by shrink().
+  static const size_t SPARE_SLABS = 1;
+
   struct AllocatedData {
     ChunkHeader *header;
     uint8_t *buffer;
@@ -28,6 +37,17 @@ struct MemChunkAllocator : public utils::NonCopy {
     }
   };
 
+  enum class SLAB_STATE : uint8_t { EMPTY, ACTIVE, RETIRING };
+
+  struct Slab {
+    std::atomic<SLAB_STATE> state;
+    std::atomic<size_t> used;
+    size_t count; /// chunks in slab.
+    uint8_t *region;
+    size_t mapped; /// bytes of region mapping, may be greater than _slab_size.
+    std::unique_ptr<boost::lockfree::queue<uint32_t>> free_list;
+  };
+
   const AllocatedData EMPTY =
       AllocatedData(nullptr, nullptr, std::numeric_limits<size_t>::max());
 
@@ -35,19 +55,28 @@ struct MemChunkAllocator : public utils::NonCopy {
   size_t _maxSize;     /// max size in bytes)
   uint32_t _chunkSize; /// size of chunk
   size_t _capacity;    /// max size in chunks
-  size_t _allocated;   /// already allocated count of chunks.
-
-  ChunkHeader *_headers;
-  uint8_t *_buffers;
-  uint8_t *_region;
+  std::atomic<size_t> _allocated; /// already allocated count of chunks.
 
-  boost::lockfree::queue<size_t> _free_list;
+  size_t _slab_size;      /// bytes in one slab.
+  size_t _chunks_per_slab;
+  std::vector<Slab> _slabs;
+  std::atomic<size_t> _mapped_slabs;
+  std::atomic<size_t> _hint; /// slab of last allocation.
+  std::mutex _slabs_locker;  /// map and unmap of slabs.
 
   EXPORT MemChunkAllocator(size_t maxSize, uint32_t bufferSize);
   MemChunkAllocator(const MemChunkAllocator &) = delete;
   EXPORT ~MemChunkAllocator();
   EXPORT AllocatedData allocate();
   EXPORT void free(const AllocatedData &d);
+  /// return empty slabs to OS. result - count of released slabs.
+  EXPORT size_t shrink();
+  /// bytes, mapped now.
+  size_t mapped_size() const { return _mapped_slabs.load() * _slab_size; }
+
+protected:
+  bool try_allocate(size_t slab_num, AllocatedData *result);
+  bool map_slab();
 };
 }
 }
@@ -1,10 +1,15 @@
 #pragma once
+
+#include <libdariadb/storage/backpressure.h>
+
 namespace dariadb {
 namespace storage {
 namespace memstorage {
 struct Description {
   size_t allocated;
   size_t allocator_capacity;
+  size_t allocator_mapped; // bytes
+  Backpressure::Description backpressure;
 };
 }
 }
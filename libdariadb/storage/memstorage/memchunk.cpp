@@ -1,4 +1,5 @@
 #include <libdariadb/storage/memstorage/memchunk.h>
+#include <thread>
 
 using namespace dariadb;
 using namespace dariadb::storage;
@@ -10,16 +11,50 @@ MemChunk::MemChunk(ChunkHeader *index, uint8_t *buffer, uint32_t size,
   buffer_ptr = buffer;
   _track = nullptr;
   in_disk_count = 0;
+  seq = 0;
+  _fill_seq = 0;
+  _removed = NOT_REMOVED;
+  publish();
 }
 
 MemChunk::MemChunk(ChunkHeader *index, uint8_t *buffer) : Chunk(index, buffer) {
   index_ptr = index;
   buffer_ptr = buffer;
   _track = nullptr;
+  seq = 0;
+  _fill_seq = 0;
+  _removed = NOT_REMOVED;
+  publish();
 }
 
 MemChunk::~MemChunk() {}
 
+void MemChunk::publish() {
+  auto seq = _fill_seq.load(std::memory_order_relaxed);
+  _fill_seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  _fill_count.store(header->count, std::memory_order_relaxed);
+  _fill_max.store(header->maxTime, std::memory_order_relaxed);
+  _fill_seq.store(seq + 2, std::memory_order_release);
+}
+
+MemChunk::Fill MemChunk::published() const {
+  while (true) {
+    auto seq = _fill_seq.load(std::memory_order_acquire);
+    if ((seq & 1) != 0) {
+      std::this_thread::yield();
+      continue;
+    }
+    Fill result;
+    result.count = _fill_count.load(std::memory_order_relaxed);
+    result.maxTime = _fill_max.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (_fill_seq.load(std::memory_order_relaxed) == seq) {
+      return result;
+    }
+  }
+}
+
 // bool MemChunk::already_in_disk()
 //    const { // STRATEGY::CACHE, true - if already writed to disk.
 //  return in_disk_count == (this->header->count + 1); // compressed + first;
@@ -2,6 +2,8 @@
 
 #include <libdariadb/storage/chunk.h>
 #include <libdariadb/storage/memstorage/allocators.h>
+#include <libdariadb/storage/version_set.h>
+#include <atomic>
 #include <list>
 #include <memory>
 
@@ -10,15 +12,43 @@ namespace storage {
 
 struct TimeTrack;
 struct MemChunk : public Chunk {
+  /// part of chunk, visible to readers. header of current chunk is changed
+  /// by writer without locks, so readers use only published values.
+  struct Fill {
+    uint32_t count;
+    Time maxTime;
+  };
+
   ChunkHeader *index_ptr;
   uint8_t *buffer_ptr;
   MemChunkAllocator::AllocatedData _a_data;
   TimeTrack *_track; /// init in TimeTrack
   size_t in_disk_count;
+  uint64_t seq; /// order of creation. init in MemoryChunkContainer::addChunk
 
   MemChunk(ChunkHeader *index, uint8_t *buffer, uint32_t size, const Meas &first_m);
   MemChunk(ChunkHeader *index, uint8_t *buffer);
   ~MemChunk();
+
+  /// called by writer after append.
+  void publish();
+  Fill published() const;
+  using Chunk::getReader;
+  ChunkReader_Ptr getReader(const Fill &f) { return Chunk::getReader(f.count); }
+
+  /// chunk is dropped in 'version', but stays readable for older snapshots.
+  void remove(uint64_t version) { _removed.store(version, std::memory_order_release); }
+  bool removed() const { return _removed.load(std::memory_order_acquire) != NOT_REMOVED; }
+  bool visible(uint64_t version) const {
+    return version < _removed.load(std::memory_order_acquire);
+  }
+
+protected:
+  /// seqlock of published fill. odd - writer is in progress.
+  std::atomic<uint32_t> _fill_seq;
+  std::atomic<uint32_t> _fill_count;
+  std::atomic<Time> _fill_max;
+  std::atomic<uint64_t> _removed;
   // bool already_in_disk() const; // STRATEGY::CACHE, true - if already writed to disk.
 };
 
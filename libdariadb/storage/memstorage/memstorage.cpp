@@ -6,28 +6,49 @@
 #include <libdariadb/storage/memstorage/memstorage.h>
 #include <libdariadb/storage/memstorage/timetrack.h>
 #include <libdariadb/storage/settings.h>
+#include <libdariadb/storage/version_set.h>
 #include <libdariadb/utils/async/thread_manager.h>
+#include <libdariadb/utils/sharded_id_map.h>
+#include <algorithm>
 #include <cstring>
+#include <iterator>
 #include <memory>
+#include <queue>
 #include <set>
-#include <shared_mutex>
 #include <thread>
 
 using namespace dariadb;
 using namespace dariadb::storage;
 using namespace dariadb::utils::async;
 
+/// max chunks in one write to down level.
+const size_t DROP_BATCH_SIZE = 8192;
+
 /**
 Map:
   Meas.id -> TimeTrack{ MemChunkList[MemChunk{data}]}
+  ids are sharded by utils::ShardedIdMap, lookup of existing id is lock-free.
 */
 struct MemStorage::Private : public IMeasStorage, public MemoryChunkContainer {
   Private(const EngineEnvironment_ptr &env, size_t id_count)
-      : _env(env), _settings(_env->getResourceObject<Settings>(
+      : _id2track(id_count), _env(env), _settings(_env->getResourceObject<Settings>(
                        EngineEnvironment::Resource::SETTINGS)),
-        _chunk_allocator(_settings->memory_limit.value(), _settings->chunk_size.value()) {
+        _chunk_allocator(_settings->memory_limit.value(), _settings->chunk_size.value()),
+        // writers wait by memory_high. dropping starts by percent_when_start_droping.
+        _backpressure("memstorage", watermarks(_chunk_allocator._capacity, _settings)) {
     _chunks.resize(_chunk_allocator._capacity);
+    _tombstones = nullptr;
+    if (_env->hasResource(EngineEnvironment::Resource::TOMBSTONES)) {
+      _tombstones =
+          _env->getResourceObject<Tombstones>(EngineEnvironment::Resource::TOMBSTONES);
+    }
+    _versions = nullptr;
+    if (_env->hasResource(EngineEnvironment::Resource::VERSIONS)) {
+      _versions =
+          _env->getResourceObject<VersionSet>(EngineEnvironment::Resource::VERSIONS);
+    }
     _stoped = false;
+    _chunk_seq = 1;
     _down_level_storage = nullptr;
     _disk_storage = nullptr;
     _drop_stop = false;
@@ -37,13 +58,21 @@ struct MemStorage::Private : public IMeasStorage, public MemoryChunkContainer {
       _crawler_thread =
           std::thread{std::bind(&MemStorage::Private::crawler_thread_func, this)};
     }*/
-    if (id_count != 0) {
-      _id2track.reserve(id_count);
-    }
   }
+  /// memory_high and memory_low in chunks. writers wait, before all chunks are used.
+  static Backpressure::Params watermarks(size_t capacity, const Settings *s) {
+    auto high = size_t(capacity * s->memory_high.value());
+    high = std::max(std::min(high, capacity), size_t(1));
+    auto low = size_t(capacity * s->memory_low.value());
+    low = std::min(low, high - 1);
+    return Backpressure::Params(high, low, s);
+  }
+
   void stop() {
     if (!_stoped) {
       logger_info("engine: memstorage - begin stoping.");
+      flush();
+      _backpressure.stop();
       _drop_stop = true;
       _drop_cond.notify_all();
       _drop_thread.join();
@@ -71,192 +100,326 @@ struct MemStorage::Private : public IMeasStorage, public MemoryChunkContainer {
     memstorage::Description result;
     result.allocated = _chunk_allocator._allocated;
     result.allocator_capacity = _chunk_allocator._capacity;
+    result.allocator_mapped = _chunk_allocator.mapped_size();
+    result.backpressure = _backpressure.description();
     return result;
   }
 
+  TimeTrack *track(Id id) {
+    auto result = _id2track.find(id);
+    if (result == nullptr) {
+      result = _id2track.insert(id, [this, id]() {
+        return std::make_shared<TimeTrack>(this, Time(0), id, &_chunk_allocator,
+                                           _tombstones,
+                                           _settings->memory_reorder_window.value());
+      });
+    }
+    return result;
+  }
+
+  /// wait for free chunk.
+  APPEND_ERROR wait_free_chunk() {
+    _backpressure.update(_chunk_allocator._allocated.load());
+    return _backpressure.admit([this]() { _drop_cond.notify_all(); });
+  }
+
+  /// writers wait, while used chunks are above memory_high.
+  APPEND_ERROR admit() {
+    if (!_backpressure.overloaded() &&
+        _chunk_allocator._allocated.load() < _backpressure.params().high) {
+      return APPEND_ERROR::OK;
+    }
+    return wait_free_chunk();
+  }
+
   Status append(const Meas &value) override {
-    _all_tracks_locker.lock_shared();
-    auto track = _id2track.find(value.id);
-    TimeTrack_ptr target_track = nullptr;
-    if (track == _id2track.end()) {
-      _all_tracks_locker.unlock_shared();
-      std::lock_guard<std::shared_mutex> lg(_all_tracks_locker);
-
-      track = _id2track.find(value.id);
-      if (track == _id2track.end()) { // still not exists.
-        target_track =
-            std::make_shared<TimeTrack>(this, Time(0), value.id, &_chunk_allocator);
-        _id2track.emplace(std::make_pair(value.id, target_track));
-      } else {
-        target_track = track->second;
-      }
-    } else {
-      target_track = track->second;
-      _all_tracks_locker.unlock_shared();
+    auto err = admit();
+    if (err != APPEND_ERROR::OK) {
+      return Status::rejected(err);
     }
+    auto target_track = track(value.id);
 
-    while (target_track->append(value) != Status(1, 0)) {
-      _drop_cond.notify_all();
+    auto status = target_track->append(value);
+    while (status.writed == 0) { // no free chunks.
+      err = wait_free_chunk();
+      if (err != APPEND_ERROR::OK) {
+        return Status::rejected(err);
+      }
+      status = target_track->append(value);
+    }
+    if (status.ignored != 0) { // write to past.
+      return Status(0, 1);
     }
 
     if (_disk_storage != nullptr) {
       _disk_storage->append(value);
-      target_track->_max_sync_time = value.time;
+      target_track->_max_sync_time = std::max(target_track->_max_sync_time, value.time);
     }
     return Status(1, 0);
   }
 
+  /// true - if track can ignore only first values of run, as written to past.
+  bool is_prefix_ignored(const MeasArray::const_iterator &begin,
+                         const MeasArray::const_iterator &end) const {
+    return _settings->memory_reorder_window.value() == 0 &&
+           std::adjacent_find(begin, end, [](const Meas &l, const Meas &r) {
+             return l.time >= r.time;
+           }) == end;
+  }
+
+  /// values of one id are appended under one lock of track.
+  Status append(const MeasArray::const_iterator &begin,
+                const MeasArray::const_iterator &end) override {
+    Status result;
+    auto it = begin;
+    while (it != end) {
+      auto id = it->id;
+      auto run_end = std::find_if(it, end, [id](const Meas &m) { return m.id != id; });
+      if (_disk_storage != nullptr && !is_prefix_ignored(it, run_end)) {
+        // written values are unknown.
+        for (; it != run_end; ++it) {
+          auto st = append(*it);
+          result = result + st;
+          if (st.error != APPEND_ERROR::OK) {
+            return result;
+          }
+        }
+        continue;
+      }
+
+      auto err = admit();
+      if (err != APPEND_ERROR::OK) {
+        return result + Status::rejected(err);
+      }
+      auto target_track = track(id);
+      while (it != run_end) {
+        Status st;
+        auto processed = target_track->append(it, run_end, &st);
+        if (_disk_storage != nullptr && st.writed != 0) {
+          auto first = it + st.ignored;
+          _disk_storage->append(first, first + st.writed);
+          target_track->_max_sync_time =
+              std::max(target_track->_max_sync_time, (first + st.writed - 1)->time);
+        }
+        result = result + st;
+        it += processed;
+        if (it != run_end) {
+          auto err = wait_free_chunk();
+          if (err != APPEND_ERROR::OK) {
+            return result + Status::rejected(err);
+          }
+        }
+      }
+    }
+    return result;
+  }
+
   void drop_by_limit(float chunk_percent_to_free, bool in_stop) {
     logger_info("engine: memstorage - drop_by_limit ", chunk_percent_to_free);
-    auto cur_chunk_count = this->_chunk_allocator._allocated;
+    auto cur_chunk_count = this->_chunk_allocator._allocated.load();
     auto chunks_to_delete = (size_t)(cur_chunk_count * chunk_percent_to_free);
 
-    std::vector<Chunk *> all_chunks;
-    all_chunks.reserve(cur_chunk_count);
-    size_t pos = 0;
-
-    std::shared_lock<std::shared_mutex> sl(_all_tracks_locker);
-    std::vector<MemChunk_Ptr> chunks_copy(_chunks.size());
-    auto it = std::copy_if(_chunks.begin(), _chunks.end(), chunks_copy.begin(),
-                           [](auto c) { return c != nullptr; });
-    sl.unlock();
-    chunks_copy.resize(std::distance(chunks_copy.begin(), it));
-
-    std::sort(chunks_copy.begin(), chunks_copy.end(),
-              [](const MemChunk_Ptr &left, const MemChunk_Ptr &right) {
-                return left->header->data_first.time < right->header->data_first.time;
-              });
-    for (auto &c : chunks_copy) {
-      if (pos >= chunks_to_delete) {
-        break;
+    if (in_stop) { // all chunks, include not closed.
+      std::vector<MemChunk_Ptr> all_chunks;
+      {
+        std::lock_guard<std::mutex> lg(_age_locker);
+        _closed_chunks = AgeQueue();
       }
-      if (c == nullptr) {
-        continue;
+      {
+        std::lock_guard<std::mutex> lg(_chunks_locker);
+        std::copy_if(_chunks.begin(), _chunks.end(), std::back_inserter(all_chunks),
+                     [](auto c) { return c != nullptr && !c->removed(); });
       }
-      if (!in_stop & !c->isFull()) { // not full
-        ENSURE(!in_stop);
-        ENSURE(!c->isFull());
-        continue;
+      drop_chunks(all_chunks, cur_chunk_count);
+      return;
+    }
+
+    // oldest closed chunks, by batches.
+    size_t dropped = 0;
+    std::vector<MemChunk_Ptr> batch;
+    while (dropped < chunks_to_delete) {
+      batch.clear();
+      {
+        std::lock_guard<std::mutex> lg(_age_locker);
+        auto batch_size = std::min(DROP_BATCH_SIZE, chunks_to_delete - dropped);
+        while (batch.size() < batch_size && !_closed_chunks.empty()) {
+          batch.push_back(_closed_chunks.top().chunk);
+          _closed_chunks.pop();
+        }
       }
-      /* if (_settings->strategy.value() == STRATEGY::CACHE && (!c->already_in_disk())) {
-         continue;
-       }*/
-      all_chunks.push_back(c.get());
-      ++pos;
+      if (batch.empty()) {
+        break;
+      }
+      drop_chunks(batch, cur_chunk_count);
+      dropped += batch.size();
     }
-    if (pos != 0) {
-      logger_info("engine: memstorage - drop begin ", pos, " chunks of ",
-                  cur_chunk_count);
-      if (_down_level_storage != nullptr) {
-        AsyncTask at = [this, &all_chunks, pos](const ThreadInfo &ti) {
-          TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
-          this->_down_level_storage->appendChunks(all_chunks, pos);
-          return false;
-        };
-        auto at_res = ThreadManager::instance()->post(THREAD_KINDS::DISK_IO, AT(at));
-        at_res->wait();
-      } else {
-        if (_settings->strategy.value() != STRATEGY::CACHE) {
-          logger_info("engine: memstorage _down_level_storage == nullptr");
+  }
+
+  void drop_chunks(const std::vector<MemChunk_Ptr> &chunks, size_t cur_chunk_count) {
+    if (chunks.empty()) {
+      return;
+    }
+    auto count = chunks.size();
+    logger_info("engine: memstorage - drop begin ", count, " chunks of ", cur_chunk_count);
+    if (_down_level_storage != nullptr) {
+      std::vector<Chunk *> all_chunks;
+      std::vector<Chunk_Ptr> rewrited;
+      without_erased(chunks, &all_chunks, &rewrited);
+      AsyncTask at = [this, &chunks, &all_chunks](const ThreadInfo &ti) {
+        TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
+        // readers see values of chunks in memory or in page, not in both.
+        VersionSet::Edit edit(_versions);
+        if (!all_chunks.empty()) {
+          this->_down_level_storage->appendChunks(all_chunks, all_chunks.size());
         }
+        remove_chunks(chunks, edit);
+        return false;
+      };
+      auto at_res = ThreadManager::instance()->post(THREAD_KINDS::DISK_IO, AT(at));
+      at_res->wait();
+    } else {
+      if (_settings->strategy.value() != STRATEGY::CACHE) {
+        logger_info("engine: memstorage _down_level_storage == nullptr");
       }
-      std::set<TimeTrack *> updated_tracks;
-      for (size_t i = 0; i < pos; ++i) {
-        auto c = all_chunks[i];
-        auto mc = dynamic_cast<MemChunk *>(c);
-        ENSURE(mc != nullptr);
-
-        TimeTrack *track = mc->_track;
-        track->rm_chunk(mc);
-        updated_tracks.insert(track);
-
-        auto chunk_pos = mc->_a_data.position;
-        _chunk_allocator.free(mc->_a_data);
-        _chunks[chunk_pos] = nullptr;
+      VersionSet::Edit edit(_versions);
+      remove_chunks(chunks, edit);
+    }
+    logger_info("engine: memstorage - drop end.");
+  }
+
+  /// tombstones do not cover chunks in pages, so chunks with erased values
+  /// are rewrited without them. 'rewrited' owns new chunks.
+  void without_erased(const std::vector<MemChunk_Ptr> &chunks, std::vector<Chunk *> *out,
+                      std::vector<Chunk_Ptr> *rewrited) {
+    out->reserve(chunks.size());
+    for (auto &c : chunks) {
+      auto erased = c->_track->erased_in(c);
+      if (erased.empty()) {
+        out->push_back(c.get());
+        continue;
       }
-      for (auto &t : updated_tracks) {
-        t->rereadMinMax();
+      Chunk_Ptr target = nullptr;
+      auto rdr = c->getReader();
+      while (!rdr->is_end()) {
+        auto v = rdr->readNext();
+        if (erased.contains(v.time)) {
+          continue;
+        }
+        if (target == nullptr || !target->append(v)) {
+          auto hdr = new ChunkHeader;
+          memset(hdr, 0, sizeof(ChunkHeader));
+          auto buffer = new uint8_t[c->header->size];
+          target = Chunk::create(hdr, buffer, c->header->size, v);
+          target->is_owner = true;
+          rewrited->push_back(target);
+          out->push_back(target.get());
+        }
       }
-      logger_info("engine: memstorage - drop end.");
+    }
+  }
+
+  /// chunks are freed, when readers of older versions are released.
+  /// min and max of tracks are changed at once: readers of new version do not
+  /// expect values of dropped chunks in memory.
+  void remove_chunks(const std::vector<MemChunk_Ptr> &chunks, VersionSet::Edit &edit) {
+    std::set<TimeTrack *> updated_tracks;
+    for (auto &mc : chunks) {
+      mc->remove(edit.version());
+      updated_tracks.insert(mc->_track);
+    }
+    for (auto &t : updated_tracks) {
+      t->rereadMinMax();
+    }
+    edit.retire([this, chunks]() { free_chunks(chunks); });
+  }
+
+  void free_chunks(const std::vector<MemChunk_Ptr> &chunks) {
+    std::set<TimeTrack *> updated_tracks;
+    for (auto &mc : chunks) {
+      TimeTrack *track = mc->_track;
+      track->rm_chunk(mc.get());
+      updated_tracks.insert(track);
+
+      auto chunk_pos = mc->_a_data.position;
+      _chunk_allocator.free(mc->_a_data);
+      std::lock_guard<std::mutex> lg(_chunks_locker);
+      _chunks[chunk_pos] = nullptr;
+    }
+    for (auto &t : updated_tracks) {
+      t->rereadMinMax();
+    }
+    _backpressure.update(_chunk_allocator._allocated.load());
+    auto released = _chunk_allocator.shrink();
+    if (released != 0) {
+      logger_info("engine: memstorage - ", released, " slabs returned to system.");
     }
   }
 
   Id2Time getSyncMap() {
     Id2Time result;
-    std::shared_lock<std::shared_mutex> sl(_all_tracks_locker);
     result.reserve(_id2track.size());
-    for (auto t : _id2track) {
-      result[t.first] = t.second->_max_sync_time;
-    }
+    _id2track.foreach (
+        [&result](Id, TimeTrack *t) { result[t->_meas_id] = t->_max_sync_time; });
     return result;
   }
 
   Id2MinMax loadMinMax() override {
     Id2MinMax result;
-    std::shared_lock<std::shared_mutex> sl(_all_tracks_locker);
-    for (auto t : _id2track) {
-      if (t.second->_cur_chunk == nullptr) {
-        continue;
+    _id2track.foreach ([&result](Id, TimeTrack *t) {
+      if (t->_min_max.min.time <= t->_min_max.max.time) { // not empty.
+        result[t->_meas_id] = t->_min_max;
       }
-      result[t.first] = t.second->_min_max;
-    }
+    });
     return result;
   }
 
   Time minTime() override {
-    std::shared_lock<std::shared_mutex> sl(_all_tracks_locker);
     Time result = MAX_TIME;
-    for (auto t : _id2track) {
-      result = std::min(result, t.second->minTime());
-    }
+    _id2track.foreach ([&result](Id, TimeTrack *t) { result = std::min(result, t->minTime()); });
     return result;
   }
   virtual Time maxTime() override {
-    std::shared_lock<std::shared_mutex> sl(_all_tracks_locker);
     Time result = MIN_TIME;
-    for (auto t : _id2track) {
-      result = std::max(result, t.second->maxTime());
-    }
+    _id2track.foreach ([&result](Id, TimeTrack *t) { result = std::max(result, t->maxTime()); });
     return result;
   }
 
   virtual bool minMaxTime(dariadb::Id id, dariadb::Time *minResult,
                           dariadb::Time *maxResult) override {
-    std::shared_lock<std::shared_mutex> sl(_all_tracks_locker);
     auto tracker = _id2track.find(id);
-    if (tracker != _id2track.end()) {
-      return tracker->second->minMaxTime(id, minResult, maxResult);
+    if (tracker != nullptr) {
+      return tracker->minMaxTime(id, minResult, maxResult);
     }
     return false;
   }
 
   void foreach (const QueryInterval &q, IReaderClb * clbk) override {
-    std::shared_lock<std::shared_mutex> sl(_all_tracks_locker);
     QueryInterval local_q({}, q.flag, q.from, q.to);
+    local_q.version = q.version;
     local_q.ids.resize(1);
     for (auto id : q.ids) {
       if (clbk->is_canceled()) {
         break;
       }
       auto tracker = _id2track.find(id);
-      if (tracker != _id2track.end()) {
+      if (tracker != nullptr) {
         local_q.ids[0] = id;
-        tracker->second->foreach (local_q, clbk);
+        tracker->foreach (local_q, clbk);
       }
     }
   }
 
   virtual Id2Meas readTimePoint(const QueryTimePoint &q) override {
-    std::shared_lock<std::shared_mutex> sl(_all_tracks_locker);
     QueryTimePoint local_q({}, q.flag, q.time_point);
+    local_q.version = q.version;
     local_q.ids.resize(1);
     Id2Meas result;
     for (auto id : q.ids) {
       result[id].id = id;
       auto tracker = _id2track.find(id);
-      if (tracker != _id2track.end()) {
+      if (tracker != nullptr) {
         local_q.ids[0] = id;
-        auto sub_res = tracker->second->readTimePoint(local_q);
+        auto sub_res = tracker->readTimePoint(local_q);
         result[id] = sub_res[id];
       } else {
         result[id].flag = Flags::_NO_DATA;
@@ -266,16 +429,15 @@ struct MemStorage::Private : public IMeasStorage, public MemoryChunkContainer {
   }
 
   virtual Id2Meas currentValue(const IdArray &ids, const Flag &flag) override {
-    std::shared_lock<std::shared_mutex> sl(_all_tracks_locker);
     IdArray local_ids;
     local_ids.resize(1);
     Id2Meas result;
     for (auto id : ids) {
       result[id].id = id;
       auto tracker = _id2track.find(id);
-      if (tracker != _id2track.end()) {
+      if (tracker != nullptr) {
         local_ids[0] = id;
-        auto sub_res = tracker->second->currentValue(local_ids, flag);
+        auto sub_res = tracker->currentValue(local_ids, flag);
         result[id] = sub_res[id];
       } else {
         result[id].flag = Flags::_NO_DATA;
@@ -284,16 +446,33 @@ struct MemStorage::Private : public IMeasStorage, public MemoryChunkContainer {
     return result;
   }
 
-  void flush() override {}
+  /// move values from reorder buffers to chunks.
+  void flush() override {
+    _id2track.foreach ([this](Id, TimeTrack *t) {
+      while (!t->flush_buffer()) {
+        _backpressure.update(_chunk_allocator._allocated.load());
+        _backpressure.wait([this]() { _drop_cond.notify_all(); });
+      }
+    });
+  }
 
   void setDownLevel(IChunkStorage *down) { _down_level_storage = down; }
 
   void setDiskStorage(IMeasWriter *_disk) { _disk_storage = _disk; }
 
+  void closeChunk(const MemChunk_Ptr &chunk) override {
+    std::lock_guard<std::mutex> lg(_age_locker);
+    _closed_chunks.push(AgeRecord{chunk->header->data_first.time, chunk});
+  }
+
   void addChunk(MemChunk_Ptr &chunk) override {
     ENSURE(chunk->_a_data.position < _chunks.size());
+    chunk->seq = _chunk_seq++;
 
-    _chunks[chunk->_a_data.position] = chunk;
+    {
+      std::lock_guard<std::mutex> lg(_chunks_locker);
+      _chunks[chunk->_a_data.position] = chunk;
+    }
     if (is_time_to_drop()) {
       _drop_cond.notify_all();
     }
@@ -301,9 +480,23 @@ struct MemStorage::Private : public IMeasStorage, public MemoryChunkContainer {
 
   std::mutex *getLockers() { return &_drop_locker; }
 
+  uint64_t seal(const IdArray &ids, Time from, Time to) {
+    // chunks, created while tracks are sealed, are not covered.
+    auto result = _chunk_seq.load();
+    for (auto id : ids) {
+      auto tracker = _id2track.find(id);
+      if (tracker != nullptr) {
+        tracker->seal(from, to);
+      }
+    }
+    return result;
+  }
+
+  /// writers, waiting by memory_high, are resumed by drop too.
   bool is_time_to_drop() {
-    return (_chunk_allocator._allocated) >=
-           (_chunk_allocator._capacity * _settings->percent_when_start_droping.value());
+    return _backpressure.overloaded() ||
+           (_chunk_allocator._allocated) >=
+               (_chunk_allocator._capacity * _settings->percent_when_start_droping.value());
   }
 
   void drop_thread_func() {
@@ -314,25 +507,39 @@ struct MemStorage::Private : public IMeasStorage, public MemoryChunkContainer {
         break;
       }
 
-      if (!is_time_to_drop()) {
-        continue;
+      if (is_time_to_drop()) {
+        drop_by_limit(_settings->percent_to_drop.value(), false);
       }
-
-      drop_by_limit(_settings->percent_to_drop.value(), false);
+      // chunks can be freed not only by dropping.
+      _backpressure.update(_chunk_allocator._allocated.load());
     }
     logger_info("engine: memstorage - dropping thread stoped.");
   }
 
-  Id2Track _id2track;
+  utils::ShardedIdMap<TimeTrack> _id2track;
   EngineEnvironment_ptr _env;
+  Tombstones *_tombstones;
   storage::Settings *_settings;
   MemChunkAllocator _chunk_allocator;
-  std::shared_mutex _all_tracks_locker;
+  Backpressure _backpressure;
+  std::mutex _chunks_locker;
   IChunkStorage *_down_level_storage;
   IMeasWriter *_disk_storage;
 
   std::vector<MemChunk_Ptr> _chunks;
+  /// closed chunks, oldest on top. only they are dropped by limit.
+  struct AgeRecord {
+    Time first;
+    MemChunk_Ptr chunk;
+    bool operator>(const AgeRecord &other) const { return first > other.first; }
+  };
+  using AgeQueue =
+      std::priority_queue<AgeRecord, std::vector<AgeRecord>, std::greater<AgeRecord>>;
+  AgeQueue _closed_chunks;
+  std::mutex _age_locker;
+  VersionSet *_versions;
   bool _stoped;
+  std::atomic<uint64_t> _chunk_seq;
 
   std::thread _drop_thread;
   bool _drop_stop;
@@ -384,6 +591,11 @@ Status MemStorage::append(const Meas &value) {
   return _impl->append(value);
 }
 
+Status MemStorage::append(const MeasArray::const_iterator &begin,
+                          const MeasArray::const_iterator &end) {
+  return _impl->append(begin, end);
+}
+
 void MemStorage::flush() {
   _impl->flush();
 }
@@ -411,3 +623,7 @@ Id2MinMax MemStorage::loadMinMax() {
 Id2Time MemStorage::getSyncMap() {
   return _impl->getSyncMap();
 }
+
+uint64_t MemStorage::seal(const IdArray &ids, Time from, Time to) {
+  return _impl->seal(ids, from, to);
+}
@@ -35,6 +35,9 @@ public:
   EXPORT virtual Id2Meas currentValue(const IdArray &ids, const Flag &flag) override;
   using IMeasStorage::append;
   EXPORT Status append(const Meas &value) override;
+  /// values of one id are appended under one lock.
+  EXPORT Status append(const MeasArray::const_iterator &begin,
+                       const MeasArray::const_iterator &end) override;
   EXPORT void flush() override;
   EXPORT void setDownLevel(IChunkStorage *_down);
   EXPORT void setDiskStorage(IMeasWriter *_disk); // when strategy==CACHE;
@@ -42,6 +45,9 @@ public:
   EXPORT std::mutex *getLockers();
   EXPORT Id2MinMax loadMinMax() override;
   EXPORT Id2Time getSyncMap(); /// Id to max dropped to disk time.
+  /// close current chunks of 'ids' and remove buffered values in [from,to].
+  /// return sequence of next chunk: chunks with less one are written before.
+  EXPORT uint64_t seal(const IdArray &ids, Time from, Time to);
 private:
   struct Private;
   std::unique_ptr<Private> _impl;
@@ -2,13 +2,16 @@
 #define _SCL_SECURE_NO_WARNINGS // stx::btree
 #endif
 #include <libdariadb/flags.h>
+#include <libdariadb/storage/callbacks.h>
 #include <libdariadb/storage/memstorage/timetrack.h>
+#include <algorithm>
 
 using namespace dariadb;
 using namespace dariadb::storage;
 
 TimeTrack::TimeTrack(MemoryChunkContainer *mcc, const Time step, Id meas_id,
-                     MemChunkAllocator *allocator) {
+                     MemChunkAllocator *allocator, const Tombstones *tombstones,
+                     const Time reorder_window) {
   _allocator = allocator;
   _meas_id = meas_id;
   _step = step;
@@ -16,6 +19,8 @@ TimeTrack::TimeTrack(MemoryChunkContainer *mcc, const Time step, Id meas_id,
   _min_max.max.time = MIN_TIME;
   _max_sync_time = MIN_TIME;
   _mcc = mcc;
+  _tombstones = tombstones;
+  _reorder_window = reorder_window;
 }
 
 TimeTrack::~TimeTrack() {}
@@ -27,6 +32,98 @@ void TimeTrack::updateMinMax(const Meas &value) {
 
 Status TimeTrack::append(const Meas &value) {
   std::lock_guard<utils::async::Locker> lg(_locker);
+  return append_value(value);
+}
+
+size_t TimeTrack::append(const MeasArray::const_iterator &begin,
+                         const MeasArray::const_iterator &end, Status *status) {
+  std::lock_guard<utils::async::Locker> lg(_locker);
+  size_t result = 0;
+  for (auto it = begin; it != end; ++it, ++result) {
+    auto st = append_value(*it);
+    if (st.writed == 0) { // no free chunks.
+      break;
+    }
+    if (st.ignored != 0) { // write to past.
+      status->ignored++;
+    } else {
+      status->writed++;
+    }
+  }
+  return result;
+}
+
+Status TimeTrack::append_value(const Meas &value) {
+  if (_reorder_window == 0) {
+    return append_to_chunks(value);
+  }
+
+  auto is_past = [this](const Meas &v) {
+    return _cur_chunk != nullptr && v.time <= _cur_chunk->header->maxTime;
+  };
+  auto pos = std::lower_bound(_reorder_buffer.begin(), _reorder_buffer.end(), value,
+                              meas_time_compare_less());
+  if (is_past(value) || (pos != _reorder_buffer.end() && pos->time == value.time)) {
+    logger_fatal("engine: memstorage - id:", this->_meas_id, ", can't write to past.");
+    return Status(1, 1);
+  }
+
+  auto max_time = value.time;
+  if (!_reorder_buffer.empty()) {
+    max_time = std::max(max_time, _reorder_buffer.back().time);
+  }
+  if (!flush_buffer_to(max_time)) {
+    return Status(0, 1);
+  }
+
+  if (max_time - value.time > _reorder_window) { // too late for buffer.
+    if (is_past(value)) {
+      logger_fatal("engine: memstorage - id:", this->_meas_id, ", can't write to past.");
+      return Status(1, 1);
+    }
+    return append_to_chunks(value);
+  }
+  pos = std::upper_bound(_reorder_buffer.begin(), _reorder_buffer.end(), value,
+                         meas_time_compare_less());
+  {
+    std::lock_guard<std::shared_mutex> lg(_chunks_locker);
+    _reorder_buffer.insert(pos, value);
+  }
+  updateMinMax(value);
+  return Status(1, 0);
+}
+
+bool TimeTrack::flush_buffer_to(Time max_time) {
+  size_t count = 0;
+  while (count < _reorder_buffer.size() &&
+         max_time - _reorder_buffer[count].time > _reorder_window) {
+    ++count;
+  }
+  return move_to_chunks(count);
+}
+
+bool TimeTrack::move_to_chunks(size_t count) {
+  size_t moved = 0;
+  bool result = true;
+  for (; moved < count; ++moved) {
+    if (append_to_chunks(_reorder_buffer[moved]).writed == 0) {
+      result = false;
+      break;
+    }
+  }
+  if (moved != 0) {
+    std::lock_guard<std::shared_mutex> lg(_chunks_locker);
+    _reorder_buffer.erase(_reorder_buffer.begin(), _reorder_buffer.begin() + moved);
+  }
+  return result;
+}
+
+bool TimeTrack::flush_buffer() {
+  std::lock_guard<utils::async::Locker> lg(_locker);
+  return move_to_chunks(_reorder_buffer.size());
+}
+
+Status TimeTrack::append_to_chunks(const Meas &value) {
   if (_cur_chunk == nullptr || _cur_chunk->isFull()) {
     if (!create_new_chunk(value)) {
       return Status(0, 1);
@@ -44,6 +141,7 @@ Status TimeTrack::append(const Meas &value) {
         return Status(1, 0);
       }
     }
+    _cur_chunk->publish();
   } else {
     logger_fatal("engine: memstorage - id:", this->_meas_id, ", can't write to past.");
     return Status(1, 1);
@@ -67,7 +165,7 @@ bool TimeTrack::minMaxTime(dariadb::Id id, dariadb::Time *minResult,
   if (id != this->_meas_id) {
     return false;
   }
-  std::lock_guard<utils::async::Locker> lg(_locker);
+  std::shared_lock<std::shared_mutex> lg(_chunks_locker);
   *minResult = MAX_TIME;
   *maxResult = MIN_TIME;
   for (auto kv : _index) {
@@ -77,13 +175,17 @@ bool TimeTrack::minMaxTime(dariadb::Id id, dariadb::Time *minResult,
   }
   if (_cur_chunk != nullptr) {
     *minResult = std::min(_cur_chunk->header->minTime, *minResult);
-    *maxResult = std::max(_cur_chunk->header->maxTime, *maxResult);
+    *maxResult = std::max(_cur_chunk->published().maxTime, *maxResult);
+  }
+  if (!_reorder_buffer.empty()) {
+    *minResult = std::min(_reorder_buffer.front().time, *minResult);
+    *maxResult = std::max(_reorder_buffer.back().time, *maxResult);
   }
   return true;
 }
 
 void TimeTrack::foreach (const QueryInterval &q, IReaderClb * clbk) {
-  std::lock_guard<utils::async::Locker> lg(_locker);
+  std::shared_lock<std::shared_mutex> lg(_chunks_locker);
 
   auto end = _index.upper_bound(q.to);
   auto begin = _index.lower_bound(q.from);
@@ -98,109 +200,183 @@ void TimeTrack::foreach (const QueryInterval &q, IReaderClb * clbk) {
       break;
     }
     auto c = it->second;
-    foreach_interval_call(c, q, clbk);
+    if (c->visible(q.version)) {
+      foreach_interval_call(c, c->published(), q, clbk);
+    }
   }
-  if (_cur_chunk != nullptr) {
-    foreach_interval_call(_cur_chunk, q, clbk);
+  // buffered values, moved to published part of current chunk, are readed from chunk.
+  auto from_buffer = _reorder_buffer.cbegin();
+  if (_cur_chunk != nullptr && _cur_chunk->visible(q.version)) {
+    auto fill = _cur_chunk->published();
+    foreach_interval_call(_cur_chunk, fill, q, clbk);
+    from_buffer = std::upper_bound(
+        _reorder_buffer.cbegin(), _reorder_buffer.cend(), fill.maxTime,
+        [](const Time t, const Meas &v) { return t < v.time; });
+  }
+  ReaderClb_Batch batch(clbk);
+  for (auto it = from_buffer; it != _reorder_buffer.cend(); ++it) {
+    auto &v = *it;
+    if (clbk->is_canceled()) {
+      break;
+    }
+    if (utils::inInterval(q.from, q.to, v.time)) {
+      batch.append(v);
+    }
   }
 }
 
-void TimeTrack::foreach_interval_call(const MemChunk_Ptr &c, const QueryInterval &q,
-                                      IReaderClb *clbk) {
-  if (utils::inInterval(c->header->minTime, c->header->maxTime, q.from) ||
-      utils::inInterval(c->header->minTime, c->header->maxTime, q.to) ||
+void TimeTrack::foreach_interval_call(const MemChunk_Ptr &c, const MemChunk::Fill &fill,
+                                      const QueryInterval &q, IReaderClb *clbk) {
+  if (utils::inInterval(c->header->minTime, fill.maxTime, q.from) ||
+      utils::inInterval(c->header->minTime, fill.maxTime, q.to) ||
       utils::inInterval(q.from, q.to, c->header->minTime) ||
-      utils::inInterval(q.from, q.to, c->header->maxTime)) {
+      utils::inInterval(q.from, q.to, fill.maxTime)) {
 
-    auto rdr = c->getReader();
+    auto erased = erased_in(c);
+    if (erased.covers(c->header->minTime, fill.maxTime)) {
+      return;
+    }
+    ReaderClb_Batch batch(clbk);
+    auto rdr = c->getReader(fill);
     while (!rdr->is_end()) {
       if (clbk->is_canceled()) {
         break;
       }
       auto v = rdr->readNext();
-      if (utils::inInterval(q.from, q.to, v.time)) {
-        clbk->call(v);
+      if (utils::inInterval(q.from, q.to, v.time) && !erased.contains(v.time)) {
+        batch.append(v);
       }
     }
   }
 }
 
 Id2Meas TimeTrack::readTimePoint(const QueryTimePoint &q) {
-  std::lock_guard<utils::async::Locker> lg(_locker);
+  std::shared_lock<std::shared_mutex> lg(_chunks_locker);
   Id2Meas result;
-  result[this->_meas_id].flag = Flags::_NO_DATA;
+  auto &last = result[this->_meas_id];
+  last.flag = Flags::_NO_DATA;
 
-  auto end = _index.upper_bound(q.time_point);
-  auto begin = _index.lower_bound(q.time_point);
-  if (begin != _index.begin()) {
-    --begin;
+  // chunks are ordered by max time: from chunk with time point to older ones,
+  // while they can contain newer value. erased values can be in all of them.
+  auto it = _index.lower_bound(q.time_point);
+  if (it != _index.end()) {
+    ++it;
   }
-
-  for (auto it = begin; it != end; ++it) {
-    if (it == _index.end()) {
+  while (it != _index.begin()) {
+    --it;
+    if (last.flag != Flags::_NO_DATA && it->first < last.time) {
       break;
     }
     auto c = it->second;
-    if (c->header->minTime >= q.time_point && c->header->maxTime <= q.time_point) {
-      auto rdr = c->getReader();
-      // auto skip = c->in_disk_count;
-      while (!rdr->is_end()) {
-        auto v = rdr->readNext();
-        /*if (skip != 0) {
-        --skip;
-        }
-        else*/
-        {
-          if (v.time > result[this->_meas_id].time && v.time <= q.time_point) {
-            result[this->_meas_id] = v;
-          }
-        }
-      }
+    if (c->visible(q.version)) {
+      time_point_call(c, c->published(), q, &last);
     }
   }
 
-  if (_cur_chunk != nullptr && _cur_chunk->header->minTime >= q.time_point &&
-      _cur_chunk->header->maxTime <= q.time_point) {
-    auto rdr = _cur_chunk->getReader();
-    // auto skip = _cur_chunk->in_disk_count;
-    while (!rdr->is_end()) {
-      auto v = rdr->readNext();
-      /*if (skip != 0)
-      {
-      --skip;
-      }
-      else*/
-      {
-        if (v.time > result[this->_meas_id].time && v.time <= q.time_point) {
-          result[this->_meas_id] = v;
-        }
-      }
+  if (_cur_chunk != nullptr && _cur_chunk->visible(q.version)) {
+    time_point_call(_cur_chunk, _cur_chunk->published(), q, &last);
+  }
+  for (auto &v : _reorder_buffer) {
+    if (v.time > q.time_point) {
+      break;
+    }
+    if (v.time > last.time) {
+      last = v;
     }
   }
-  if (result[this->_meas_id].flag == Flags::_NO_DATA) {
-    result[this->_meas_id].time = q.time_point;
+  if (last.flag == Flags::_NO_DATA) {
+    last.time = q.time_point;
   }
   return result;
 }
 
+void TimeTrack::time_point_call(const MemChunk_Ptr &c, const MemChunk::Fill &fill,
+                                const QueryTimePoint &q, Meas *result) {
+  if (c->header->minTime > q.time_point) {
+    return;
+  }
+  auto erased = erased_in(c);
+  auto rdr = c->getReader(fill);
+  while (!rdr->is_end()) {
+    auto v = rdr->readNext();
+    if (v.time > result->time && v.time <= q.time_point && !erased.contains(v.time)) {
+      *result = v;
+    }
+  }
+}
+
 Id2Meas TimeTrack::currentValue(const IdArray &ids, const Flag &flag) {
   ENSURE(ids.size() == size_t(1));
   ENSURE(ids[0] == this->_meas_id);
   std::lock_guard<utils::async::Locker> lg(_locker);
   Id2Meas result;
+  Meas last;
+  last.flag = Flags::_NO_DATA;
+  if (!_reorder_buffer.empty()) {
+    last = _reorder_buffer.back();
+  } else if (_cur_chunk != nullptr &&
+             !erased_in(_cur_chunk).contains(_cur_chunk->header->maxTime)) {
+    last = _cur_chunk->header->last();
+  } else if (_cur_chunk != nullptr || !_index.empty()) { // erased or sealed.
+    last = lastNotErased(flag);
+  }
+  if (last.flag != Flags::_NO_DATA && last.inFlag(flag)) {
+    result[_meas_id] = last;
+    return result;
+  }
+  result[_meas_id].flag = Flags::_NO_DATA;
+  return result;
+}
+
+Meas TimeTrack::lastNotErased(const Flag &flag) {
+  Meas result;
+  result.flag = Flags::_NO_DATA;
+  result.time = MIN_TIME;
+  auto check_chunk = [this, &result, &flag](const MemChunk_Ptr &c) {
+    auto erased = erased_in(c);
+    auto rdr = c->getReader();
+    while (!rdr->is_end()) {
+      auto v = rdr->readNext();
+      if (v.time >= result.time && v.inFlag(flag) && !erased.contains(v.time)) {
+        result = v;
+      }
+    }
+  };
+  for (auto &kv : _index) {
+    check_chunk(kv.second);
+  }
   if (_cur_chunk != nullptr) {
-    auto last = _cur_chunk->header->last();
-    if (last.inFlag(flag)) {
-      result[_meas_id] = last;
-      return result;
+    check_chunk(_cur_chunk);
+  }
+  for (auto &v : _reorder_buffer) {
+    if (v.inFlag(flag)) {
+      result = v;
     }
   }
-  result[_meas_id].flag = Flags::_NO_DATA;
   return result;
 }
 
+void TimeTrack::seal(Time from, Time to) {
+  {
+    std::lock_guard<utils::async::Locker> lg(_locker);
+    std::lock_guard<std::shared_mutex> chunks_lg(_chunks_locker);
+    _reorder_buffer.erase(std::remove_if(_reorder_buffer.begin(), _reorder_buffer.end(),
+                                         [from, to](const Meas &v) {
+                                           return utils::inInterval(from, to, v.time);
+                                         }),
+                          _reorder_buffer.end());
+    if (_cur_chunk != nullptr) {
+      this->_index.insert(std::make_pair(_cur_chunk->header->maxTime, _cur_chunk));
+      _mcc->closeChunk(_cur_chunk);
+      _cur_chunk = nullptr;
+    }
+  }
+  rereadMinMax();
+}
+
 void TimeTrack::rm_chunk(MemChunk *c) {
   std::lock_guard<utils::async::Locker> lg(_locker);
+  std::lock_guard<std::shared_mutex> chunks_lg(_chunks_locker);
   _index.erase(c->header->maxTime);
 
   if (_cur_chunk.get() == c) {
@@ -210,26 +386,42 @@ void TimeTrack::rm_chunk(MemChunk *c) {
 
 void TimeTrack::rereadMinMax() {
   std::lock_guard<utils::async::Locker> lg(_locker);
+  // track without values has empty bounds, as a new one: min of next value
+  // must not be hidden by min of dropped chunks.
   _min_max.max.time = MIN_TIME;
-  _min_max.min.time = MIN_TIME;
+  _min_max.min.time = MAX_TIME;
 
-  if (_index.size() != 0) {
-    auto c = _index.begin()->second;
-    _min_max.min = c->header->first();
+  // dropped chunks are skipped.
+  auto first = std::find_if(_index.begin(), _index.end(),
+                            [](auto &kv) { return !kv.second->removed(); });
+  if (first != _index.end()) {
+    _min_max.min = first->second->header->first();
   } else {
-    if (this->_cur_chunk != nullptr) {
+    if (this->_cur_chunk != nullptr && !_cur_chunk->removed()) {
       _min_max.min = _cur_chunk->header->first();
+    } else if (!_reorder_buffer.empty()) {
+      _min_max.min = _reorder_buffer.front();
     }
   }
 
-  if (this->_cur_chunk != nullptr) {
+  if (!_reorder_buffer.empty()) {
+    _min_max.max = _reorder_buffer.back();
+  } else if (this->_cur_chunk != nullptr && !_cur_chunk->removed()) {
     _min_max.max = _cur_chunk->header->last();
+  } else { // current chunk is closed by seal.
+    auto last = std::find_if(_index.rbegin(), _index.rend(),
+                             [](auto &kv) { return !kv.second->removed(); });
+    if (last != _index.rend()) {
+      _min_max.max = last->second->header->last();
+    }
   }
 }
 
 bool TimeTrack::create_new_chunk(const Meas &value) {
+  std::lock_guard<std::shared_mutex> lg(_chunks_locker);
   if (_cur_chunk != nullptr) {
     this->_index.insert(std::make_pair(_cur_chunk->header->maxTime, _cur_chunk));
+    _mcc->closeChunk(_cur_chunk);
     _cur_chunk = nullptr;
   }
   auto new_chunk_data = _allocator->allocate();
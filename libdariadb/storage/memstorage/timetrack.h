@@ -2,7 +2,9 @@
 
 #include <libdariadb/interfaces/imeasstorage.h>
 #include <libdariadb/storage/memstorage/memchunk.h>
+#include <libdariadb/storage/tombstones.h>
 #include <extern/stx-btree/include/stx/btree_map.h>
+#include <shared_mutex>
 
 namespace dariadb {
 namespace storage {
@@ -10,29 +12,66 @@ namespace storage {
 class MemoryChunkContainer {
 public:
   virtual void addChunk(MemChunk_Ptr &c) = 0;
+  /// chunk will not be changed anymore.
+  virtual void closeChunk(const MemChunk_Ptr &c) = 0;
   virtual ~MemoryChunkContainer() {}
 };
 
+/// values not older than 'reorder_window' from max time are kept in sorted
+/// buffer and moved to chunks later. older values are rejected.
+/// writers are serialized by '_locker'. readers take '_chunks_locker' shared and
+/// see only published part of current chunk, so append to current chunk
+/// is not blocked by readers. writer takes '_chunks_locker' exclusively,
+/// when chunks are rotated or reorder buffer is changed.
+/// dropped chunks stay in track, while readers of older versions use them.
 struct TimeTrack : public IMeasStorage {
   TimeTrack(MemoryChunkContainer *mcc, const Time step, Id meas_id,
-            MemChunkAllocator *allocator);
+            MemChunkAllocator *allocator, const Tombstones *tombstones = nullptr,
+            const Time reorder_window = 0);
   ~TimeTrack();
   void updateMinMax(const Meas &value);
   virtual Status append(const Meas &value) override;
+  /// append values under one lock. returns count of processed values:
+  /// stops on value, which needs a new chunk while allocator is full.
+  size_t append(const MeasArray::const_iterator &begin,
+                const MeasArray::const_iterator &end, Status *status);
+  /// move all buffered values to chunks. false if memory is full.
+  bool flush_buffer();
   void flush() override;
   Time minTime() override;
   Time maxTime() override;
   bool minMaxTime(dariadb::Id id, dariadb::Time *minResult,
                   dariadb::Time *maxResult) override;
   void foreach (const QueryInterval &q, IReaderClb * clbk) override;
-  void foreach_interval_call(const MemChunk_Ptr &c, const QueryInterval &q,
-                             IReaderClb *clbk);
+  void foreach_interval_call(const MemChunk_Ptr &c, const MemChunk::Fill &fill,
+                             const QueryInterval &q, IReaderClb *clbk);
+  void time_point_call(const MemChunk_Ptr &c, const MemChunk::Fill &fill,
+                       const QueryTimePoint &q, Meas *result);
   Id2Meas readTimePoint(const QueryTimePoint &q) override;
   virtual Id2Meas currentValue(const IdArray &ids, const Flag &flag) override;
 
+  /// intervals of tombstones, which cover values of chunk.
+  /// buffered values are not covered: they are removed by seal.
+  ErasedIntervals erased_in(const MemChunk_Ptr &c) const {
+    if (_tombstones == nullptr) {
+      return ErasedIntervals();
+    }
+    return _tombstones->erased(_meas_id, LEVEL::MEMORY, c->seq);
+  }
+  /// called by erase: current chunk is closed, buffered values in [from,to] are removed.
+  void seal(Time from, Time to);
+  /// last not erased value. used when last value was erased.
+  Meas lastNotErased(const Flag &flag);
+
   void rm_chunk(MemChunk *c);
   void rereadMinMax();
   bool create_new_chunk(const Meas &value);
+  Status append_value(const Meas &value);
+  Status append_to_chunks(const Meas &value);
+  /// move buffered values older than 'max_time - _reorder_window' to chunks.
+  bool flush_buffer_to(Time max_time);
+  /// move first 'count' buffered values to chunks.
+  bool move_to_chunks(size_t count);
 
   MemChunkAllocator *_allocator;
   Id _meas_id;
@@ -41,8 +80,12 @@ struct TimeTrack : public IMeasStorage {
   Time _step;
   MemChunk_Ptr _cur_chunk;
   utils::async::Locker _locker;
+  std::shared_mutex _chunks_locker;
   stx::btree_map<Time, MemChunk_Ptr> _index;
   MemoryChunkContainer *_mcc;
+  const Tombstones *_tombstones;
+  Time _reorder_window;
+  std::vector<Meas> _reorder_buffer; // sorted by time.
 };
 
 using TimeTrack_ptr = std::shared_ptr<TimeTrack>;
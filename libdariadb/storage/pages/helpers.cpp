@@ -6,6 +6,7 @@
 #include <libdariadb/storage/pages/helpers.h>
 #include <libdariadb/storage/pages/page.h>
 #include <libdariadb/utils/async/thread_manager.h>
+#include <libdariadb/utils/radix_sort.h>
 #include <algorithm>
 
 #include <cstring>
@@ -25,51 +26,23 @@ dariadb::storage::PageHeader emptyPageHeader(uint64_t chunk_id) {
   return phdr;
 }
 
-std::map<Id, MeasArray> splitById(const MeasArray &ma) {
-  dariadb::IdSet dropped;
-  auto count = ma.size();
-  std::vector<bool> visited(count);
-  auto begin = ma.cbegin();
-  auto end = ma.cend();
-  size_t i = 0;
-  std::map<Id, MeasArray> result;
-  MeasArray current_id_values;
-  current_id_values.resize(ma.size());
-
-  ENSURE(current_id_values.size() != 0);
-  ENSURE(current_id_values.size() == ma.size());
-
-  for (auto it = begin; it != end; ++it, ++i) {
-    if (visited[i]) {
-      continue;
-    }
-    if (dropped.find(it->id) != dropped.end()) {
-      continue;
-    }
-
-    visited[i] = true;
-    size_t current_id_values_pos = 0;
-    current_id_values[current_id_values_pos++] = *it;
-    size_t pos = 0;
-    for (auto sub_it = begin; sub_it != end; ++sub_it, ++pos) {
-      if (visited[pos]) {
-        continue;
-      }
-      if ((sub_it->id == it->id)) {
-        current_id_values[current_id_values_pos++] = *sub_it;
-        visited[pos] = true;
-      }
-    }
-    dropped.insert(it->id);
-    result.insert(std::make_pair(
-        it->id, MeasArray{current_id_values.begin(),
-                          current_id_values.begin() + current_id_values_pos}));
-    current_id_values_pos = 0;
+std::map<Id, MeasSpan> splitById(MeasArray &ma) {
+  ENSURE(ma.size() != 0);
+  utils::radix_sort(ma);
+
+  std::map<Id, MeasSpan> result;
+  auto begin = ma.data();
+  auto end = begin + ma.size();
+  while (begin != end) {
+    auto id = begin->id;
+    auto run_end = std::find_if(begin, end, [id](const Meas &m) { return m.id != id; });
+    result.emplace_hint(result.end(), id, MeasSpan{begin, run_end});
+    begin = run_end;
   }
   return result;
 }
 
-std::list<HdrAndBuffer> compressValues(std::map<Id, MeasArray> &to_compress,
+std::list<HdrAndBuffer> compressValues(std::map<Id, MeasSpan> &to_compress,
                                        PageHeader &phdr, uint32_t max_chunk_size) {
   using namespace dariadb::utils::async;
   std::list<HdrAndBuffer> results;
@@ -82,8 +55,8 @@ std::list<HdrAndBuffer> compressValues(std::map<Id, MeasArray> &to_compress,
       using namespace dariadb::utils::async;
       TKIND_CHECK(dariadb::utils::async::THREAD_KINDS::COMMON, ti.kind);
       auto fit = to_compress.find(cur_Id);
-      auto begin = fit->second.cbegin();
-      auto end = fit->second.cend();
+      auto begin = fit->second.begin;
+      auto end = fit->second.end;
       auto it = begin;
       while (it != end) {
         ChunkHeader hdr;
@@ -9,16 +9,20 @@
 namespace dariadb {
 namespace storage {
 namespace PageInner {
-struct HdrAndBuffer {
-  dariadb::storage::ChunkHeader hdr;
-  std::shared_ptr<uint8_t> buffer;
+using HdrAndBuffer = PageChunkBuffer;
+
+/// values of one id, sorted by time. points to source array.
+struct MeasSpan {
+  const Meas *begin;
+  const Meas *end;
 };
 
 dariadb::storage::PageHeader emptyPageHeader(uint64_t chunk_id);
 
-std::map<Id, MeasArray> splitById(const MeasArray &ma);
+/// sort 'ma' by (id, time) and split to runs of one id. values are not copied.
+std::map<Id, MeasSpan> splitById(MeasArray &ma);
 
-std::list<HdrAndBuffer> compressValues(std::map<Id, MeasArray> &to_compress,
+std::list<HdrAndBuffer> compressValues(std::map<Id, MeasSpan> &to_compress,
                                        PageHeader &phdr, uint32_t max_chunk_size);
 
 uint64_t writeToFile(FILE *file, FILE *index_file, PageHeader &phdr, IndexHeader &,
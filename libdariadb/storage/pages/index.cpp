@@ -17,16 +17,9 @@ inline bool check_index_rec(IndexReccord &it, dariadb::Time from, dariadb::Time
          inInterval(it.minTime, it.maxTime, to);
 }
 
-inline bool check_blooms(const IndexReccord &_index_it, dariadb::Id id,
-                         dariadb::Flag flag) {
-  auto id_check_result = false;
-  id_check_result = _index_it.meas_id == id;
-  auto flag_bloom_result = false;
-  if (flag == dariadb::Flag(0) ||
-      dariadb::storage::bloom_check(_index_it.flag_bloom, flag)) {
-    flag_bloom_result = true;
-  }
-  return id_check_result && flag_bloom_result;
+inline bool check_flag_bloom(const IndexReccord &_index_it, dariadb::Flag flag) {
+  return flag == dariadb::Flag(0) ||
+         dariadb::storage::bloom_check(_index_it.flag_bloom, flag);
 }
 
 PageIndex::~PageIndex() {}
@@ -54,6 +47,8 @@ ChunkLinkList PageIndex::get_chunks_links(const dariadb::IdArray &ids, dariadb::
     THROW_EXCEPTION("engine: index read error - ", this->filename);
   }
   std::fclose(index_file);
+  // record links chunk of one id, so query ids are checked by one search.
+  dariadb::IdSet id_set(ids.begin(), ids.end());
   for (uint32_t pos = 0; pos < this->iheader.count; ++pos) {
 
     auto _index_it = records[pos];
@@ -62,12 +57,8 @@ ChunkLinkList PageIndex::get_chunks_links(const dariadb::IdArray &ids, dariadb::
       if (ids.size() == size_t(0)) {
         bloom_result = true;
       } else {
-        for (auto i : ids) {
-          bloom_result = check_blooms(_index_it, i, flag);
-          if (bloom_result) {
-            break;
-          }
-        }
+        bloom_result = id_set.find(_index_it.meas_id) != id_set.end() &&
+                       check_flag_bloom(_index_it, flag);
       }
       if (bloom_result) {
         ChunkLink sub_result;
@@ -6,6 +6,7 @@
 #include <libdariadb/storage/callbacks.h>
 #include <libdariadb/storage/pages/helpers.h>
 #include <libdariadb/storage/pages/page.h>
+#include <libdariadb/storage/tombstones.h>
 #include <libdariadb/timeutil.h>
 #include <libdariadb/utils/async/thread_manager.h>
 #include <libdariadb/utils/exception.h>
@@ -29,12 +30,29 @@ uint64_t Page::index_file_size(uint32_t chunk_per_storage) {
 
 Page_Ptr Page::create(const std::string &file_name, uint64_t chunk_id,
                    uint32_t max_chunk_size, const MeasArray &ma) {
+  MeasArray values(ma);
+  auto prepared = prepare(max_chunk_size, values);
+  return create(file_name, chunk_id, prepared);
+}
+
+PreparedPage Page::prepare(uint32_t max_chunk_size, MeasArray &ma) {
   auto to_compress = PageInner::splitById(ma);
 
-  PageHeader phdr = PageInner::emptyPageHeader(chunk_id);
+  PreparedPage result;
+  result.header = PageInner::emptyPageHeader(0);
+  result.chunks = PageInner::compressValues(to_compress, result.header, max_chunk_size);
+  return result;
+}
+
+Page_Ptr Page::create(const std::string &file_name, uint64_t chunk_id,
+                   PreparedPage &prepared) {
+  PageHeader phdr = prepared.header;
+  phdr.max_chunk_id += chunk_id;
+  for (auto &c : prepared.chunks) {
+    c.hdr.id += chunk_id;
+  }
+  auto &compressed_results = prepared.chunks;
 
-  std::list<PageInner::HdrAndBuffer> compressed_results =
-      PageInner::compressValues(to_compress, phdr, max_chunk_size);
   auto file = std::fopen(file_name.c_str(), "ab");
   if (file == nullptr) {
     THROW_EXCEPTION("file is null");
@@ -73,13 +91,15 @@ Page_Ptr Page::make_page(const std::string &file_name, const PageHeader &phdr) {
 // COMPACTION
 Page_Ptr Page::create(const std::string &file_name, uint64_t chunk_id,
                    uint32_t max_chunk_size,
-                   const std::list<std::string> &pages_full_paths) {
+                   const std::list<std::string> &pages_full_paths,
+                   const Tombstones *tombstones) {
   std::unordered_map<std::string, Page_Ptr> openned_pages;
   openned_pages.reserve(pages_full_paths.size());
   std::map<uint64_t, ChunkLinkList> links;
   QueryInterval qi({}, 0, MIN_TIME, MAX_TIME);
   for (auto &p_full_path : pages_full_paths) {
-	Page_Ptr p = Page::open(p_full_path);
+    Page_Ptr p = Page::open(p_full_path);
+    p->tombstones = tombstones;
     openned_pages.emplace(std::make_pair(p_full_path, p));
 
     auto clinks = p->chunksByIterval(qi);
@@ -128,9 +148,14 @@ Page_Ptr Page::create(const std::string &file_name, uint64_t chunk_id,
     for (auto &time2meas : values_map) {
       sorted_and_filtered.push_back(time2meas.second);
     }
+    if (sorted_and_filtered.empty()) { // all values was erased.
+      continue;
+    }
 
-    std::map<Id, MeasArray> all_values;
-    all_values[sorted_and_filtered.front().id] = sorted_and_filtered;
+    std::map<Id, PageInner::MeasSpan> all_values;
+    auto values_begin = sorted_and_filtered.data();
+    all_values[sorted_and_filtered.front().id] =
+        PageInner::MeasSpan{values_begin, values_begin + sorted_and_filtered.size()};
 
     auto compressed_results = PageInner::compressValues(all_values, phdr, max_chunk_size);
 
@@ -402,7 +427,16 @@ dariadb::Id2Meas Page::valuesBeforeTimePoint(const QueryTimePoint &q) {
     if (to_read.empty()) {
       break;
     }
+    // chunk has no values newer than already readed.
+    auto readed = result.find(it->meas_id);
+    if (readed != result.end() && readed->second.time >= it->maxTime) {
+      continue;
+    }
     auto _index_it = indexReccords[it->index_rec_number];
+    auto erased = erased_in(_index_it);
+    if (erased.covers(_index_it.minTime, _index_it.maxTime)) {
+      continue;
+    }
     Chunk_Ptr c = readChunkByOffset(page_io, _index_it.offset);
     if (c == nullptr) {
       continue;
@@ -410,13 +444,17 @@ dariadb::Id2Meas Page::valuesBeforeTimePoint(const QueryTimePoint &q) {
     auto reader = c->getReader();
     while (!reader->is_end()) {
       auto m = reader->readNext();
-      if (m.time <= q.time_point && m.inQuery(q.ids, q.flag)) {
+      // chunk contains values of one id from query.
+      if (m.time <= q.time_point && m.id == it->meas_id && m.inFlag(q.flag)) {
+        if (erased.contains(m.time)) {
+          continue;
+        }
         auto f_res = result.find(m.id);
         if (f_res == result.end()) {
           to_read.erase(m.id);
           result[m.id] = m;
         } else {
-          if (m.time > f_res->first) {
+          if (m.time > f_res->second.time) {
             result[m.id] = m;
           }
         }
@@ -439,11 +477,16 @@ void Page::readLinks(const QueryInterval &query, const ChunkLinkList &links,
     THROW_EXCEPTION("can`t open file ", this->filename);
   }
   auto indexReccords = _index->readReccords();
+  ReaderClb_Batch batch(clbk);
   for (; _ch_links_iterator != links.cend(); ++_ch_links_iterator) {
     if (clbk->is_canceled()) {
       break;
     }
     auto _index_it = indexReccords[_ch_links_iterator->index_rec_number];
+    auto erased = erased_in(_index_it);
+    if (erased.covers(_index_it.minTime, _index_it.maxTime)) {
+      continue;
+    }
     Chunk_Ptr search_res = readChunkByOffset(page_io, _index_it.offset);
     if (search_res == nullptr) {
       continue;
@@ -455,13 +498,24 @@ void Page::readLinks(const QueryInterval &query, const ChunkLinkList &links,
         break;
       }
       if (subres.inQuery(query.ids, query.flag, query.from, query.to)) {
-        clbk->call(subres);
+        if (erased.contains(subres.time)) {
+          continue;
+        }
+        batch.append(subres);
       }
     }
+    batch.flush();
   }
   fclose(page_io);
 }
 
+ErasedIntervals Page::erased_in(const IndexReccord &rec) const {
+  if (tombstones == nullptr) {
+    return ErasedIntervals();
+  }
+  return tombstones->erased(Id(rec.meas_id), LEVEL::PAGES, rec.chunk_id);
+}
+
 void Page::appendChunks(const std::vector<Chunk *> &, size_t) {
   NOT_IMPLEMENTED;
 }
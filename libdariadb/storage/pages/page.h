@@ -5,10 +5,14 @@
 #include <libdariadb/storage/chunk.h>
 #include <libdariadb/storage/pages/index.h>
 #include <libdariadb/utils/fs.h>
+#include <list>
 
 namespace dariadb {
 namespace storage {
 
+class Tombstones;
+struct ErasedIntervals;
+
 const std::string PAGE_FILE_EXT = ".page"; // cola-file extension
 
 #pragma pack(push, 1)
@@ -22,6 +26,17 @@ struct PageHeader {
 };
 #pragma pack(pop)
 
+struct PageChunkBuffer {
+  ChunkHeader hdr;
+  std::shared_ptr<uint8_t> buffer;
+};
+
+/// compressed chunks of page, not written yet. chunk ids are relative to zero.
+struct PreparedPage {
+  PageHeader header;
+  std::list<PageChunkBuffer> chunks;
+};
+
 class Page;
 typedef std::shared_ptr<Page> Page_Ptr;
 
@@ -32,10 +47,16 @@ public:
   /// called by Dropper from Wal level.
   EXPORT static Page_Ptr create(const std::string &file_name, uint64_t chunk_id,
                              uint32_t max_chunk_size, const MeasArray &ma);
-  /// used for compaction many pages to one
+  /// split 'ma' by id and compress to chunks. no disk io. 'ma' is sorted by (id, time).
+  EXPORT static PreparedPage prepare(uint32_t max_chunk_size, MeasArray &ma);
+  /// write chunks from 'prepare'. chunk ids are started from 'chunk_id'.
+  EXPORT static Page_Ptr create(const std::string &file_name, uint64_t chunk_id,
+                             PreparedPage &prepared);
+  /// used for compaction many pages to one. erased values are dropped.
   EXPORT static Page_Ptr create(const std::string &file_name, uint64_t chunk_id,
                              uint32_t max_chunk_size,
-                             const std::list<std::string> &pages_full_paths);
+                             const std::list<std::string> &pages_full_paths,
+                             const Tombstones *tombstones = nullptr);
   /// called by dropper from MemoryStorage.
   EXPORT static Page_Ptr create(const std::string &file_name, uint64_t chunk_id,
                              const std::vector<Chunk *> &a, size_t count);
@@ -67,10 +88,14 @@ private:
 
   static Page_Ptr make_page(const std::string &file_name, const PageHeader &phdr);
   Chunk_Ptr readChunkByOffset(FILE *page_io, int offset);
+  /// intervals of tombstones, which cover chunk of index record.
+  ErasedIntervals erased_in(const IndexReccord &rec) const;
 
 public:
   PageHeader header;
   std::string filename;
+  /// values covered by tombstones are skipped by readers.
+  const Tombstones *tombstones = nullptr;
 
 protected:
   PageIndex_ptr _index;
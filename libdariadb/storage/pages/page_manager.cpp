@@ -3,10 +3,14 @@
 #endif
 #include <libdariadb/flags.h>
 #include <libdariadb/storage/bloom_filter.h>
+#include <libdariadb/storage/level_catalog.h>
 #include <libdariadb/storage/manifest.h>
+#include <libdariadb/storage/partition.h>
 #include <libdariadb/storage/pages/page.h>
 #include <libdariadb/storage/pages/page_manager.h>
 #include <libdariadb/storage/settings.h>
+#include <libdariadb/storage/tombstones.h>
+#include <libdariadb/storage/version_set.h>
 #include <libdariadb/utils/async/locker.h>
 #include <libdariadb/utils/async/thread_manager.h>
 #include <libdariadb/utils/fs.h>
@@ -17,9 +21,11 @@
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <shared_mutex>
 #include <thread>
 
 #include <stx/btree_multimap.h>
@@ -28,29 +34,76 @@ using namespace dariadb::storage;
 using namespace dariadb::utils::async;
 
 struct PageHeaderDescription {
-  std::string path;
+  std::string path; // relative to raw_path: "partition/name.page" or "name.page"
+  std::string partition;
   IndexHeader hdr;
+  VersionStamp stamp;
 };
 
 using File2PageHeader = stx::btree_multimap<dariadb::Time, PageHeaderDescription>;
 
+struct PartitionDescription {
+  dariadb::Time minTime = dariadb::MAX_TIME;
+  dariadb::Time maxTime = dariadb::MIN_TIME;
+  File2PageHeader pages;
+};
+/// pages without partition stored in partition with empty name.
+/// removed pages are kept, while readers of older versions use them.
+using Partition2Pages = std::map<std::string, PartitionDescription>;
+
+std::string partition_of_page(const std::string &page_name) {
+  auto pos = page_name.find('/');
+  if (pos == std::string::npos) {
+    return std::string();
+  }
+  return page_name.substr(0, pos);
+}
+
 class PageManager::Private {
 public:
   Private(const EngineEnvironment_ptr env) : _cur_page(nullptr) {
 
     _env = env;
     _settings = _env->getResourceObject<Settings>(EngineEnvironment::Resource::SETTINGS);
+    _tombstones = nullptr;
+    if (_env->hasResource(EngineEnvironment::Resource::TOMBSTONES)) {
+      _tombstones =
+          _env->getResourceObject<Tombstones>(EngineEnvironment::Resource::TOMBSTONES);
+    }
+    _versions = nullptr;
+    if (_env->hasResource(EngineEnvironment::Resource::VERSIONS)) {
+      _versions =
+          _env->getResourceObject<VersionSet>(EngineEnvironment::Resource::VERSIONS);
+    }
+    _catalog = nullptr;
+    if (_env->hasResource(EngineEnvironment::Resource::CATALOG)) {
+      _catalog =
+          _env->getResourceObject<LevelCatalog>(EngineEnvironment::Resource::CATALOG);
+    }
 
     last_id = 0;
     reloadIndexHeaders();
+    // chunks, written after erase, must not be covered by its tombstones,
+    // even if pages with greater ids were removed.
+    if (_tombstones != nullptr && _tombstones->max_seq(LEVEL::PAGES) != 0) {
+      last_id = std::max(last_id, _tombstones->max_seq(LEVEL::PAGES) - 1);
+    }
   }
 
   void reloadIndexHeaders() {
     if (utils::fs::path_exists(_settings->raw_path.value())) {
-      _file2header.clear();
-      auto pages =
-          _env->getResourceObject<Manifest>(EngineEnvironment::Resource::MANIFEST)
-              ->page_list();
+      auto manifest =
+          _env->getResourceObject<Manifest>(EngineEnvironment::Resource::MANIFEST);
+      {
+        std::lock_guard<std::shared_mutex> lg(_partitions_locker);
+        _partitions.clear();
+        for (auto &pr : manifest->partition_list()) {
+          auto &pd = _partitions[pr.name];
+          pd.minTime = pr.minTime;
+          pd.maxTime = pr.maxTime;
+        }
+      }
+      auto pages = manifest->page_list();
 
       for (auto n : pages) {
         auto file_name = utils::fs::append_path(_settings->raw_path.value(), n);
@@ -60,12 +113,24 @@ public:
         auto index_filename = PageIndex::index_name_from_page_name(file_name);
         if (utils::fs::file_exists(index_filename)) {
           auto ihdr = Page::readIndexHeader(index_filename);
-          insert_pagedescr(n, ihdr);
+          insert_pagedescr(n, ihdr, VersionStamp());
         }
       }
     }
   }
 
+  /// bounds of ids in new page are taken from index, without reading of chunks.
+  /// bounds of pages on startup are loaded by engine with loadMinMax.
+  void catalog_page(const std::string &index_filename) {
+    if (_catalog == nullptr) {
+      return;
+    }
+    auto index = PageIndex::open(index_filename);
+    for (auto &rec : index->readReccords()) {
+      _catalog->extend(LEVEL::PAGES, Id(rec.meas_id), rec.minTime, rec.maxTime);
+    }
+  }
+
   ~Private() {
     if (_cur_page != nullptr) {
       _cur_page = nullptr;
@@ -162,6 +227,7 @@ public:
     } else {
       pg = Page_Ptr{Page::open(pname)};
     }
+    pg->tombstones = _tombstones;
     return pg;
   }
 
@@ -189,7 +255,8 @@ public:
       TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
 
       auto page_list =
-          this->pages_by_filter(std::function<bool(const IndexHeader &)>(pred));
+          this->pages_by_filter(std::function<bool(const IndexHeader &)>(pred),
+                                query.from, query.to, query.version);
 
       ////TODO remove check
       // Time prev_t = MIN_TIME;
@@ -254,24 +321,82 @@ public:
     pm_async->wait();
   }
 
-  std::list<std::string> pages_by_filter(std::function<bool(const IndexHeader &)> pred) {
-    std::list<PageHeaderDescription> sub_result;
+  bool hasValues(const QueryInterval &query, uint64_t before_chunk) {
+    struct ExistsClb : public IReaderClb {
+      void call(const Meas &) override {
+        exists = true;
+        cancel();
+      }
+      bool exists = false;
+    };
+
+    auto links = chunksByIterval(query);
+    links.remove_if([before_chunk](const ChunkLink &l) { return l.id >= before_chunk; });
+    if (links.empty()) {
+      return false;
+    }
+    ExistsClb clbk;
+    AsyncTask at = [&query, &clbk, &links](const ThreadInfo &ti) {
+      TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
+      std::map<std::string, ChunkLinkList> by_page;
+      for (auto &l : links) {
+        by_page[l.page_name].push_back(l);
+      }
+      for (auto &kv : by_page) {
+        if (clbk.is_canceled()) {
+          break;
+        }
+        auto pg = Page::open(kv.first); // without tombstones.
+        pg->readLinks(query, kv.second, &clbk);
+      }
+      return false;
+    };
+    auto pm_async = ThreadManager::instance()->post(THREAD_KINDS::DISK_IO, AT(at));
+    pm_async->wait();
+    return clbk.exists;
+  }
 
-    for (auto f2h : _file2header) {
-      auto hdr = f2h.second.hdr;
-      if (pred(hdr)) {
+  /// headers of visible pages, sorted by min time.
+  /// from,to - used to skip whole partitions. version - see VersionSet.
+  std::vector<PageHeaderDescription>
+  headers_by_filter(std::function<bool(const IndexHeader &)> pred, Time from, Time to,
+                    uint64_t version) {
+    std::list<PageHeaderDescription> sub_result;
 
-        sub_result.push_back(f2h.second);
+    std::shared_lock<std::shared_mutex> lg(_partitions_locker);
+    for (auto &kv : _partitions) {
+      auto &partition = kv.second;
+      if (partition.maxTime < from || partition.minTime > to) {
+        continue;
+      }
+      for (auto &f2h : partition.pages) {
+        if (!f2h.second.stamp.visible(version)) {
+          continue;
+        }
+        auto hdr = f2h.second.hdr;
+        if (pred(hdr)) {
+          sub_result.push_back(f2h.second);
+        }
       }
     }
+    lg.unlock();
 
     std::vector<PageHeaderDescription> vec_res{sub_result.begin(), sub_result.end()};
     std::sort(vec_res.begin(), vec_res.end(),
               [](auto lr, auto rr) { return lr.hdr.minTime < rr.hdr.minTime; });
+    return vec_res;
+  }
+
+  std::string page_file_name(const PageHeaderDescription &hd) const {
+    return utils::fs::append_path(_settings->raw_path.value(), hd.path);
+  }
+
+  std::list<std::string> pages_by_filter(std::function<bool(const IndexHeader &)> pred,
+                                         Time from = MIN_TIME, Time to = MAX_TIME,
+                                         uint64_t version = NEWEST_VERSION) {
     std::list<std::string> result;
-    for (auto hd : vec_res) {
-      auto page_file_name = utils::fs::append_path(_settings->raw_path.value(), hd.path);
-      result.push_back(page_file_name);
+    for (auto &hd : headers_by_filter(pred, from, to, version)) {
+      result.push_back(page_file_name(hd));
     }
 #ifdef DEBUG
     std::list<Time> tm;
@@ -288,9 +413,11 @@ public:
     return result;
   }
 
+  /// one reverse walk over pages for all ids. id is resolved, when its value is not
+  /// older than values of all older pages, and is not readed from them.
   Id2Meas valuesBeforeTimePoint(const QueryTimePoint &query) {
     Id2Meas result;
-
+    result.reserve(query.ids.size());
     for (auto id : query.ids) {
       result[id].flag = Flags::_NO_DATA;
       result[id].time = query.time_point;
@@ -298,31 +425,52 @@ public:
 
     AsyncTask at = [&query, &result, this](const ThreadInfo &ti) {
       TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
-      auto pred = [query](const IndexHeader &hdr) {
-        auto in_check = utils::inInterval(hdr.minTime, hdr.maxTime, query.time_point) ||
-                        (hdr.maxTime < query.time_point);
-        if (in_check) {
-          for (auto id : query.ids) {
-            if (storage::bloom_check(hdr.id_bloom, id)) {
-              return true;
-            }
+      auto pred = [&query](const IndexHeader &hdr) {
+        if (hdr.minTime > query.time_point) {
+          return false;
+        }
+        for (auto id : query.ids) {
+          if (storage::bloom_check(hdr.id_bloom, id)) {
+            return true;
           }
         }
         return false;
       };
 
-      auto page_list = pages_by_filter(std::function<bool(IndexHeader)>(pred));
-
-      for (auto it = page_list.rbegin(); it != page_list.rend(); ++it) {
-        auto pname = *it;
-        auto pg = open_page_to_read(pname);
+      auto headers = headers_by_filter(std::function<bool(const IndexHeader &)>(pred),
+                                       MIN_TIME, query.time_point, query.version);
+      // older_max[i] - max time of pages before i.
+      std::vector<Time> older_max(headers.size(), MIN_TIME);
+      for (size_t i = 1; i < headers.size(); ++i) {
+        older_max[i] = std::max(older_max[i - 1], headers[i - 1].hdr.maxTime);
+      }
 
-        auto subres = pg->valuesBeforeTimePoint(query);
-        for (auto kv : subres) {
-          result[kv.first] = kv.second;
+      IdSet not_resolved(query.ids.begin(), query.ids.end());
+      QueryTimePoint local_q = query;
+      for (size_t i = headers.size(); i > 0 && !not_resolved.empty(); --i) {
+        auto &hd = headers[i - 1];
+        local_q.ids.clear();
+        for (auto id : not_resolved) {
+          if (storage::bloom_check(hd.hdr.id_bloom, id)) {
+            local_q.ids.push_back(id);
+          }
         }
-        if (subres.size() == query.ids.size()) {
-          break;
+        if (!local_q.ids.empty()) {
+          auto pg = open_page_to_read(page_file_name(hd));
+          for (auto &kv : pg->valuesBeforeTimePoint(local_q)) {
+            auto &cur = result[kv.first];
+            if (cur.flag == Flags::_NO_DATA || cur.time < kv.second.time) {
+              cur = kv.second;
+            }
+          }
+        }
+        for (auto it = not_resolved.begin(); it != not_resolved.end();) {
+          auto &cur = result[*it];
+          if (cur.flag != Flags::_NO_DATA && cur.time >= older_max[i - 1]) {
+            it = not_resolved.erase(it);
+          } else {
+            ++it;
+          }
         }
       }
       return false;
@@ -375,22 +523,81 @@ public:
   }
 
   void append(const std::string &file_prefix, const dariadb::MeasArray &ma) {
+    MeasArray values(ma);
+    auto pages = prepare(values);
+    append(file_prefix, pages);
+  }
+
+  PreparedPages prepare(dariadb::MeasArray &ma) const {
+    PreparedPages result;
+    auto chunk_size = _settings->chunk_size.value();
+    auto kind = _settings->partition.value();
+    if (kind == PARTITION_KIND::NONE) {
+      result.emplace(std::make_pair(std::string(), Page::prepare(chunk_size, ma)));
+      return result;
+    }
+
+    std::map<std::string, MeasArray> partitions;
+    for (auto &m : ma) {
+      partitions[partition_name(kind, m.time)].push_back(m);
+    }
+    for (auto &kv : partitions) {
+      result.emplace(std::make_pair(kv.first, Page::prepare(chunk_size, kv.second)));
+    }
+    return result;
+  }
+
+  void append(const std::string &file_prefix, PreparedPages &pages) {
     if (!dariadb::utils::fs::path_exists(_settings->raw_path.value())) {
       dariadb::utils::fs::mkdir(_settings->raw_path.value());
     }
+    for (auto &kv : pages) {
+      append_to_partition(kv.first, file_prefix, kv.second);
+    }
+  }
 
-    Page_Ptr res = nullptr;
-
-    std::string page_name = file_prefix + PAGE_FILE_EXT;
+  void append_to_partition(const std::string &partition, const std::string &file_prefix,
+                           PreparedPage &prepared) {
+    std::string page_name = page_name_in_partition(partition, file_prefix + PAGE_FILE_EXT);
     std::string file_name =
         dariadb::utils::fs::append_path(_settings->raw_path.value(), page_name);
-    res = Page::create(file_name, last_id, _settings->chunk_size.value(), ma);
-    _env->getResourceObject<Manifest>(EngineEnvironment::Resource::MANIFEST)
-        ->page_append(page_name);
+    auto res = Page::create(file_name, last_id, prepared);
+    register_page(page_name, res);
+  }
+
+  /// return page name relative to raw_path. create partition directory if needed.
+  std::string page_name_in_partition(const std::string &partition,
+                                     const std::string &page_name) {
+    if (partition.empty()) {
+      return page_name;
+    }
+    auto partition_path = utils::fs::append_path(_settings->raw_path.value(), partition);
+    if (!utils::fs::path_exists(partition_path)) {
+      utils::fs::mkdir(partition_path);
+    }
+    return partition + "/" + page_name;
+  }
+
+  /// page becomes visible to readers with version of edit.
+  void register_page(const std::string &page_name, const Page_Ptr &res) {
+    VersionSet::Edit edit(_versions);
+    auto manifest =
+        _env->getResourceObject<Manifest>(EngineEnvironment::Resource::MANIFEST);
+    manifest->page_append(page_name);
     last_id = res->header.max_chunk_id;
 
-    insert_pagedescr(page_name, Page::readIndexHeader(
-                                    PageIndex::index_name_from_page_name(file_name)));
+    auto file_name = utils::fs::append_path(_settings->raw_path.value(), page_name);
+    auto index_filename = PageIndex::index_name_from_page_name(file_name);
+    auto ihdr = Page::readIndexHeader(index_filename);
+    auto partition = partition_of_page(page_name);
+    if (!partition.empty()) {
+      manifest->partition_update(partition, ihdr.minTime, ihdr.maxTime);
+    }
+    // catalog is extended before page becomes visible.
+    catalog_page(index_filename);
+    VersionStamp stamp;
+    stamp.added = edit.version();
+    insert_pagedescr(page_name, ihdr, stamp);
   }
 
   static void erase(const std::string &storage_path, const std::string &fname) {
@@ -399,23 +606,99 @@ public:
     utils::fs::rm(PageIndex::index_name_from_page_name(full_file_name));
   }
 
+  /// page name relative to raw_path.
+  std::string page_name_from_path(const std::string &full_file_name) const {
+    auto raw_path = _settings->raw_path.value();
+    if (full_file_name.size() > raw_path.size() &&
+        full_file_name.compare(0, raw_path.size(), raw_path) == 0) {
+      return full_file_name.substr(raw_path.size() + 1);
+    }
+    return utils::fs::extract_filename(full_file_name);
+  }
+
+  /// page is removed from manifest at once, file is removed after readers of older
+  /// versions.
   void erase_page(const std::string &full_file_name) {
-    auto fname = utils::fs::extract_filename(full_file_name);
+    VersionSet::Edit edit(_versions);
+    auto fname = page_name_from_path(full_file_name);
+    auto partition = partition_of_page(fname);
 
     _env->getResourceObject<Manifest>(EngineEnvironment::Resource::MANIFEST)
         ->page_rm(fname);
-    utils::fs::rm(full_file_name);
-    utils::fs::rm(PageIndex::index_name_from_page_name(full_file_name));
-    auto it = _file2header.begin();
-    for (; it != _file2header.end(); ++it) {
+    {
+      std::lock_guard<std::shared_mutex> lg(_partitions_locker);
+      auto pit = _partitions.find(partition);
+      if (pit != _partitions.end()) {
+        for (auto &f2h : pit->second.pages) {
+          if (f2h.second.path == fname) {
+            f2h.second.stamp.removed = edit.version();
+            break;
+          }
+        }
+      }
+    }
+    edit.retire([this, full_file_name, fname, partition]() {
+      utils::fs::rm(full_file_name);
+      utils::fs::rm(PageIndex::index_name_from_page_name(full_file_name));
+      forget_page(partition, fname);
+    });
+  }
+
+  void forget_page(const std::string &partition, const std::string &fname) {
+    std::lock_guard<std::shared_mutex> lg(_partitions_locker);
+    auto pit = _partitions.find(partition);
+    if (pit == _partitions.end()) {
+      return;
+    }
+    auto &pages = pit->second.pages;
+    for (auto it = pages.begin(); it != pages.end(); ++it) {
       if (it->second.path == fname) {
+        pages.erase(it);
         break;
       }
     }
-    _file2header.erase(it);
+  }
+
+  /// drop whole partitions: one directory removal and one manifest update.
+  void erase_partitions(const Time t) {
+    VersionSet::Edit edit(_versions);
+    auto manifest =
+        _env->getResourceObject<Manifest>(EngineEnvironment::Resource::MANIFEST);
+    std::vector<std::string> erased;
+    std::unique_lock<std::shared_mutex> lg(_partitions_locker);
+    for (auto &kv : _partitions) {
+      if (kv.first.empty() || kv.second.maxTime > t) {
+        continue;
+      }
+      auto &pages = kv.second.pages;
+      auto alive = std::any_of(pages.begin(), pages.end(), [](auto &f2h) {
+        return f2h.second.stamp.removed == NOT_REMOVED;
+      });
+      if (!alive) {
+        continue;
+      }
+      logger_info("engine: erase partition ", kv.first);
+      manifest->partition_rm(kv.first);
+      for (auto &f2h : pages) {
+        f2h.second.stamp.removed = std::min(f2h.second.stamp.removed, edit.version());
+      }
+      erased.push_back(kv.first);
+    }
+    lg.unlock();
+
+    // without versions reclaim is called at once, so it is retired out of lock.
+    for (auto &partition : erased) {
+      edit.retire([this, partition]() {
+        utils::fs::rm(utils::fs::append_path(_settings->raw_path.value(), partition));
+        std::lock_guard<std::shared_mutex> lg(_partitions_locker);
+        _partitions.erase(partition);
+      });
+    }
   }
 
   void eraseOld(const Time t) {
+    erase_partitions(t);
+
     auto pred = [t](const IndexHeader &hdr) {
       auto in_check = hdr.maxTime <= t;
       return in_check;
@@ -451,58 +734,97 @@ public:
       return hdr.minTime >= from && hdr.maxTime <= to;
     };
 
-    auto page_list = pages_by_filter(std::function<bool(IndexHeader)>(pred));
-    if (page_list.size() <= 1) {
+    auto page_list = pages_by_filter(std::function<bool(IndexHeader)>(pred), from, to);
+    if (page_list.empty() || (page_list.size() == 1 && !has_tombstones())) {
       logger_info("engine: compactbyTime - pages count le 1.");
       return;
     }
     compact(page_list);
   }
 
+  bool has_tombstones() const { return _tombstones != nullptr && !_tombstones->empty(); }
+
+  /// pages are compacted only with pages from the same partition.
+  /// a single page is rewritten too, to drop erased values.
   void compact(std::list<std::string> part) {
-    Page_Ptr res = nullptr;
-    std::string page_name = utils::fs::random_file_name(".page");
+    std::map<std::string, std::list<std::string>> by_partition;
+    for (auto &p : part) {
+      by_partition[partition_of_page(page_name_from_path(p))].push_back(p);
+    }
+    for (auto &kv : by_partition) {
+      if (kv.second.size() > 1 || by_partition.size() == 1 || has_tombstones()) {
+        compact_partition(kv.first, kv.second);
+      }
+    }
+  }
+
+  void compact_partition(const std::string &partition, std::list<std::string> part) {
+    std::string page_name =
+        page_name_in_partition(partition, utils::fs::random_file_name(".page"));
     logger_info("engine: compacting to ", page_name);
     for (auto &p : part) {
       logger_info("==> ", utils::fs::extract_filename(p));
     }
     std::string file_name =
         dariadb::utils::fs::append_path(_settings->raw_path.value(), page_name);
-    res = Page::create(file_name, last_id, _settings->chunk_size.value(), part);
-    _env->getResourceObject<Manifest>(EngineEnvironment::Resource::MANIFEST)
-        ->page_append(page_name);
-    last_id = res->header.max_chunk_id;
-    
+    auto res = Page::create(file_name, last_id, _settings->chunk_size.value(), part,
+                            _tombstones);
+    // new page replaces old ones in one version.
+    VersionSet::Edit edit(_versions);
+    if (res->header.addeded_chunks != 0) {
+      register_page(page_name, res);
+    } else { // all values were erased.
+      res = nullptr;
+      erase(_settings->raw_path.value(), page_name);
+    }
+
     for (auto erasedPage : part) {
       this->erase_page(erasedPage);
     }
-
-    insert_pagedescr(page_name, Page::readIndexHeader(
-                                    PageIndex::index_name_from_page_name(file_name)));
   }
 
   void appendChunks(const std::vector<Chunk *> &a, size_t count) {
-    Page_Ptr res = nullptr;
-    std::string page_name = utils::fs::random_file_name(".page");
+    auto kind = _settings->partition.value();
+    if (kind == PARTITION_KIND::NONE) {
+      append_chunks_to_partition(std::string(), a, count);
+      return;
+    }
+
+    std::map<std::string, std::vector<Chunk *>> partitions;
+    for (size_t i = 0; i < count; ++i) {
+      partitions[partition_name(kind, a[i]->header->minTime)].push_back(a[i]);
+    }
+    for (auto &kv : partitions) {
+      append_chunks_to_partition(kv.first, kv.second, kv.second.size());
+    }
+  }
+
+  void append_chunks_to_partition(const std::string &partition,
+                                  const std::vector<Chunk *> &a, size_t count) {
+    std::string page_name =
+        page_name_in_partition(partition, utils::fs::random_file_name(".page"));
     logger_info("engine: write chunks to ", page_name);
     std::string file_name =
         dariadb::utils::fs::append_path(_settings->raw_path.value(), page_name);
-    res = Page::create(file_name, last_id, a, count);
-    _env->getResourceObject<Manifest>(EngineEnvironment::Resource::MANIFEST)
-        ->page_append(page_name);
-    last_id = res->header.max_chunk_id;
-
-    insert_pagedescr(page_name, Page::readIndexHeader(
-                                    PageIndex::index_name_from_page_name(file_name)));
+    auto res = Page::create(file_name, last_id, a, count);
+    register_page(page_name, res);
   }
 
-  void insert_pagedescr(std::string page_name, IndexHeader hdr) {
+  void insert_pagedescr(std::string page_name, IndexHeader hdr, VersionStamp stamp) {
     PageHeaderDescription ph_d;
     ph_d.hdr = hdr;
     ph_d.path = page_name;
-    _file2header.insert(std::make_pair(ph_d.hdr.maxTime, ph_d));
+    ph_d.partition = partition_of_page(page_name);
+    ph_d.stamp = stamp;
+    std::lock_guard<std::shared_mutex> lg(_partitions_locker);
+    auto &partition = _partitions[ph_d.partition];
+    partition.minTime = std::min(partition.minTime, hdr.minTime);
+    partition.maxTime = std::max(partition.maxTime, hdr.maxTime);
+    partition.pages.insert(std::make_pair(ph_d.hdr.maxTime, ph_d));
   }
 
+  uint64_t next_chunk_id() const { return last_id + 1; }
+
   Id2MinMax loadMinMax() {
     Id2MinMax result;
 
@@ -530,8 +852,12 @@ protected:
   mutable std::mutex _page_open_lock;
 
   uint64_t last_id;
-  File2PageHeader _file2header;
+  Partition2Pages _partitions;
+  mutable std::shared_mutex _partitions_locker;
+  VersionSet *_versions;
+  LevelCatalog *_catalog;
   EngineEnvironment_ptr _env;
+  Tombstones *_tombstones;
   Settings *_settings;
 };
 
@@ -566,6 +892,14 @@ void PageManager::readLinks(const QueryInterval &query, const ChunkLinkList &lin
   impl->readLinks(query, links, clb);
 }
 
+bool PageManager::hasValues(const QueryInterval &query, uint64_t before_chunk) {
+  return impl->hasValues(query, before_chunk);
+}
+
+uint64_t PageManager::next_chunk_id() const {
+  return impl->next_chunk_id();
+}
+
 size_t PageManager::files_count() const {
   return impl->files_count();
 }
@@ -585,6 +919,14 @@ dariadb::Time PageManager::maxTime() {
 void PageManager::append(const std::string &file_prefix, const dariadb::MeasArray &ma) {
   return impl->append(file_prefix, ma);
 }
+PageManager::PreparedPages PageManager::prepare(dariadb::MeasArray &ma) const {
+  return impl->prepare(ma);
+}
+
+void PageManager::append(const std::string &file_prefix, PreparedPages &pages) {
+  impl->append(file_prefix, pages);
+}
+
 void PageManager::fsck(bool force_check) {
   return impl->fsck(force_check);
 }
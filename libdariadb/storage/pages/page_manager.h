@@ -5,7 +5,10 @@
 #include <libdariadb/st_exports.h>
 #include <libdariadb/storage/chunk.h>
 #include <libdariadb/storage/engine_environment.h>
+#include <libdariadb/storage/pages/page.h>
 #include <libdariadb/utils/utils.h>
+#include <limits>
+#include <map>
 #include <vector>
 
 namespace dariadb {
@@ -15,6 +18,9 @@ class PageManager;
 typedef std::shared_ptr<PageManager> PageManager_ptr;
 class PageManager : public utils::NonCopy, public IChunkContainer {
 public:
+  /// compressed values, not written yet. key - partition name.
+  using PreparedPages = std::map<std::string, PreparedPage>;
+
   EXPORT static PageManager_ptr create(const EngineEnvironment_ptr env);
   EXPORT virtual ~PageManager();
   EXPORT void flush();
@@ -26,12 +32,23 @@ public:
   EXPORT void readLinks(const QueryInterval &query, const ChunkLinkList &links,
                         IReaderClb *clbk) override;
 
+  /// true if chunks with id less than 'before_chunk' store values from 'query'.
+  /// tombstones are ignored.
+  EXPORT bool hasValues(const QueryInterval &query,
+                        uint64_t before_chunk = std::numeric_limits<uint64_t>::max());
+  /// id of next written chunk. chunks with less id are written before.
+  EXPORT uint64_t next_chunk_id() const;
+
   EXPORT size_t files_count() const;
   EXPORT size_t chunks_in_cur_page() const;
   EXPORT dariadb::Time minTime();
   EXPORT dariadb::Time maxTime();
 
   EXPORT void append(const std::string &file_prefix, const dariadb::MeasArray &ma);
+  /// split by partitions and compress. thread-safe, no disk io. 'ma' is reordered.
+  EXPORT PreparedPages prepare(dariadb::MeasArray &ma) const;
+  /// write result of 'prepare' to pages with 'file_prefix' name.
+  EXPORT void append(const std::string &file_prefix, PreparedPages &pages);
   EXPORT void appendChunks(const std::vector<Chunk *> &a, size_t count) override;
 
   EXPORT void
@@ -0,0 +1,93 @@
+#include <libdariadb/storage/partition.h>
+#include <libdariadb/timeutil.h>
+#include <libdariadb/utils/exception.h>
+#include <libdariadb/utils/strings.h>
+#include <cstdio>
+#include <sstream>
+
+const dariadb::Time DAY_LENGTH = dariadb::Time(24) * 3600 * 1000;
+// 1970-01-01 is thursday, weeks begin on monday (1970-01-05).
+const dariadb::Time WEEK_OFFSET = DAY_LENGTH * 4;
+
+std::istream &dariadb::storage::operator>>(std::istream &in, PARTITION_KIND &kind) {
+  std::string token;
+  in >> token;
+
+  token = utils::strings::to_upper(token);
+
+  if (token == "NONE") {
+    kind = dariadb::storage::PARTITION_KIND::NONE;
+    return in;
+  }
+  if (token == "DAY") {
+    kind = dariadb::storage::PARTITION_KIND::DAY;
+    return in;
+  }
+  if (token == "WEEK") {
+    kind = dariadb::storage::PARTITION_KIND::WEEK;
+    return in;
+  }
+  THROW_EXCEPTION("engine: bad partition kind name - ", token);
+}
+
+std::ostream &dariadb::storage::operator<<(std::ostream &stream,
+                                           const PARTITION_KIND &kind) {
+  switch (kind) {
+  case PARTITION_KIND::NONE:
+    stream << "NONE";
+    break;
+  case PARTITION_KIND::DAY:
+    stream << "DAY";
+    break;
+  case PARTITION_KIND::WEEK:
+    stream << "WEEK";
+    break;
+  default:
+    THROW_EXCEPTION("engine: bad partition kind - ", (uint16_t)kind);
+    break;
+  };
+  return stream;
+}
+
+std::string dariadb::storage::to_string(const PARTITION_KIND &kind) {
+  std::stringstream ss;
+  ss << kind;
+  return ss.str();
+}
+
+dariadb::Time dariadb::storage::partition_length(const PARTITION_KIND kind) {
+  switch (kind) {
+  case PARTITION_KIND::DAY:
+    return DAY_LENGTH;
+  case PARTITION_KIND::WEEK:
+    return DAY_LENGTH * 7;
+  default:
+    return Time(0);
+  }
+}
+
+dariadb::Time dariadb::storage::partition_begin(const PARTITION_KIND kind,
+                                                const Time t) {
+  auto len = partition_length(kind);
+  if (len == 0) {
+    return MIN_TIME;
+  }
+  if (kind == PARTITION_KIND::WEEK) {
+    if (t < WEEK_OFFSET) { // week of 1969-12-29 is trimmed to epoch.
+      return MIN_TIME;
+    }
+    return t - ((t - WEEK_OFFSET) % len);
+  }
+  return t - (t % len);
+}
+
+std::string dariadb::storage::partition_name(const PARTITION_KIND kind, const Time t) {
+  if (kind == PARTITION_KIND::NONE) {
+    return std::string();
+  }
+  auto dt = timeutil::to_datetime(partition_begin(kind, t));
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", (int)dt.year, (int)dt.month,
+           (int)dt.day);
+  return std::string(buffer);
+}
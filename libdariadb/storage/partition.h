@@ -0,0 +1,27 @@
+#pragma once
+
+#include <libdariadb/meas.h>
+#include <libdariadb/st_exports.h>
+#include <istream>
+#include <ostream>
+#include <string>
+
+namespace dariadb {
+namespace storage {
+
+/// how pages are grouped to time-partition directories.
+enum class PARTITION_KIND : uint16_t { NONE = 0, DAY, WEEK };
+
+EXPORT std::istream &operator>>(std::istream &in, PARTITION_KIND &kind);
+EXPORT std::ostream &operator<<(std::ostream &stream, const PARTITION_KIND &kind);
+
+EXPORT std::string to_string(const PARTITION_KIND &kind);
+
+/// length of one partition in ms. 0 for NONE.
+EXPORT Time partition_length(const PARTITION_KIND kind);
+/// begin of partition which contains 't'. weeks begin on monday.
+EXPORT Time partition_begin(const PARTITION_KIND kind, const Time t);
+/// name of partition directory for 't' ("2016-10-03"). empty string for NONE.
+EXPORT std::string partition_name(const PARTITION_KIND kind, const Time t);
+}
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <libdariadb/meas.h>
+#include <libdariadb/storage/version_set.h>
 #include <algorithm>
 #include <functional>
 
@@ -10,7 +11,10 @@ namespace storage {
 struct QueryParam {
   IdArray ids;
   Flag flag;
-  QueryParam(const IdArray &_ids, Flag _flag) : ids(_ids), flag(_flag) {}
+  /// version of levels to read. see VersionSet.
+  uint64_t version;
+  QueryParam(const IdArray &_ids, Flag _flag)
+      : ids(_ids), flag(_flag), version(NEWEST_VERSION) {}
 };
 
 struct QueryInterval : public QueryParam {
@@ -13,16 +13,41 @@ using json = nlohmann::json;
 
 const uint64_t WAL_CACHE_SIZE = 4096 / sizeof(dariadb::Meas) * 10;
 const uint64_t WAL_FILE_SIZE = (1024 * 1024) * 4 / sizeof(dariadb::Meas);
+const uint64_t WAL_SYNC_INTERVAL = 1000;
+const uint64_t WAL_SHARDS = 1;
 const uint32_t CHUNK_SIZE = 1024;
 const size_t MAXIMUM_MEMORY_LIMIT = 100 * 1024 * 1024; // 100 mb
+const uint64_t MEMORY_REORDER_WINDOW = 0;
+const float MEMORY_HIGH = float(1.0);
+const float MEMORY_LOW = float(0.95);
+const uint64_t WAL_DROP_QUEUE_HIGH = 32;
+const uint64_t WAL_DROP_QUEUE_LOW = 16;
+const uint64_t BYSTEP_QUEUE_HIGH = 1024;
+const uint64_t BYSTEP_QUEUE_LOW = 512;
+const uint64_t WRITE_TIMEOUT = 0;
+const uint64_t QUERY_FANOUT = 2;
 
 const std::string c_wal_file_size = "wal_file_size";
 const std::string c_wal_cache_size = "wal_cache_size";
+const std::string c_wal_sync = "wal_sync";
+const std::string c_wal_sync_interval = "wal_sync_interval";
+const std::string c_wal_shards = "wal_shards";
+const std::string c_wal_drop_queue_high = "wal_drop_queue_high";
+const std::string c_wal_drop_queue_low = "wal_drop_queue_low";
 const std::string c_chunk_size = "chunk_size";
 const std::string c_strategy = "strategy";
 const std::string c_memory_limit = "memory_limit";
 const std::string c_percent_when_start_droping = "percent_when_start_droping";
 const std::string c_percent_to_drop = "percent_to_drop";
+const std::string c_memory_reorder_window = "memory_reorder_window";
+const std::string c_memory_high = "memory_high";
+const std::string c_memory_low = "memory_low";
+const std::string c_bystep_queue_high = "bystep_queue_high";
+const std::string c_bystep_queue_low = "bystep_queue_low";
+const std::string c_write_timeout = "write_timeout";
+const std::string c_write_fail_fast = "write_fail_fast";
+const std::string c_partition = "partition";
+const std::string c_query_fanout = "query_fanout";
 
 std::string settings_file_path(const std::string &path) {
   return dariadb::utils::fs::append_path(path, SETTINGS_FILE_NAME);
@@ -36,6 +61,12 @@ template <class T> void Settings::ReadOnlyOption<T>::from_string(const std::stri
 template <> std::string Settings::ReadOnlyOption<STRATEGY>::value_str() const {
   return dariadb::storage::to_string(this->value());
 }
+template <> std::string Settings::ReadOnlyOption<PARTITION_KIND>::value_str() const {
+  return dariadb::storage::to_string(this->value());
+}
+template <> std::string Settings::ReadOnlyOption<WAL_SYNC>::value_str() const {
+  return dariadb::storage::to_string(this->value());
+}
 template <> std::string Settings::ReadOnlyOption<std::string>::value_str() const {
   return this->value();
 }
@@ -53,11 +84,25 @@ Settings::Settings(const std::string &path_to_storage)
                   utils::fs::append_path(path_to_storage, "bystep")),
       wal_file_size(this, c_wal_file_size, WAL_FILE_SIZE),
       wal_cache_size(this, c_wal_cache_size, WAL_CACHE_SIZE),
+      wal_sync(this, c_wal_sync, WAL_SYNC::NONE),
+      wal_sync_interval(this, c_wal_sync_interval, WAL_SYNC_INTERVAL),
+      wal_shards(this, c_wal_shards, WAL_SHARDS),
+      wal_drop_queue_high(this, c_wal_drop_queue_high, WAL_DROP_QUEUE_HIGH),
+      wal_drop_queue_low(this, c_wal_drop_queue_low, WAL_DROP_QUEUE_LOW),
       chunk_size(this, c_chunk_size, CHUNK_SIZE),
       strategy(this, c_strategy, STRATEGY::COMPRESSED),
       memory_limit(this, c_memory_limit, MAXIMUM_MEMORY_LIMIT),
       percent_when_start_droping(this, c_percent_when_start_droping, float(0.75)),
-      percent_to_drop(this, c_percent_to_drop, float(0.1)) {
+      percent_to_drop(this, c_percent_to_drop, float(0.1)),
+      memory_reorder_window(this, c_memory_reorder_window, MEMORY_REORDER_WINDOW),
+      memory_high(this, c_memory_high, MEMORY_HIGH),
+      memory_low(this, c_memory_low, MEMORY_LOW),
+      bystep_queue_high(this, c_bystep_queue_high, BYSTEP_QUEUE_HIGH),
+      bystep_queue_low(this, c_bystep_queue_low, BYSTEP_QUEUE_LOW),
+      write_timeout(this, c_write_timeout, WRITE_TIMEOUT),
+      write_fail_fast(this, c_write_fail_fast, false),
+      partition(this, c_partition, PARTITION_KIND::NONE),
+      query_fanout(this, c_query_fanout, QUERY_FANOUT) {
   auto f = settings_file_path(storage_path.value());
   if (utils::fs::path_exists(f)) {
     load(f);
@@ -76,11 +121,25 @@ void Settings::set_default() {
   logger("engine: Settings set default Settings");
   wal_cache_size.setValue(WAL_CACHE_SIZE);
   wal_file_size.setValue(WAL_FILE_SIZE);
+  wal_sync.setValue(WAL_SYNC::NONE);
+  wal_sync_interval.setValue(WAL_SYNC_INTERVAL);
+  wal_shards.setValue(WAL_SHARDS);
+  wal_drop_queue_high.setValue(WAL_DROP_QUEUE_HIGH);
+  wal_drop_queue_low.setValue(WAL_DROP_QUEUE_LOW);
   chunk_size.setValue(CHUNK_SIZE);
   memory_limit.setValue(MAXIMUM_MEMORY_LIMIT);
   strategy.setValue(STRATEGY::COMPRESSED);
   percent_when_start_droping.setValue(float(0.75));
   percent_to_drop.setValue(float(0.15));
+  memory_reorder_window.setValue(MEMORY_REORDER_WINDOW);
+  memory_high.setValue(MEMORY_HIGH);
+  memory_low.setValue(MEMORY_LOW);
+  bystep_queue_high.setValue(BYSTEP_QUEUE_HIGH);
+  bystep_queue_low.setValue(BYSTEP_QUEUE_LOW);
+  write_timeout.setValue(WRITE_TIMEOUT);
+  write_fail_fast.setValue(false);
+  partition.setValue(PARTITION_KIND::NONE);
+  query_fanout.setValue(QUERY_FANOUT);
 }
 
 std::vector<dariadb::utils::async::ThreadPool::Params> Settings::thread_pools_params() {
@@ -118,6 +177,9 @@ void Settings::load(const std::string &file) {
   std::string content = dariadb::utils::fs::read_file(file);
   json js = json::parse(content);
   for (auto &o : _all_options) {
+    if (js.find(o.first) == js.end()) { // file from older version - keep default.
+      continue;
+    }
     auto str_val = js[o.first];
     o.second->from_string(str_val);
   }
@@ -2,7 +2,9 @@
 
 #include <libdariadb/meas.h>
 #include <libdariadb/st_exports.h>
+#include <libdariadb/storage/partition.h>
 #include <libdariadb/storage/strategy.h>
+#include <libdariadb/storage/wal/sync_mode.h>
 #include <libdariadb/utils/async/thread_pool.h>
 #include <libdariadb/utils/logger.h>
 
@@ -89,8 +91,13 @@ public:
   ReadOnlyOption<std::string> raw_path;
   ReadOnlyOption<std::string> bystep_path;
   // wal level options;
-  Option<uint64_t> wal_file_size;  // measurements count in one file
-  Option<uint64_t> wal_cache_size; // inner buffer size
+  Option<uint64_t> wal_file_size;       // measurements count in one file
+  Option<uint64_t> wal_cache_size;      // inner buffer size
+  Option<WAL_SYNC> wal_sync;            // durability mode
+  Option<uint64_t> wal_sync_interval;   // in ms. for WAL_SYNC::INTERVAL
+  Option<uint64_t> wal_shards;          // count of parallel writers (buffer+file).
+  Option<uint64_t> wal_drop_queue_high; // files in drop queue, when writers wait. 0 - no limit.
+  Option<uint64_t> wal_drop_queue_low;  // files in drop queue, when writers resumed.
 
   Option<uint32_t> chunk_size;
 
@@ -100,6 +107,23 @@ public:
   Option<uint32_t> memory_limit;            // in bytes;
   Option<float> percent_when_start_droping; // fill percent, when start dropping.
   Option<float> percent_to_drop;            // how many chunk drop.
+  Option<uint64_t> memory_reorder_window;   // max lateness of value. 0 - no reordering.
+  Option<float> memory_high;                // fill percent of chunks, when writers wait.
+  Option<float> memory_low;                 // fill percent of chunks, when writers resumed.
+
+  // bystep options;
+  Option<uint64_t> bystep_queue_high; // chunks in write queue, when writers wait.
+  Option<uint64_t> bystep_queue_low;  // chunks in write queue, when writers resumed.
+
+  // backpressure options;
+  Option<uint64_t> write_timeout; // in ms. max wait of writer on overloaded level. 0 - no limit.
+  Option<bool> write_fail_fast;   // reject writes to overloaded level without waiting.
+
+  // page level options;
+  Option<PARTITION_KIND> partition; // time-partition directories. week begins on monday.
+
+  // query options;
+  Option<uint64_t> query_fanout; // max parallel tasks of one query. 0 - COMMON pool size.
 
   bool load_min_max; // if true - engine dont load min max. needed to ctl tool.
 protected:
@@ -107,6 +131,9 @@ protected:
 };
 
 template <> EXPORT std::string Settings::ReadOnlyOption<STRATEGY>::value_str() const;
+template <>
+EXPORT std::string Settings::ReadOnlyOption<PARTITION_KIND>::value_str() const;
+template <> EXPORT std::string Settings::ReadOnlyOption<WAL_SYNC>::value_str() const;
 template <> EXPORT std::string Settings::ReadOnlyOption<std::string>::value_str() const;
 }
 }
@@ -9,7 +9,7 @@ SubscribeInfo::SubscribeInfo(const IdArray &i, const Flag &f, const ReaderClb_pt
     : ids(i), flag(f), clbk(c) {}
 
 bool SubscribeInfo::isYours(const dariadb::Meas &m) const {
-  if ((ids.size() == 0) || (std::count(ids.cbegin(), ids.cend(), m.id))) {
+  if (isYours(m.id)) {
     if ((flag == 0) || (flag == m.flag)) {
       return true;
     }
@@ -17,6 +17,10 @@ bool SubscribeInfo::isYours(const dariadb::Meas &m) const {
   return false;
 }
 
+bool SubscribeInfo::isYours(const dariadb::Id id) const {
+  return (ids.size() == 0) || (std::count(ids.cbegin(), ids.cend(), id));
+}
+
 SubscribeNotificator::~SubscribeNotificator() {
   if (!is_stoped) {
     this->stop();
@@ -47,3 +51,21 @@ void SubscribeNotificator::on_append(const dariadb::Meas &m) const {
     }
   }
 }
+
+void SubscribeNotificator::on_append(const MeasArray::const_iterator &begin,
+                                     const MeasArray::const_iterator &end) const {
+  if (begin == end) {
+    return;
+  }
+  for (auto si : _subscribes) {
+    ENSURE(si->clbk != nullptr);
+    if (!si->isYours(begin->id)) {
+      continue;
+    }
+    for (auto it = begin; it != end; ++it) {
+      if ((si->flag == 0) || (si->flag == it->flag)) {
+        si->clbk->call(*it);
+      }
+    }
+  }
+}
@@ -15,6 +15,7 @@ struct SubscribeInfo {
   Flag flag;
   mutable ReaderClb_ptr clbk;
   bool isYours(const dariadb::Meas &m) const;
+  bool isYours(const dariadb::Id id) const;
 };
 
 typedef std::shared_ptr<SubscribeInfo> SubscribeInfo_ptr;
@@ -29,8 +30,10 @@ struct SubscribeNotificator {
   void start();
   void stop();
   void add(const SubscribeInfo_ptr &n);
-  // TODO replace Meas to MEasArray and run on thread.
   void on_append(const dariadb::Meas &m) const;
+  /// values of one id. subscriptions are checked once.
+  void on_append(const MeasArray::const_iterator &begin,
+                 const MeasArray::const_iterator &end) const;
 };
 }
 }
@@ -0,0 +1,190 @@
+#include <libdariadb/storage/tombstones.h>
+#include <libdariadb/utils/utils.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+using namespace dariadb;
+using namespace dariadb::storage;
+
+namespace {
+uint64_t seq_of(const TombstoneRecord &rec, LEVEL l) {
+  switch (l) {
+  case LEVEL::PAGES:
+    return rec.page_seq;
+  case LEVEL::WAL:
+    return rec.wal_seq;
+  case LEVEL::MEMORY:
+    return rec.memory_seq;
+  }
+  return 0;
+}
+
+bool is_same(const TombstoneRecord &l, const TombstoneRecord &r) {
+  return l.from == r.from && l.to == r.to && l.page_seq == r.page_seq &&
+         l.wal_seq == r.wal_seq;
+}
+}
+
+class Tombstones::Private {
+public:
+  Private(Manifest *manifest) : _manifest(manifest) {
+    _count = 0;
+    _generation = 0;
+    for (auto &rec : _manifest->tombstone_list()) {
+      _id2intervals[rec.id].push_back(rec);
+      _count++;
+    }
+  }
+
+  void append(const TombstoneRecord &rec) {
+    std::lock_guard<std::shared_mutex> lg(_locker);
+    _manifest->tombstone_append(rec);
+    _id2intervals[rec.id].push_back(rec);
+    _count++;
+    _generation++;
+  }
+
+  void remove(const TombstoneRecord &rec) {
+    std::lock_guard<std::shared_mutex> lg(_locker);
+    auto fres = _id2intervals.find(rec.id);
+    if (fres == _id2intervals.end()) {
+      return;
+    }
+    auto &intervals = fres->second;
+    auto it = std::find_if(intervals.begin(), intervals.end(),
+                           [&rec](const TombstoneRecord &r) { return is_same(r, rec); });
+    if (it == intervals.end()) {
+      return;
+    }
+    _manifest->tombstone_rm(rec);
+    intervals.erase(it);
+    if (intervals.empty()) {
+      _id2intervals.erase(fres);
+    }
+    _count--;
+  }
+
+  std::list<TombstoneRecord> list() const {
+    std::shared_lock<std::shared_mutex> lg(_locker);
+    std::list<TombstoneRecord> result;
+    for (auto &kv : _id2intervals) {
+      result.insert(result.end(), kv.second.begin(), kv.second.end());
+    }
+    return result;
+  }
+
+  bool empty() const { return _count.load() == 0; }
+
+  uint64_t max_seq(LEVEL l) const {
+    std::shared_lock<std::shared_mutex> lg(_locker);
+    uint64_t result = 0;
+    for (auto &kv : _id2intervals) {
+      for (auto &rec : kv.second) {
+        result = std::max(result, seq_of(rec, l));
+      }
+    }
+    return result;
+  }
+
+  static void fill(const std::vector<TombstoneRecord> &recs, LEVEL l, uint64_t seq,
+                   ErasedIntervals *out) {
+    for (auto &rec : recs) {
+      if (seq < seq_of(rec, l)) {
+        out->intervals.emplace_back(rec.from, rec.to);
+      }
+    }
+  }
+
+  ErasedIntervals erased(Id id, LEVEL l, uint64_t seq) const {
+    ErasedIntervals result;
+    if (empty()) {
+      return result;
+    }
+    std::shared_lock<std::shared_mutex> lg(_locker);
+    auto fres = _id2intervals.find(id);
+    if (fres != _id2intervals.end()) {
+      fill(fres->second, l, seq, &result);
+    }
+    return result;
+  }
+
+  Id2Erased erased(const IdArray &ids, LEVEL l, uint64_t seq) const {
+    Id2Erased result;
+    if (empty()) {
+      return result;
+    }
+    auto add = [&result, l, seq](Id id, const std::vector<TombstoneRecord> &recs) {
+      ErasedIntervals ei;
+      fill(recs, l, seq, &ei);
+      if (!ei.empty()) {
+        result[id] = std::move(ei);
+      }
+    };
+    std::shared_lock<std::shared_mutex> lg(_locker);
+    if (ids.empty()) {
+      for (auto &kv : _id2intervals) {
+        add(kv.first, kv.second);
+      }
+    } else {
+      for (auto id : ids) {
+        auto fres = _id2intervals.find(id);
+        if (fres != _id2intervals.end()) {
+          add(id, fres->second);
+        }
+      }
+    }
+    return result;
+  }
+
+  Manifest *_manifest;
+  std::unordered_map<Id, std::vector<TombstoneRecord>> _id2intervals;
+  std::atomic_size_t _count;
+  std::atomic<uint64_t> _generation;
+  mutable std::shared_mutex _locker;
+};
+
+Tombstones_ptr Tombstones::create(Manifest *manifest) {
+  return Tombstones_ptr{new Tombstones(manifest)};
+}
+
+Tombstones::Tombstones(Manifest *manifest) : _impl(new Tombstones::Private(manifest)) {}
+
+Tombstones::~Tombstones() {
+  _impl = nullptr;
+}
+
+void Tombstones::append(const TombstoneRecord &rec) {
+  _impl->append(rec);
+}
+
+void Tombstones::remove(const TombstoneRecord &rec) {
+  _impl->remove(rec);
+}
+
+std::list<TombstoneRecord> Tombstones::list() const {
+  return _impl->list();
+}
+
+bool Tombstones::empty() const {
+  return _impl->empty();
+}
+
+uint64_t Tombstones::generation() const {
+  return _impl->_generation.load();
+}
+
+uint64_t Tombstones::max_seq(LEVEL l) const {
+  return _impl->max_seq(l);
+}
+
+ErasedIntervals Tombstones::erased(Id id, LEVEL l, uint64_t seq) const {
+  return _impl->erased(id, l, seq);
+}
+
+Id2Erased Tombstones::erased(const IdArray &ids, LEVEL l, uint64_t seq) const {
+  return _impl->erased(ids, l, seq);
+}
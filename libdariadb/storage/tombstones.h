@@ -0,0 +1,78 @@
+#pragma once
+
+#include <libdariadb/meas.h>
+#include <libdariadb/st_exports.h>
+#include <libdariadb/storage/level_catalog.h>
+#include <libdariadb/storage/manifest.h>
+#include <libdariadb/utils/utils.h>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace dariadb {
+namespace storage {
+
+/// erased intervals of one id, which cover one chunk or file.
+struct ErasedIntervals {
+  std::vector<std::pair<Time, Time>> intervals;
+
+  bool empty() const { return intervals.empty(); }
+  bool contains(Time t) const {
+    for (auto &i : intervals) {
+      if (utils::inInterval(i.first, i.second, t)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  /// all of [from,to] is erased.
+  bool covers(Time from, Time to) const {
+    for (auto &i : intervals) {
+      if (i.first <= from && i.second >= to) {
+        return true;
+      }
+    }
+    return false;
+  }
+};
+using Id2Erased = std::unordered_map<Id, ErasedIntervals>;
+
+class Tombstones;
+using Tombstones_ptr = std::shared_ptr<Tombstones>;
+/**
+Lazy deletes. Readers skip values covered by tombstones,
+compaction removes them physically.
+Tombstone covers only values written before erase, so each reader takes
+intervals for its chunk or file once and checks values without locks.
+*/
+class Tombstones : public utils::NonCopy {
+public:
+  EXPORT static Tombstones_ptr create(Manifest *manifest);
+  EXPORT ~Tombstones();
+
+  /// erase values of 'rec.id' in [from,to]. stored in manifest.
+  EXPORT void append(const TombstoneRecord &rec);
+  EXPORT void remove(const TombstoneRecord &rec);
+  EXPORT std::list<TombstoneRecord> list() const;
+  EXPORT bool empty() const;
+  /// changed by each append.
+  EXPORT uint64_t generation() const;
+  /// max sequence of stored tombstones on level. used at start of level.
+  EXPORT uint64_t max_seq(LEVEL l) const;
+
+  /// intervals of 'id', which cover item with 'seq' on level 'l'.
+  EXPORT ErasedIntervals erased(Id id, LEVEL l, uint64_t seq) const;
+  /// intervals of 'ids' (all if empty), which cover item with 'seq' on level 'l'.
+  EXPORT Id2Erased erased(const IdArray &ids, LEVEL l, uint64_t seq) const;
+
+protected:
+  EXPORT Tombstones(Manifest *manifest);
+
+private:
+  class Private;
+  std::unique_ptr<Private> _impl;
+};
+}
+}
@@ -0,0 +1,118 @@
+#include <libdariadb/storage/version_set.h>
+#include <libdariadb/utils/logger.h>
+#include <exception>
+#include <vector>
+
+using namespace dariadb;
+using namespace dariadb::storage;
+
+namespace {
+void call_reclaim(const VersionSet::Reclaim &f) {
+  try {
+    f();
+  } catch (std::exception &ex) {
+    logger_fatal("engine: versions - reclaim error: ", ex.what());
+  }
+}
+}
+
+Snapshot::~Snapshot() {
+  _owner->unpin(_version);
+}
+
+VersionSet::Edit::Edit(VersionSet *vs) : _vs(vs), _version(0) {
+  if (_vs == nullptr) {
+    return;
+  }
+  _vs->_edit_locker.lock();
+  if (_vs->_edit_depth == 0) {
+    _vs->_edit_version = _vs->_current.load() + 1;
+  }
+  _vs->_edit_depth++;
+  _version = _vs->_edit_version;
+}
+
+VersionSet::Edit::~Edit() {
+  if (_vs == nullptr) {
+    return;
+  }
+  _vs->_edit_depth--;
+  if (_vs->_edit_depth != 0) {
+    _vs->_edit_locker.unlock();
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lg(_vs->_locker);
+    _vs->_current.store(_version);
+    for (auto &f : _vs->_edit_retired) {
+      _vs->_retired.emplace(_version, f);
+    }
+    _vs->_edit_retired.clear();
+  }
+  _vs->_edit_locker.unlock();
+  _vs->reclaim();
+}
+
+void VersionSet::Edit::retire(const Reclaim &f) {
+  if (_vs == nullptr) {
+    call_reclaim(f);
+    return;
+  }
+  _vs->_edit_retired.push_back(f);
+}
+
+VersionSet::VersionSet() : _current(0), _edit_depth(0), _edit_version(0) {}
+
+VersionSet::~VersionSet() {
+  for (auto &kv : _retired) {
+    call_reclaim(kv.second);
+  }
+}
+
+Snapshot_Ptr VersionSet::pin() {
+  std::lock_guard<std::mutex> lg(_locker);
+  auto version = _current.load();
+  _pinned[version]++;
+  return Snapshot_Ptr{new Snapshot(this, version)};
+}
+
+void VersionSet::unpin(uint64_t version) {
+  {
+    std::lock_guard<std::mutex> lg(_locker);
+    auto it = _pinned.find(version);
+    if (--it->second == 0) {
+      _pinned.erase(it);
+    }
+  }
+  reclaim();
+}
+
+void VersionSet::reclaim() {
+  std::lock_guard<std::mutex> rlg(_reclaim_locker);
+  std::vector<Reclaim> ready;
+  {
+    std::lock_guard<std::mutex> lg(_locker);
+    // items removed in version 'v' are used by snapshots older than 'v'.
+    auto end = _pinned.empty() ? _retired.end()
+                               : _retired.upper_bound(_pinned.begin()->first);
+    for (auto it = _retired.begin(); it != end; ++it) {
+      ready.push_back(it->second);
+    }
+    _retired.erase(_retired.begin(), end);
+  }
+  for (auto &f : ready) {
+    call_reclaim(f);
+  }
+}
+
+VersionSet::Description VersionSet::description() const {
+  std::lock_guard<std::mutex> lg(_locker);
+  Description result;
+  result.version = _current.load();
+  result.pinned = 0;
+  for (auto &kv : _pinned) {
+    result.pinned += kv.second;
+  }
+  result.retired = _retired.size();
+  return result;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <libdariadb/st_exports.h>
+#include <libdariadb/utils/utils.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace dariadb {
+namespace storage {
+
+/// version of reader without snapshot: sees only not removed items.
+const uint64_t NEWEST_VERSION = std::numeric_limits<uint64_t>::max() - 1;
+/// 'removed' of item, which is alive.
+const uint64_t NOT_REMOVED = std::numeric_limits<uint64_t>::max();
+
+/// lifetime of level item (page, wal file) in versions.
+struct VersionStamp {
+  uint64_t added;
+  uint64_t removed;
+  VersionStamp() : added(0), removed(NOT_REMOVED) {}
+  bool visible(uint64_t version) const { return added <= version && version < removed; }
+};
+
+class VersionSet;
+/// pinned version of levels. released in destructor.
+class Snapshot : public utils::NonCopy {
+public:
+  EXPORT ~Snapshot();
+  uint64_t version() const { return _version; }
+
+protected:
+  friend class VersionSet;
+  Snapshot(VersionSet *owner, uint64_t version) : _owner(owner), _version(version) {}
+
+  VersionSet *_owner;
+  uint64_t _version;
+};
+using Snapshot_Ptr = std::shared_ptr<Snapshot>;
+
+/**
+Versions of storage levels (pages, wal files, memstorage chunks).
+Values are moved to the down level in one Edit: new page is added and the source
+is removed with the same version, so reader of a pinned version sees moved values
+once. Removed items are reclaimed, when all snapshots older than edit are released.
+*/
+class VersionSet : public utils::NonCopy {
+public:
+  using Reclaim = std::function<void()>;
+
+  /// change of levels. nested edits of one thread are parts of the outer one,
+  /// which makes new version visible in destructor.
+  class Edit : public utils::NonCopy {
+  public:
+    /// vs can be nullptr: removed items are reclaimed at once.
+    EXPORT Edit(VersionSet *vs);
+    EXPORT ~Edit();
+    /// version of items, added or removed by edit.
+    uint64_t version() const { return _version; }
+    /// 'f' is called, when items removed by edit are not used by readers.
+    EXPORT void retire(const Reclaim &f);
+
+  protected:
+    VersionSet *_vs;
+    uint64_t _version;
+  };
+
+  struct Description {
+    uint64_t version; // current version.
+    size_t pinned;    // snapshots in use.
+    size_t retired;   // removed items, waiting for readers.
+  };
+
+  EXPORT VersionSet();
+  /// reclaims all retired items.
+  EXPORT ~VersionSet();
+  EXPORT Snapshot_Ptr pin();
+  uint64_t current() const { return _current.load(); }
+  EXPORT Description description() const;
+
+protected:
+  friend class Snapshot;
+  void unpin(uint64_t version);
+  /// run reclaims, which are not needed to readers.
+  void reclaim();
+
+  std::atomic<uint64_t> _current;
+  mutable std::mutex _locker;
+  std::map<uint64_t, size_t> _pinned; // version -> count of snapshots
+  std::multimap<uint64_t, Reclaim> _retired; // key - version of edit.
+  std::list<Reclaim> _edit_retired; // reclaims of edit in progress.
+  std::mutex _reclaim_locker;       // reclaims are called one by one.
+
+  std::recursive_mutex _edit_locker;
+  size_t _edit_depth;
+  uint64_t _edit_version;
+};
+}
+}
@@ -0,0 +1,56 @@
+#include <libdariadb/storage/wal/sync_mode.h>
+#include <libdariadb/utils/exception.h>
+#include <libdariadb/utils/strings.h>
+#include <sstream>
+
+std::istream &dariadb::storage::operator>>(std::istream &in, WAL_SYNC &mode) {
+  std::string token;
+  in >> token;
+
+  token = utils::strings::to_upper(token);
+
+  if (token == "NONE") {
+    mode = dariadb::storage::WAL_SYNC::NONE;
+    return in;
+  }
+  if (token == "INTERVAL") {
+    mode = dariadb::storage::WAL_SYNC::INTERVAL;
+    return in;
+  }
+  if (token == "EVERY_BATCH" || token == "EVERY-BATCH") {
+    mode = dariadb::storage::WAL_SYNC::EVERY_BATCH;
+    return in;
+  }
+  if (token == "ALWAYS") {
+    mode = dariadb::storage::WAL_SYNC::ALWAYS;
+    return in;
+  }
+  THROW_EXCEPTION("engine: bad wal sync mode - ", token);
+}
+
+std::ostream &dariadb::storage::operator<<(std::ostream &stream, const WAL_SYNC &mode) {
+  switch (mode) {
+  case WAL_SYNC::NONE:
+    stream << "NONE";
+    break;
+  case WAL_SYNC::INTERVAL:
+    stream << "INTERVAL";
+    break;
+  case WAL_SYNC::EVERY_BATCH:
+    stream << "EVERY_BATCH";
+    break;
+  case WAL_SYNC::ALWAYS:
+    stream << "ALWAYS";
+    break;
+  default:
+    THROW_EXCEPTION("engine: bad wal sync mode - ", (uint16_t)mode);
+    break;
+  };
+  return stream;
+}
+
+std::string dariadb::storage::to_string(const WAL_SYNC &mode) {
+  std::stringstream ss;
+  ss << mode;
+  return ss.str();
+}
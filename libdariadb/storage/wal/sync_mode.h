@@ -0,0 +1,24 @@
+#pragma once
+
+#include <libdariadb/st_exports.h>
+#include <istream>
+#include <ostream>
+#include <string>
+
+namespace dariadb {
+namespace storage {
+
+/// when wal data is synced to disk (fdatasync).
+enum class WAL_SYNC : uint16_t {
+  NONE = 0,    // os decides.
+  INTERVAL,    // not often than 'wal_sync_interval' ms.
+  EVERY_BATCH, // after each write of wal buffer.
+  ALWAYS       // append returns when value is on disk (group commit).
+};
+
+EXPORT std::istream &operator>>(std::istream &in, WAL_SYNC &mode);
+EXPORT std::ostream &operator<<(std::ostream &stream, const WAL_SYNC &mode);
+
+EXPORT std::string to_string(const WAL_SYNC &mode);
+}
+}
@@ -0,0 +1,152 @@
+#include <libdariadb/compression/xor.h>
+#include <libdariadb/storage/wal/wal_block.h>
+
+using namespace dariadb;
+using namespace dariadb::storage;
+
+namespace {
+const uint8_t XOR_ZERO = 0x80; // leading=8 bytes, no meaningful bytes.
+
+void write_varint(uint64_t v, std::vector<uint8_t> *out) {
+  while (v >= 0x80) {
+    out->push_back(uint8_t(v | 0x80));
+    v >>= 7;
+  }
+  out->push_back(uint8_t(v));
+}
+
+uint64_t zigzag(int64_t v) {
+  return (uint64_t(v) << 1) ^ uint64_t(v >> 63);
+}
+
+int64_t unzigzag(uint64_t v) {
+  return int64_t(v >> 1) ^ -int64_t(v & 1);
+}
+
+void write_xor(uint64_t x, std::vector<uint8_t> *out) {
+  if (x == 0) {
+    out->push_back(XOR_ZERO);
+    return;
+  }
+  uint8_t leading = 0;
+  while ((x >> (56 - leading * 8)) == 0) {
+    ++leading;
+  }
+  uint8_t trailing = 0;
+  while ((x & (uint64_t(0xFF) << (trailing * 8))) == 0) {
+    ++trailing;
+  }
+  out->push_back(uint8_t((leading << 4) | trailing));
+  auto meaningful = x >> (trailing * 8);
+  for (int i = 0; i < 8 - leading - trailing; ++i) {
+    out->push_back(uint8_t(meaningful >> (i * 8)));
+  }
+}
+}
+
+void WALBlockWriter::encode(const Meas *values, size_t count, std::vector<uint8_t> *out) {
+  _ids.clear();
+  _dictionary.clear();
+  for (size_t i = 0; i < count; ++i) {
+    if (_ids.find(values[i].id) == _ids.end()) {
+      _ids[values[i].id] = IdState{_dictionary.size(), Time(0), uint64_t(0)};
+      _dictionary.push_back(values[i].id);
+    }
+  }
+
+  write_varint(_dictionary.size(), out);
+  for (auto id : _dictionary) {
+    write_varint(id, out);
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    auto &v = values[i];
+    auto &state = _ids[v.id];
+    auto flat_value = uint64_t(compression::inner::flat_double_to_int(v.value));
+
+    write_varint(state.index, out);
+    write_varint(zigzag(int64_t(v.time - state.time)), out);
+    write_xor(flat_value ^ state.value, out);
+    write_varint(v.flag, out);
+
+    state.time = v.time;
+    state.value = flat_value;
+  }
+}
+
+WALBlockReader::WALBlockReader(const uint8_t *data, size_t size) {
+  _pos = data;
+  _end = data + size;
+  _valid = true;
+
+  uint64_t ids_count = 0;
+  if (!read_varint(&ids_count) || ids_count > size) {
+    _valid = false;
+    return;
+  }
+  _ids.resize(size_t(ids_count));
+  for (auto &state : _ids) {
+    uint64_t id = 0;
+    if (!read_varint(&id)) {
+      _valid = false;
+      return;
+    }
+    state = IdState{Id(id), Time(0), uint64_t(0)};
+  }
+}
+
+bool WALBlockReader::read_varint(uint64_t *result) {
+  *result = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (_pos == _end) {
+      return false;
+    }
+    auto b = *_pos++;
+    *result |= uint64_t(b & 0x7F) << shift;
+    if ((b & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool WALBlockReader::next(Meas *out) {
+  if (!_valid || _pos == _end) {
+    return false;
+  }
+  uint64_t index = 0, time_delta = 0, flag = 0;
+  if (!read_varint(&index) || index >= _ids.size() || !read_varint(&time_delta) ||
+      _pos == _end) {
+    _valid = false;
+    return false;
+  }
+  auto &state = _ids[size_t(index)];
+
+  auto ctrl = *_pos++;
+  auto leading = ctrl >> 4;
+  auto trailing = ctrl & 0x0F;
+  if (leading + trailing > 8 || (_end - _pos) < (8 - leading - trailing)) {
+    _valid = false;
+    return false;
+  }
+  uint64_t x = 0;
+  if (ctrl != XOR_ZERO) {
+    for (int i = 0; i < 8 - leading - trailing; ++i) {
+      x |= uint64_t(*_pos++) << (i * 8);
+    }
+    x <<= trailing * 8;
+  }
+  if (!read_varint(&flag)) {
+    _valid = false;
+    return false;
+  }
+
+  state.time += Time(unzigzag(time_delta));
+  state.value ^= x;
+
+  out->id = state.id;
+  out->time = state.time;
+  out->value = compression::inner::flat_int_to_double(int64_t(state.value));
+  out->flag = Flag(flag);
+  return true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <libdariadb/meas.h>
+#include <libdariadb/st_exports.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace dariadb {
+namespace storage {
+/**
+Encoded WAL block payload:
+  ids count (varint), ids dictionary (varint each).
+  for each value:
+    index in dictionary (varint),
+    time delta from previous time of same id (zigzag varint),
+    value xor previous value of same id (control byte + meaningful bytes),
+    flag (varint).
+*/
+class WALBlockWriter {
+public:
+  /// append encoded payload for [values, values+count) to 'out'.
+  EXPORT void encode(const Meas *values, size_t count, std::vector<uint8_t> *out);
+
+protected:
+  struct IdState {
+    size_t index;
+    Time time;
+    uint64_t value;
+  };
+  std::unordered_map<Id, IdState> _ids;
+  std::vector<Id> _dictionary;
+};
+
+class WALBlockReader {
+public:
+  /// 'data' must be alive while reader is used.
+  EXPORT WALBlockReader(const uint8_t *data, size_t size);
+  /// false if block is corrupted.
+  bool is_valid() const { return _valid; }
+  /// decode next value. return false on end of block or error.
+  EXPORT bool next(Meas *out);
+
+protected:
+  bool read_varint(uint64_t *result);
+
+protected:
+  struct IdState {
+    Id id;
+    Time time;
+    uint64_t value;
+  };
+  const uint8_t *_pos;
+  const uint8_t *_end;
+  bool _valid;
+  std::vector<IdState> _ids;
+};
+}
+}
@@ -8,6 +8,7 @@
 #include <libdariadb/utils/fs.h>
 #include <libdariadb/utils/logger.h>
 
+#include <algorithm>
 #include <iterator>
 #include <tuple>
 
@@ -15,9 +16,22 @@ using namespace dariadb;
 using namespace dariadb::storage;
 using namespace dariadb::utils::async;
 
+namespace {
+/// max count of free segments, kept to reuse.
+const size_t MAX_FREE_SEGMENTS = 4;
+}
+
 EXPORT WALManager *WALManager::_instance = nullptr;
 
 WALManager::~WALManager() {
+  if (_sync_thread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lg(_sync_locker);
+      _sync_stop = true;
+    }
+    _sync_cond.notify_all();
+    _sync_thread.join();
+  }
   this->flush();
 }
 
@@ -28,41 +42,197 @@ WALManager_ptr WALManager::create(const EngineEnvironment_ptr env){
 WALManager::WALManager(const EngineEnvironment_ptr env) {
   _env = env;
   _settings = _env->getResourceObject<Settings>(EngineEnvironment::Resource::SETTINGS);
+  _tombstones = nullptr;
+  if (_env->hasResource(EngineEnvironment::Resource::TOMBSTONES)) {
+    _tombstones =
+        _env->getResourceObject<Tombstones>(EngineEnvironment::Resource::TOMBSTONES);
+  }
+  _versions = nullptr;
+  if (_env->hasResource(EngineEnvironment::Resource::VERSIONS)) {
+    _versions = _env->getResourceObject<VersionSet>(EngineEnvironment::Resource::VERSIONS);
+  }
   _down = nullptr;
+
+  auto shards_count = std::max(_settings->wal_shards.value(), uint64_t(1));
+  _shards.resize(size_t(shards_count));
+  for (auto &sh : _shards) {
+    sh = std::make_unique<Shard>();
+    sh->buffer.resize(_settings->wal_cache_size.value());
+    sh->buffer_pos = 0;
+    sh->batch_buffer.resize(sh->buffer.size());
+    sh->batch_num = 1;
+    sh->synced_batch = 0;
+    sh->batch_writing = false;
+    sh->last_sync = std::chrono::steady_clock::now();
+  }
+
   auto manifest =
       _env->getResourceObject<Manifest>(EngineEnvironment::Resource::MANIFEST);
+  uint64_t max_seq = 0;
+  // files, sealed by erase, are not reopened: new values must not be covered.
+  uint64_t sealed_seq = 0;
+  if (_tombstones != nullptr) {
+    sealed_seq = _tombstones->max_seq(LEVEL::WAL);
+  }
   if (dariadb::utils::fs::path_exists(_settings->raw_path.value())) {
-    auto wals = manifest->wal_list();
-    for (auto f : wals) {
+    // only headers are readed. blocks are counted for the newest files only:
+    // each shard was writing to one of them.
+    std::vector<std::pair<uint64_t, std::string>> candidates;
+    for (auto f : manifest->wal_list()) {
       auto full_filename = utils::fs::append_path(_settings->raw_path.value(), f);
+      auto seq = WALFile::sequence(full_filename);
+      max_seq = std::max(max_seq, seq);
+      if (seq >= sealed_seq) {
+        candidates.emplace_back(seq, f);
+      }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const std::pair<uint64_t, std::string> &l,
+                        const std::pair<uint64_t, std::string> &r) {
+                       return l.first > r.first;
+                     });
+    candidates.resize(std::min(candidates.size(), _shards.size()));
+    size_t reopened = 0;
+    for (auto &c : candidates) {
+      auto full_filename = utils::fs::append_path(_settings->raw_path.value(), c.second);
       if (WALFile::writed(full_filename) != _settings->wal_file_size.value()) {
-        logger_info("engine: WalManager open exist file ", f);
+        logger_info("engine: WalManager open exist file ", c.second);
         WALFile_Ptr p = WALFile::open(_env, full_filename);
-        _wal = p;
-        break;
+        set_active(*_shards[reopened], p);
+        cache_summary(p);
+        ++reopened;
+      }
+    }
+    for (auto f : utils::fs::ls(_settings->raw_path.value(), WAL_FREE_EXT)) {
+      max_seq = std::max(max_seq, WALFile::sequence(f));
+      _free_segments.push_back(f);
+    }
+  }
+  _next_seq = std::max(max_seq + 1, sealed_seq);
+
+  _sync_stop = false;
+  if (_settings->wal_sync.value() == WAL_SYNC::INTERVAL) {
+    _sync_thread = std::thread(&WALManager::sync_thread_func, this);
+  }
+}
+
+void WALManager::sync_thread_func() {
+  std::unique_lock<std::mutex> ul(_sync_locker);
+  while (!_sync_stop) {
+    auto interval = std::max(_settings->wal_sync_interval.value(), uint64_t(1));
+    _sync_cond.wait_for(ul, std::chrono::milliseconds(interval));
+    if (_sync_stop) {
+      break;
+    }
+    ul.unlock();
+    for (auto &sh : _shards) {
+      std::unique_lock<std::mutex> lg(sh->locker);
+      wait_batch_writing(*sh, lg);
+      if (need_sync(*sh)) {
+        flush_buffer(*sh);
       }
     }
+    ul.lock();
   }
+}
 
-  _buffer.resize(_settings->wal_cache_size.value());
-  _buffer_pos = 0;
+void WALManager::set_active(Shard &sh, const WALFile_Ptr &wal) {
+  std::lock_guard<std::mutex> lg(_active_locker);
+  if (sh.wal != nullptr) {
+    _active_files.erase(sh.wal->filename());
+  }
+  sh.wal = wal;
+  if (wal != nullptr) {
+    _active_files.insert(wal->filename());
+  }
 }
 
-void WALManager::create_new() {
-  _wal = nullptr;
+void WALManager::create_new(Shard &sh) {
+  set_active(sh, nullptr);
   if (_settings->strategy.value() != STRATEGY::WAL) {
     drop_old_if_needed();
   }
-  _wal = WALFile::create(_env);
+  auto wal = WALFile::create(_env, _next_seq++, pop_free_segment());
+  set_active(sh, wal);
+  cache_summary(wal);
+}
+
+WALFileSummary_ptr WALManager::cached_summary(const std::string &fname) {
+  std::lock_guard<std::mutex> lg(_summaries_locker);
+  auto fres = _summaries.find(fname);
+  if (fres != _summaries.end()) {
+    return fres->second;
+  }
+  return nullptr;
+}
+
+bool WALManager::may_contain(const std::string &fname, const IdArray &ids, Time from,
+                             Time to) {
+  auto summary = cached_summary(fname);
+  return summary == nullptr || summary->contains(ids, from, to);
+}
+
+WALFile_Ptr WALManager::open_wal(const std::string &fname) {
+  auto summary = cached_summary(fname);
+  auto result = WALFile::open(_env, fname, true, summary);
+  if (summary == nullptr) {
+    cache_summary(result);
+  }
+  return result;
+}
+
+WALFile_Ptr WALManager::open_wal(const ReadSnapshot &snapshot, const std::string &fname) {
+  auto result = open_wal(fname);
+  auto end = snapshot.ends.find(fname);
+  if (end != snapshot.ends.end()) {
+    result->read_until(end->second);
+  }
+  return result;
+}
+
+void WALManager::cache_summary(const WALFile_Ptr &wal) {
+  auto summary = wal->summary();
+  if (summary != nullptr) {
+    std::lock_guard<std::mutex> lg(_summaries_locker);
+    _summaries[wal->filename()] = summary;
+  }
+}
+
+std::string WALManager::pop_free_segment() {
+  std::lock_guard<std::mutex> lg(_free_locker);
+  if (_free_segments.empty()) {
+    return std::string();
+  }
+  auto result = _free_segments.front();
+  _free_segments.pop_front();
+  return result;
+}
+
+WALManager::ShardsLock WALManager::lock_all() {
+  ShardsLock result;
+  result.reserve(_shards.size());
+  for (auto &sh : _shards) {
+    result.emplace_back(sh->locker);
+    wait_batch_writing(*sh, result.back());
+  }
+  return result;
 }
 
 void WALManager::dropAll() {
   if (_down != nullptr) {
     auto all_files = wal_files();
-    this->_wal = nullptr;
+    for (auto &sh : _shards) {
+      std::lock_guard<std::mutex> lg(sh->locker);
+      set_active(*sh, nullptr);
+    }
     for (auto f : all_files) {
       auto without_path = utils::fs::extract_filename(f);
-      if (_files_send_to_drop.find(without_path) == _files_send_to_drop.end()) {
+      bool sended = false;
+      {
+        std::lock_guard<std::mutex> lg(_drop_locker);
+        sended = _files_send_to_drop.find(without_path) != _files_send_to_drop.end();
+      }
+      if (!sended) {
         // logger_info("engine: drop ",without_path);
         this->dropWAL(f, _down);
       }
@@ -79,7 +249,12 @@ void WALManager::dropClosedFiles(size_t count) {
       auto f = closed.front();
       closed.pop_front();
       auto without_path = utils::fs::extract_filename(f);
-      if (_files_send_to_drop.find(without_path) == _files_send_to_drop.end()) {
+      bool sended = false;
+      {
+        std::lock_guard<std::mutex> lg(_drop_locker);
+        sended = _files_send_to_drop.find(without_path) != _files_send_to_drop.end();
+      }
+      if (!sended) {
         this->dropWAL(f, _down);
       }
     }
@@ -88,13 +263,26 @@ void WALManager::dropClosedFiles(size_t count) {
         _env->getResourceObject<Manifest>(EngineEnvironment::Resource::MANIFEST);
     auto wals_exists = manifest->wal_list();
     std::set<std::string> wal_exists_set{wals_exists.begin(), wals_exists.end()};
-    std::set<std::string> new_sended_files;
-    for (auto &v : _files_send_to_drop) {
-      if (wal_exists_set.find(v) != wal_exists_set.end()) {
-        new_sended_files.emplace(v);
+    {
+      std::lock_guard<std::mutex> lg(_drop_locker);
+      std::set<std::string> new_sended_files;
+      for (auto &v : _files_send_to_drop) {
+        if (wal_exists_set.find(v) != wal_exists_set.end()) {
+          new_sended_files.emplace(v);
+        }
+      }
+      _files_send_to_drop = new_sended_files;
+    }
+
+    std::lock_guard<std::mutex> lg(_summaries_locker);
+    for (auto it = _summaries.begin(); it != _summaries.end();) {
+      if (wal_exists_set.find(utils::fs::extract_filename(it->first)) ==
+          wal_exists_set.end()) {
+        it = _summaries.erase(it);
+      } else {
+        ++it;
       }
     }
-    _files_send_to_drop = new_sended_files;
   }
 }
 
@@ -105,13 +293,23 @@ void WALManager::drop_old_if_needed() {
   }
 }
 
-std::list<std::string> WALManager::wal_files() const {
+/// file is retired before it is removed from manifest, so visibility of
+/// retired file is defined by version only.
+std::list<std::string> WALManager::wal_files(uint64_t version) const {
   std::list<std::string> res;
   auto files = _env->getResourceObject<Manifest>(EngineEnvironment::Resource::MANIFEST)
                    ->wal_list();
+  std::lock_guard<std::mutex> lg(_retired_locker);
   for (auto f : files) {
     auto full_path = utils::fs::append_path(_settings->raw_path.value(), f);
-    res.push_back(full_path);
+    if (_retired.find(full_path) == _retired.end()) {
+      res.push_back(full_path);
+    }
+  }
+  for (auto &kv : _retired) {
+    if (version < kv.second) {
+      res.push_back(kv.first);
+    }
   }
   return res;
 }
@@ -119,13 +317,10 @@ std::list<std::string> WALManager::wal_files() const {
 std::list<std::string> WALManager::closedWals() {
   auto all_files = wal_files();
   std::list<std::string> result;
+  std::lock_guard<std::mutex> lg(_active_locker);
   for (auto fn : all_files) {
-    if (_wal == nullptr) {
+    if (_active_files.find(fn) == _active_files.end()) {
       result.push_back(fn);
-    } else {
-      if (fn != this->_wal->filename()) {
-        result.push_back(fn);
-      }
     }
   }
   return result;
@@ -134,7 +329,10 @@ std::list<std::string> WALManager::closedWals() {
 void WALManager::dropWAL(const std::string &fname, IWALDropper *storage) {
   WALFile_Ptr ptr = WALFile::open(_env, fname, false);
   auto without_path = utils::fs::extract_filename(fname);
-  _files_send_to_drop.emplace(without_path);
+  {
+    std::lock_guard<std::mutex> lg(_drop_locker);
+    _files_send_to_drop.emplace(without_path);
+  }
   storage->dropWAL(without_path);
 }
 
@@ -144,14 +342,17 @@ void WALManager::setDownlevel(IWALDropper *down) {
 }
 
 dariadb::Time WALManager::minTime() {
-  std::lock_guard<std::mutex> lg(_locker);
-  auto files = wal_files();
+  auto snapshot = read_snapshot(NEWEST_VERSION, [](const Meas &) { return true; });
   dariadb::Time result = dariadb::MAX_TIME;
-  auto env = _env;
-  AsyncTask at = [files, &result, env](const ThreadInfo &ti) {
+  AsyncTask at = [&snapshot, &result, this](const ThreadInfo &ti) {
     TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
-    for (auto filename : files) {
-      auto wal = WALFile::open(env, filename, true);
+    for (auto filename : snapshot.files) {
+      auto summary = cached_summary(filename);
+      if (summary != nullptr) {
+        result = std::min(summary->minTime(), result);
+        continue;
+      }
+      auto wal = open_wal(snapshot, filename);
       auto local = wal->minTime();
       result = std::min(local, result);
     }
@@ -161,26 +362,24 @@ dariadb::Time WALManager::minTime() {
   auto am_async = ThreadManager::instance()->post(THREAD_KINDS::DISK_IO, AT(at));
   am_async->wait();
 
-  size_t pos = 0;
-  for (auto &v : _buffer) {
+  for (auto &v : snapshot.buffered) {
     result = std::min(v.time, result);
-    ++pos;
-    if (pos > _buffer_pos) {
-      break;
-    }
   }
   return result;
 }
 
 dariadb::Time WALManager::maxTime() {
-  std::lock_guard<std::mutex> lg(_locker);
-  auto files = wal_files();
+  auto snapshot = read_snapshot(NEWEST_VERSION, [](const Meas &) { return true; });
   dariadb::Time result = dariadb::MIN_TIME;
-  auto env = _env;
-  AsyncTask at = [files, &result, env](const ThreadInfo &ti) {
+  AsyncTask at = [&snapshot, &result, this](const ThreadInfo &ti) {
     TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
-    for (auto filename : files) {
-      auto wal = WALFile::open(env, filename, true);
+    for (auto filename : snapshot.files) {
+      auto summary = cached_summary(filename);
+      if (summary != nullptr) {
+        result = std::max(summary->maxTime(), result);
+        continue;
+      }
+      auto wal = open_wal(snapshot, filename);
       auto local = wal->maxTime();
       result = std::max(local, result);
     }
@@ -189,7 +388,8 @@ dariadb::Time WALManager::maxTime() {
 
   auto am_async = ThreadManager::instance()->post(THREAD_KINDS::DISK_IO, AT(at));
   am_async->wait();
-  for (auto &v : _buffer) {
+
+  for (auto &v : snapshot.buffered) {
     result = std::max(v.time, result);
   }
   return result;
@@ -197,20 +397,23 @@ dariadb::Time WALManager::maxTime() {
 
 bool WALManager::minMaxTime(dariadb::Id id, dariadb::Time *minResult,
                             dariadb::Time *maxResult) {
-  std::lock_guard<std::mutex> lg(_locker);
-  auto files = wal_files();
+  auto snapshot = read_snapshot(NEWEST_VERSION, [id](const Meas &v) { return v.id == id; });
   using MMRes = std::tuple<bool, dariadb::Time, dariadb::Time>;
-  std::vector<MMRes> results{files.size()};
-  auto env = _env;
-  AsyncTask at = [files, &results, id, env](const ThreadInfo &ti) {
+  std::vector<MMRes> results{snapshot.files.size()};
+  AsyncTask at = [&snapshot, &results, id, this](const ThreadInfo &ti) {
     TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
     size_t num = 0;
 
-    for (auto filename : files) {
-
-      auto wal = WALFile::open(env, filename, true);
+    for (auto filename : snapshot.files) {
       dariadb::Time lmin = dariadb::MAX_TIME, lmax = dariadb::MIN_TIME;
-      if (wal->minMaxTime(id, &lmin, &lmax)) {
+      auto summary = cached_summary(filename);
+      bool found = false;
+      if (summary != nullptr) {
+        found = summary->minMaxTime(id, &lmin, &lmax);
+      } else {
+        found = open_wal(snapshot, filename)->minMaxTime(id, &lmin, &lmax);
+      }
+      if (found) {
         results[num] = MMRes(true, lmin, lmax);
       } else {
         results[num] = MMRes(false, lmin, lmax);
@@ -234,33 +437,29 @@ bool WALManager::minMaxTime(dariadb::Id id, dariadb::Time *minResult,
     }
   }
 
-  size_t pos = 0;
-  for (auto v : _buffer) {
-    if (v.id == id) {
-      res = true;
-      *minResult = std::min(v.time, *minResult);
-      *maxResult = std::max(v.time, *maxResult);
-    }
-    ++pos;
-    if (pos > _buffer_pos) {
-      break;
-    }
+  for (auto &v : snapshot.buffered) {
+    res = true;
+    *minResult = std::min(v.time, *minResult);
+    *maxResult = std::max(v.time, *maxResult);
   }
   return res;
 }
 
 void WALManager::foreach (const QueryInterval &q, IReaderClb * clbk) {
-  std::lock_guard<std::mutex> lg(_locker);
-  auto files = wal_files();
-  if (!files.empty()) {
-    auto env = _env;
-    AsyncTask at = [files, &q, clbk, env](const ThreadInfo &ti) {
+  auto snapshot = read_snapshot(q.version, [&q](const Meas &v) {
+    return v.inQuery(q.ids, q.flag, q.from, q.to);
+  });
+  if (!snapshot.files.empty()) {
+    AsyncTask at = [&snapshot, &q, clbk, this](const ThreadInfo &ti) {
       TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
-      for (auto filename : files) {
+      for (auto filename : snapshot.files) {
         if (clbk->is_canceled()) {
           break;
         }
-        auto wal = WALFile::open(env, filename, true);
+        if (!may_contain(filename, q.ids, q.from, q.to)) {
+          continue;
+        }
+        auto wal = open_wal(snapshot, filename);
         wal->foreach (q, clbk);
       }
       return false;
@@ -269,32 +468,30 @@ void WALManager::foreach (const QueryInterval &q, IReaderClb * clbk) {
     auto am_async = ThreadManager::instance()->post(THREAD_KINDS::DISK_IO, AT(at));
     am_async->wait();
   }
-  size_t pos = 0;
-  for (auto v : _buffer) {
-    if (pos >= _buffer_pos) {
-      break;
-    }
-    if (v.inQuery(q.ids, q.flag, q.from, q.to)) {
-      clbk->call(v);
-    }
-    ++pos;
+  ReaderClb_Batch batch(clbk);
+  // buffered values are written after last seal, so are not erased.
+  for (auto &v : snapshot.buffered) {
+    batch.append(v);
   }
 }
 
 Id2Meas WALManager::readTimePoint(const QueryTimePoint &query) {
-  std::lock_guard<std::mutex> lg(_locker);
-  auto files = wal_files();
+  dariadb::IdSet id_set(query.ids.begin(), query.ids.end());
+  auto snapshot = read_snapshot(query.version, [&query, &id_set](const Meas &v) {
+    return v.inQuery(id_set, query.flag) && (v.time <= query.time_point);
+  });
   dariadb::Id2Meas sub_result;
 
-  std::vector<Id2Meas> results{files.size()};
-  auto env = _env;
-  AsyncTask at = [files, &query, &results, env](const ThreadInfo &ti) {
+  std::vector<Id2Meas> results{snapshot.files.size()};
+  AsyncTask at = [&snapshot, &query, &results, this](const ThreadInfo &ti) {
     TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
     size_t num = 0;
 
-    for (auto filename : files) {
-      auto wal = WALFile::open(env, filename, true);
-      results[num] = wal->readTimePoint(query);
+    for (auto filename : snapshot.files) {
+      if (may_contain(filename, query.ids, MIN_TIME, query.time_point)) {
+        auto wal = open_wal(snapshot, filename);
+        results[num] = wal->readTimePoint(query);
+      }
       num++;
     }
     return false;
@@ -309,29 +506,23 @@ Id2Meas WALManager::readTimePoint(const QueryTimePoint &query) {
       if (it == sub_result.end()) {
         sub_result.emplace(std::make_pair(kv.first, kv.second));
       } else {
-        if (it->second.flag == Flags::_NO_DATA) {
-          sub_result[kv.first] = kv.second;
+        // files can be in any order, the newest value is taken.
+        if (kv.second.flag != Flags::_NO_DATA &&
+            (it->second.flag == Flags::_NO_DATA || it->second.time < kv.second.time)) {
+          it->second = kv.second;
         }
       }
     }
   }
-  size_t pos = 0;
-  for (auto v : _buffer) {
-    if (v.inQuery(query.ids, query.flag)) {
-      auto it = sub_result.find(v.id);
-      if (it == sub_result.end()) {
-        sub_result.emplace(std::make_pair(v.id, v));
-      } else {
-        if ((v.flag == Flags::_NO_DATA) ||
-            ((v.time > it->second.time) && (v.time <= query.time_point))) {
-          sub_result[v.id] = v;
-        }
+  for (auto &v : snapshot.buffered) {
+    auto it = sub_result.find(v.id);
+    if (it == sub_result.end()) {
+      sub_result.emplace(std::make_pair(v.id, v));
+    } else {
+      if ((it->second.flag == Flags::_NO_DATA) || (v.time > it->second.time)) {
+        sub_result[v.id] = v;
       }
     }
-    ++pos;
-    if (pos > _buffer_pos) {
-      break;
-    }
   }
 
   for (auto id : query.ids) {
@@ -344,76 +535,229 @@ Id2Meas WALManager::readTimePoint(const QueryTimePoint &query) {
 }
 
 Id2Meas WALManager::currentValue(const IdArray &ids, const Flag &flag) {
+  auto snapshot = read_snapshot(NEWEST_VERSION, [&ids, flag](const Meas &v) {
+    return v.inFlag(flag) && v.inIds(ids);
+  });
   dariadb::Id2Meas meases;
-  AsyncTask at = [&ids, flag, &meases, this](const ThreadInfo &ti) {
+  auto merge = [&meases](const Meas &m) {
+    auto it = meases.find(m.id);
+    if (it == meases.end()) {
+      meases.emplace(std::make_pair(m.id, m));
+    } else {
+      if ((it->second.flag == Flags::_NO_DATA) || (it->second.time < m.time)) {
+        meases[m.id] = m;
+      }
+    }
+  };
+  AsyncTask at = [&snapshot, &ids, flag, &merge, this](const ThreadInfo &ti) {
     TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
 
-    auto files = wal_files();
-
-    for (const auto &f : files) {
-      auto c = WALFile::open(_env, f, true);
+    for (const auto &f : snapshot.files) {
+      if (!may_contain(f, ids, MIN_TIME, MAX_TIME)) {
+        continue;
+      }
+      auto c = open_wal(snapshot, f);
       auto sub_rdr = c->currentValue(ids, flag);
 
       for (auto &kv : sub_rdr) {
-        auto it = meases.find(kv.first);
-        if (it == meases.end()) {
-          meases.emplace(std::make_pair(kv.first, kv.second));
-        } else {
-          if ((it->second.flag == Flags::_NO_DATA) ||
-              (it->second.time < kv.second.time)) {
-            meases[kv.first] = kv.second;
-          }
-        }
+        merge(kv.second);
       }
     }
     return false;
   };
   auto am_async = ThreadManager::instance()->post(THREAD_KINDS::DISK_IO, AT(at));
   am_async->wait();
+
+  for (auto &v : snapshot.buffered) {
+    merge(v);
+  }
   return meases;
 }
 
 dariadb::Status WALManager::append(const Meas &value) {
-  std::lock_guard<std::mutex> lg(_locker);
-  _buffer[_buffer_pos] = value;
-  _buffer_pos++;
-
-  if (_buffer_pos >= _settings->wal_cache_size.value()) {
-    flush_buffer();
+  if (_down != nullptr) {
+    auto err = _down->admit();
+    if (err != APPEND_ERROR::OK) {
+      return Status::rejected(err);
+    }
+  }
+  auto &sh = shard(value.id);
+  std::unique_lock<std::mutex> lg(sh.locker);
+  auto mode = _settings->wal_sync.value();
+  if (mode == WAL_SYNC::ALWAYS) {
+    // buffer is full only while other thread writes a batch.
+    while (sh.buffer_pos >= sh.buffer.size()) {
+      sh.batch_cond.wait(lg);
+    }
+  }
+  sh.buffer[sh.buffer_pos] = value;
+  sh.buffer_pos++;
+
+  if (mode == WAL_SYNC::ALWAYS) {
+    group_commit(sh, lg);
+  } else {
+    if (sh.buffer_pos >= sh.buffer.size() ||
+        (mode == WAL_SYNC::INTERVAL && need_sync(sh))) {
+      flush_buffer(sh);
+    }
   }
   return dariadb::Status(1, 0);
 }
 
-void WALManager::flush_buffer() {
-  if (_buffer_pos == size_t(0)) {
+dariadb::Status WALManager::append(const MeasArray::const_iterator &begin,
+                                   const MeasArray::const_iterator &end) {
+  if (begin == end) {
+    return Status();
+  }
+  if (_down != nullptr) {
+    auto err = _down->admit();
+    if (err != APPEND_ERROR::OK) {
+      return Status::rejected(err);
+    }
+  }
+  auto mode = _settings->wal_sync.value();
+  size_t writed = 0;
+  auto it = begin;
+  while (it != end) {
+    auto &sh = shard(it->id);
+    std::unique_lock<std::mutex> lg(sh.locker);
+    for (; it != end && &shard(it->id) == &sh; ++it) {
+      if (mode == WAL_SYNC::ALWAYS) {
+        while (sh.buffer_pos >= sh.buffer.size()) {
+          group_commit(sh, lg);
+        }
+      }
+      sh.buffer[sh.buffer_pos] = *it;
+      sh.buffer_pos++;
+      writed++;
+
+      if (mode != WAL_SYNC::ALWAYS &&
+          (sh.buffer_pos >= sh.buffer.size() ||
+           (mode == WAL_SYNC::INTERVAL && need_sync(sh)))) {
+        flush_buffer(sh);
+      }
+    }
+    if (mode == WAL_SYNC::ALWAYS) {
+      group_commit(sh, lg);
+    }
+  }
+  return dariadb::Status(writed, 0);
+}
+
+void WALManager::group_commit(Shard &sh, std::unique_lock<std::mutex> &lock) {
+  auto my_batch = sh.batch_num;
+  while (sh.synced_batch < my_batch) {
+    if (sh.batch_writing) {
+      sh.batch_cond.wait(lock);
+      continue;
+    }
+    // this thread is a leader: write all pending values with one write and one sync.
+    sh.batch_writing = true;
+    std::swap(sh.buffer, sh.batch_buffer);
+    auto count = sh.buffer_pos;
+    auto batch = sh.batch_num;
+    sh.buffer_pos = 0;
+    sh.batch_num++;
+
+    lock.unlock();
+    try {
+      write_buffer(sh, sh.batch_buffer, count, true);
+    } catch (...) {
+      lock.lock();
+      sh.batch_writing = false;
+      sh.batch_cond.notify_all();
+      throw;
+    }
+    lock.lock();
+
+    sh.synced_batch = batch;
+    sh.batch_writing = false;
+    sh.batch_cond.notify_all();
+  }
+}
+
+void WALManager::wait_batch_writing(Shard &sh, std::unique_lock<std::mutex> &lock) {
+  while (sh.batch_writing) {
+    sh.batch_cond.wait(lock);
+  }
+}
+
+bool WALManager::need_sync(const Shard &sh) const {
+  switch (_settings->wal_sync.value()) {
+  case WAL_SYNC::NONE:
+    return false;
+  case WAL_SYNC::INTERVAL: {
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - sh.last_sync);
+    return uint64_t(elapsed.count()) >= _settings->wal_sync_interval.value();
+  }
+  default:
+    return true;
+  }
+}
+
+void WALManager::flush_buffer(Shard &sh) {
+  if (sh.buffer_pos == size_t(0)) {
     return;
   }
-  AsyncTask at = [this](const ThreadInfo &ti) {
+  write_buffer(sh, sh.buffer, sh.buffer_pos, need_sync(sh));
+  sh.buffer_pos = 0;
+  sh.batch_num++;
+  sh.synced_batch = sh.batch_num - 1;
+  sh.batch_cond.notify_all();
+}
+
+void WALManager::write_buffer(Shard &sh, const MeasArray &buf, size_t count, bool sync) {
+  AsyncTask at = [this, &sh, &buf, count, sync](const ThreadInfo &ti) {
     TKIND_CHECK(THREAD_KINDS::DISK_IO, ti.kind);
-    if (_wal == nullptr) {
-      create_new();
+    if (sh.wal == nullptr) {
+      create_new(sh);
     }
     size_t pos = 0;
     size_t total_writed = 0;
     while (1) {
-      auto res = _wal->append(_buffer.begin() + pos, _buffer.begin() + _buffer_pos);
+      auto res = sh.wal->append(buf.begin() + pos, buf.begin() + count);
       total_writed += res.writed;
-      if (total_writed != _buffer_pos) {
-        create_new();
+      if (total_writed != count) {
+        if (sync) {
+          sh.wal->sync();
+        }
+        create_new(sh);
         pos += res.writed;
       } else {
         break;
       }
     }
-    _buffer_pos = 0;
+    if (sync) {
+      sh.wal->sync();
+    }
     return false;
   };
   auto async_r = ThreadManager::instance()->post(THREAD_KINDS::DISK_IO, AT(at));
   async_r->wait();
+  if (sync) {
+    sh.last_sync = std::chrono::steady_clock::now();
+  }
 }
 
 void WALManager::flush() {
-  flush_buffer();
+  for (auto &sh : _shards) {
+    std::unique_lock<std::mutex> lg(sh->locker);
+    wait_batch_writing(*sh, lg);
+    flush_buffer(*sh);
+  }
+}
+
+uint64_t WALManager::seal() {
+  // files, created while shards are sealed, are not covered.
+  auto result = _next_seq.load();
+  for (auto &sh : _shards) {
+    std::unique_lock<std::mutex> lg(sh->locker);
+    wait_batch_writing(*sh, lg);
+    flush_buffer(*sh);
+    set_active(*sh, nullptr);
+  }
+  return result;
 }
 
 size_t WALManager::filesCount() const {
@@ -421,8 +765,35 @@ size_t WALManager::filesCount() const {
 }
 
 void WALManager::erase(const std::string &fname) {
+  VersionSet::Edit edit(_versions);
+  auto full_path = utils::fs::append_path(_settings->raw_path.value(), fname);
+  {
+    std::lock_guard<std::mutex> lg(_retired_locker);
+    _retired[full_path] = edit.version();
+  }
   _env->getResourceObject<Manifest>(EngineEnvironment::Resource::MANIFEST)->wal_rm(fname);
-  utils::fs::rm(utils::fs::append_path(_settings->raw_path.value(), fname));
+  edit.retire([this, full_path]() { reclaim(full_path); });
+}
+
+void WALManager::reclaim(const std::string &full_path) {
+  {
+    std::lock_guard<std::mutex> lg(_retired_locker);
+    _retired.erase(full_path);
+  }
+  {
+    std::lock_guard<std::mutex> lg(_summaries_locker);
+    _summaries.erase(full_path);
+  }
+  std::lock_guard<std::mutex> lg(_free_locker);
+  // old-format files and overflow of pool are removed.
+  if (_free_segments.size() < MAX_FREE_SEGMENTS && WALFile::sequence(full_path) != 0) {
+    auto free_path = utils::fs::append_path(_settings->raw_path.value(),
+                                            utils::fs::random_file_name(WAL_FREE_EXT));
+    utils::fs::rename(full_path, free_path);
+    _free_segments.push_back(free_path);
+  } else {
+    utils::fs::rm(full_path);
+  }
 }
 
 Id2MinMax WALManager::loadMinMax() {
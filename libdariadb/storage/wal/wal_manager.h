@@ -4,12 +4,23 @@
 #include <libdariadb/interfaces/imeasstorage.h>
 #include <libdariadb/st_exports.h>
 #include <libdariadb/storage/settings.h>
+#include <libdariadb/storage/tombstones.h>
+#include <libdariadb/storage/version_set.h>
 #include <libdariadb/storage/wal/walfile.h>
 #include <libdariadb/utils/async/locker.h>
 #include <libdariadb/utils/utils.h>
 #include <vector>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
 
 namespace dariadb {
 namespace storage {
@@ -34,7 +45,11 @@ public:
   EXPORT virtual Id2Meas readTimePoint(const QueryTimePoint &q) override;
   EXPORT virtual Id2Meas currentValue(const IdArray &ids,
                                       const Flag &flag) override;
+  using IMeasStorage::append;
   EXPORT virtual Status append(const Meas &value) override;
+  /// values of one shard are appended under one lock.
+  EXPORT virtual Status append(const MeasArray::const_iterator &begin,
+                               const MeasArray::const_iterator &end) override;
   EXPORT virtual void flush() override;
 
   EXPORT std::list<std::string> closedWals();
@@ -43,31 +58,124 @@ public:
   EXPORT size_t filesCount() const;
   EXPORT void setDownlevel(IWALDropper *down);
 
+  /// file is removed from manifest at once, and from disk after readers of older versions.
   EXPORT void erase(const std::string &fname);
 
+  /// close active files: values written before are in files with less sequence.
+  /// return sequence of next file.
+  EXPORT uint64_t seal();
+
   EXPORT void dropClosedFiles(size_t count);
   EXPORT void dropAll();
 
   EXPORT Id2MinMax loadMinMax() override;
 
 protected:
-  void create_new();
-  std::list<std::string> wal_files() const;
-  void flush_buffer();
+  /// one writer: buffer and active file. values of one id always go to one shard.
+  struct Shard {
+    WALFile_Ptr wal;
+    std::mutex locker;
+
+    MeasArray buffer;
+    size_t buffer_pos;
+    // group commit
+    MeasArray batch_buffer; // batch in writing.
+    uint64_t batch_num;     // number of batch, which collect new values.
+    uint64_t synced_batch;  // number of last batch written to disk.
+    bool batch_writing;
+    std::condition_variable batch_cond;
+    std::chrono::steady_clock::time_point last_sync;
+  };
+  using ShardsLock = std::vector<std::unique_lock<std::mutex>>;
+
+  /// files and buffered values for one reader. taken under locks of all shards,
+  /// files are readed without locks.
+  struct ReadSnapshot {
+    std::list<std::string> files;
+    std::map<std::string, uint64_t> ends; // written part of active files.
+    MeasArray buffered;
+  };
+
+  Shard &shard(Id id) { return *_shards[id % _shards.size()]; }
+  /// lock all shards and wait end of batches writing.
+  ShardsLock lock_all();
+  /// files of version and buffered values, for which 'pred' is true.
+  template <class P> ReadSnapshot read_snapshot(uint64_t version, P pred) {
+    ReadSnapshot result;
+    auto locks = lock_all();
+    result.files = wal_files(version);
+    for (auto &sh : _shards) {
+      if (sh->wal != nullptr) {
+        result.ends[sh->wal->filename()] = sh->wal->end_offset();
+      }
+      for (size_t pos = 0; pos < sh->buffer_pos; ++pos) {
+        if (pred(sh->buffer[pos])) {
+          result.buffered.push_back(sh->buffer[pos]);
+        }
+      }
+    }
+    return result;
+  }
+  /// open file of snapshot: values, writed after snapshot, are not readed.
+  WALFile_Ptr open_wal(const ReadSnapshot &snapshot, const std::string &fname);
+
+  void create_new(Shard &sh);
+  void set_active(Shard &sh, const WALFile_Ptr &wal);
+  /// files of version: from manifest and removed ones, which are still visible.
+  std::list<std::string> wal_files(uint64_t version = NEWEST_VERSION) const;
+  /// return erased file to free segments or remove it.
+  void reclaim(const std::string &full_path);
+  void flush_buffer(Shard &sh);
+  /// write 'count' values from 'buf' to wal files. called without shard lock in ALWAYS mode.
+  void write_buffer(Shard &sh, const MeasArray &buf, size_t count, bool sync);
+  bool need_sync(const Shard &sh) const;
+  /// WAL_SYNC::ALWAYS: wait while the batch with the appended value is on disk.
+  void group_commit(Shard &sh, std::unique_lock<std::mutex> &lock);
+  void wait_batch_writing(Shard &sh, std::unique_lock<std::mutex> &lock);
+  /// WAL_SYNC::INTERVAL: flush buffers of shards, which were not synced
+  /// 'wal_sync_interval' ms, when no values are appended to them.
+  void sync_thread_func();
   void drop_old_if_needed();
+  /// free segment for reuse or empty string.
+  std::string pop_free_segment();
+  /// open file with cached summary.
+  WALFile_Ptr open_wal(const std::string &fname);
+  /// nullptr if summary of file is not built yet.
+  WALFileSummary_ptr cached_summary(const std::string &fname);
+  /// false - if cached summary of file has no values of 'ids' in [from, to].
+  bool may_contain(const std::string &fname, const IdArray &ids, Time from, Time to);
+  void cache_summary(const WALFile_Ptr &wal);
 
 private:
   EXPORT static WALManager *_instance;
 
-  WALFile_Ptr _wal;
-  mutable std::mutex _locker;
+  std::vector<std::unique_ptr<Shard>> _shards;
+  // names of files in use by shards.
+  std::set<std::string> _active_files;
+  mutable std::mutex _active_locker;
   IWALDropper *_down;
 
-  MeasArray _buffer;
-  size_t _buffer_pos;
   std::set<std::string> _files_send_to_drop;
+  std::mutex _drop_locker;
+  // segments recycling
+  std::atomic<uint64_t> _next_seq;
+  std::list<std::string> _free_segments;
+  std::mutex _free_locker;
+  // summaries of files (full path as key).
+  std::unordered_map<std::string, WALFileSummary_ptr> _summaries;
+  std::mutex _summaries_locker;
+  // erased files (full path as key), used by readers. value - version of erase.
+  std::map<std::string, uint64_t> _retired;
+  mutable std::mutex _retired_locker;
+  VersionSet *_versions;
   EngineEnvironment_ptr _env;
   Settings *_settings;
+  Tombstones *_tombstones;
+
+  std::thread _sync_thread;
+  bool _sync_stop;
+  std::mutex _sync_locker;
+  std::condition_variable _sync_cond;
 };
 }
 }
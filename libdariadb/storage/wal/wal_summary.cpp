@@ -0,0 +1,174 @@
+#include <libdariadb/storage/wal/wal_summary.h>
+#include <algorithm>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+using namespace dariadb;
+using namespace dariadb::storage;
+
+class WALFileSummary::Private {
+public:
+  struct BlockRef {
+    uint64_t offset;
+    Time min;
+    Time max;
+  };
+
+  struct IdInfo {
+    Time min;
+    Time max;
+    std::vector<BlockRef> blocks;
+  };
+
+  Private() {
+    _min = MAX_TIME;
+    _max = MIN_TIME;
+  }
+
+  void append(uint64_t block_offset, const Meas &value) {
+    std::lock_guard<std::shared_mutex> lg(_locker);
+    _min = std::min(_min, value.time);
+    _max = std::max(_max, value.time);
+
+    auto fres = _ids.find(value.id);
+    if (fres == _ids.end()) {
+      IdInfo info;
+      info.min = info.max = value.time;
+      info.blocks.push_back(BlockRef{block_offset, value.time, value.time});
+      _ids.emplace(std::make_pair(value.id, info));
+      return;
+    }
+    auto &info = fres->second;
+    info.min = std::min(info.min, value.time);
+    info.max = std::max(info.max, value.time);
+    auto &last = info.blocks.back();
+    if (last.offset == block_offset) {
+      last.min = std::min(last.min, value.time);
+      last.max = std::max(last.max, value.time);
+    } else {
+      info.blocks.push_back(BlockRef{block_offset, value.time, value.time});
+    }
+  }
+
+  bool empty() const {
+    std::shared_lock<std::shared_mutex> lg(_locker);
+    return _ids.empty();
+  }
+
+  static bool in_interval(Time from, Time to, Time min, Time max) {
+    return min <= to && max >= from;
+  }
+
+  bool contains(const IdArray &ids, Time from, Time to) const {
+    std::shared_lock<std::shared_mutex> lg(_locker);
+    if (ids.empty()) {
+      return !_ids.empty() && in_interval(from, to, _min, _max);
+    }
+    for (auto id : ids) {
+      auto fres = _ids.find(id);
+      if (fres != _ids.end() && in_interval(from, to, fres->second.min, fres->second.max)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  Time minTime() const {
+    std::shared_lock<std::shared_mutex> lg(_locker);
+    return _min;
+  }
+
+  Time maxTime() const {
+    std::shared_lock<std::shared_mutex> lg(_locker);
+    return _max;
+  }
+
+  bool minMaxTime(Id id, Time *minResult, Time *maxResult) const {
+    std::shared_lock<std::shared_mutex> lg(_locker);
+    auto fres = _ids.find(id);
+    if (fres == _ids.end()) {
+      return false;
+    }
+    *minResult = fres->second.min;
+    *maxResult = fres->second.max;
+    return true;
+  }
+
+  void append_blocks(const IdInfo &info, Time from, Time to,
+                     std::vector<uint64_t> *result) const {
+    if (!in_interval(from, to, info.min, info.max)) {
+      return;
+    }
+    for (auto &b : info.blocks) {
+      if (in_interval(from, to, b.min, b.max)) {
+        result->push_back(b.offset);
+      }
+    }
+  }
+
+  std::vector<uint64_t> blocks(const IdArray &ids, Time from, Time to) const {
+    std::vector<uint64_t> result;
+    {
+      std::shared_lock<std::shared_mutex> lg(_locker);
+      if (ids.empty()) {
+        for (auto &kv : _ids) {
+          append_blocks(kv.second, from, to, &result);
+        }
+      } else {
+        for (auto id : ids) {
+          auto fres = _ids.find(id);
+          if (fres != _ids.end()) {
+            append_blocks(fres->second, from, to, &result);
+          }
+        }
+      }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+  }
+
+protected:
+  mutable std::shared_mutex _locker;
+  std::unordered_map<Id, IdInfo> _ids;
+  Time _min;
+  Time _max;
+};
+
+WALFileSummary_ptr WALFileSummary::create() {
+  return WALFileSummary_ptr{new WALFileSummary()};
+}
+
+WALFileSummary::WALFileSummary() : _impl(new WALFileSummary::Private()) {}
+
+WALFileSummary::~WALFileSummary() {}
+
+void WALFileSummary::append(uint64_t block_offset, const Meas &value) {
+  _impl->append(block_offset, value);
+}
+
+bool WALFileSummary::empty() const {
+  return _impl->empty();
+}
+
+bool WALFileSummary::contains(const IdArray &ids, Time from, Time to) const {
+  return _impl->contains(ids, from, to);
+}
+
+Time WALFileSummary::minTime() const {
+  return _impl->minTime();
+}
+
+Time WALFileSummary::maxTime() const {
+  return _impl->maxTime();
+}
+
+bool WALFileSummary::minMaxTime(Id id, Time *minResult, Time *maxResult) const {
+  return _impl->minMaxTime(id, minResult, maxResult);
+}
+
+std::vector<uint64_t> WALFileSummary::blocks(const IdArray &ids, Time from,
+                                             Time to) const {
+  return _impl->blocks(ids, from, to);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <libdariadb/meas.h>
+#include <libdariadb/st_exports.h>
+#include <libdariadb/utils/utils.h>
+#include <memory>
+#include <vector>
+
+namespace dariadb {
+namespace storage {
+
+class WALFileSummary;
+using WALFileSummary_ptr = std::shared_ptr<WALFileSummary>;
+
+/// in-memory index of wal file: per-id time bounds and offsets of blocks.
+class WALFileSummary : public utils::NonCopy {
+public:
+  EXPORT static WALFileSummary_ptr create();
+  EXPORT ~WALFileSummary();
+
+  /// register value, stored in block with 'block_offset'.
+  EXPORT void append(uint64_t block_offset, const Meas &value);
+
+  EXPORT bool empty() const;
+  EXPORT bool contains(const IdArray &ids, Time from, Time to) const;
+  EXPORT Time minTime() const;
+  EXPORT Time maxTime() const;
+  EXPORT bool minMaxTime(Id id, Time *minResult, Time *maxResult) const;
+  /// sorted offsets of blocks with values of 'ids' in [from, to]. empty 'ids' - all ids.
+  EXPORT std::vector<uint64_t> blocks(const IdArray &ids, Time from, Time to) const;
+
+protected:
+  WALFileSummary();
+
+  class Private;
+  std::unique_ptr<Private> _impl;
+};
+}
+}
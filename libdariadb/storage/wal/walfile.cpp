@@ -5,27 +5,160 @@
 #include <libdariadb/storage/callbacks.h>
 #include <libdariadb/storage/manifest.h>
 #include <libdariadb/storage/settings.h>
+#include <libdariadb/storage/tombstones.h>
+#include <libdariadb/storage/wal/wal_block.h>
 #include <libdariadb/storage/wal/walfile.h>
+#include <libdariadb/utils/crc.h>
 #include <libdariadb/utils/fs.h>
 
+#ifdef MSVC
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #include <algorithm>
 
 #include <cstdio>
 #include <cstring>
 #include <fstream>
+#include <limits>
 #include <mutex>
 #include <sstream>
 
 using namespace dariadb;
 using namespace dariadb::storage;
 
+/**
+File layout:
+  WALFileHeader
+  [WALBlockHeader, payload] ...
+Payload of version 1 is raw Meas array, version 2 - encoded by WALBlockWriter.
+Segments are preallocated and recycled, so the tail of file can contain
+zeros or blocks from previous usage of segment. Those blocks have other 'seq'.
+Files without header (old format) is a raw array of Meas.
+*/
+namespace {
+const uint32_t WAL_MAGIC = 0x4C415744; // "DWAL"
+const uint32_t WAL_FORMAT_RAW = 1;
+const uint32_t WAL_FORMAT_ENCODED = 2;
+const uint32_t WAL_FORMAT = WAL_FORMAT_ENCODED;
+/// upper bound of encoded value size: dictionary entry, index, time, xor value, flag.
+const size_t MAX_ENCODED_MEAS_SIZE = 5 + 10 + 10 + 9 + 5;
+const size_t LEGACY_READ_BATCH = 4096;
+
+#pragma pack(push, 1)
+struct WALFileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t seq;
+};
+
+struct WALBlockHeader {
+  uint64_t seq;   // equal to WALFileHeader::seq for live blocks.
+  uint32_t count; // values in block.
+  uint32_t size;  // payload size in bytes.
+  uint32_t crc;   // payload checksum.
+};
+#pragma pack(pop)
+
+struct WALFileInfo {
+  bool exists = false;
+  bool legacy = false;
+  uint64_t seq = 0;
+  uint32_t version = 0;
+  size_t count = 0;     // live values count.
+  uint64_t end_pos = 0; // end of last live block.
+};
+
+bool read_file_header(FILE *file, WALFileHeader *hdr) {
+  std::fseek(file, 0, SEEK_SET);
+  if (std::fread(hdr, sizeof(WALFileHeader), 1, file) != 1) {
+    return false;
+  }
+  return hdr->magic == WAL_MAGIC;
+}
+
+/// read next live block to 'buffer'. return false on end of live data.
+bool read_block(FILE *file, const WALFileHeader &hdr, WALBlockHeader *bhdr,
+                std::vector<uint8_t> *buffer) {
+  if (std::fread(bhdr, sizeof(WALBlockHeader), 1, file) != 1) {
+    return false;
+  }
+  if (bhdr->seq != hdr.seq || bhdr->count == 0) {
+    return false;
+  }
+  if (hdr.version == WAL_FORMAT_RAW) {
+    if (bhdr->size != bhdr->count * sizeof(Meas)) {
+      return false;
+    }
+  } else if (bhdr->size > size_t(bhdr->count) * MAX_ENCODED_MEAS_SIZE + 10) {
+    return false;
+  }
+  buffer->resize(bhdr->size);
+  if (std::fread(buffer->data(), bhdr->size, 1, file) != 1) {
+    return false;
+  }
+  return utils::crc32(buffer->data(), buffer->size()) == bhdr->crc;
+}
+
+/// blocks are readed and checked only if 'scan_blocks' is true, else 'count' and
+/// 'end_pos' are known for legacy files only.
+WALFileInfo read_info(const std::string &fname, bool scan_blocks) {
+  WALFileInfo result;
+  auto file = std::fopen(fname.c_str(), "rb");
+  if (file == nullptr) {
+    return result;
+  }
+  result.exists = true;
+  WALFileHeader hdr;
+  if (!read_file_header(file, &hdr)) {
+    result.legacy = true;
+    std::fseek(file, 0, SEEK_END);
+    result.end_pos = std::ftell(file);
+    result.count = size_t(result.end_pos / sizeof(Meas));
+    std::fclose(file);
+    return result;
+  }
+  result.seq = hdr.seq;
+  result.version = hdr.version;
+  result.end_pos = sizeof(WALFileHeader);
+  WALBlockHeader bhdr;
+  std::vector<uint8_t> buffer;
+  while (scan_blocks && read_block(file, hdr, &bhdr, &buffer)) {
+    result.count += bhdr.count;
+    result.end_pos += sizeof(WALBlockHeader) + bhdr.size;
+  }
+  std::fclose(file);
+  return result;
+}
+
+void preallocate(FILE *file, uint64_t size) {
+#ifdef MSVC
+  (void)file;
+  (void)size;
+#else
+  posix_fallocate(fileno(file), 0, size);
+#endif
+}
+}
+
 class WALFile::Private {
 public:
-  Private(const EngineEnvironment_ptr env) {
+  Private(const EngineEnvironment_ptr env, uint64_t seq, const std::string &recycled) {
     _env = env;
     _settings = _env->getResourceObject<Settings>(EngineEnvironment::Resource::SETTINGS);
+    init_tombstones();
     _writed = 0;
     _is_readonly = false;
+    _legacy = false;
+    _seq = seq;
+    _version = WAL_FORMAT;
+    _write_pos = sizeof(WALFileHeader);
+    _read_end = std::numeric_limits<uint64_t>::max();
+    _recycled = recycled;
+    _summary = WALFileSummary::create();
     auto rnd_fname = utils::fs::random_file_name(WAL_FILE_EXT);
     _filename = utils::fs::append_path(_settings->raw_path.value(), rnd_fname);
     _env->getResourceObject<Manifest>(EngineEnvironment::Resource::MANIFEST)
@@ -33,10 +166,22 @@ public:
     _file = nullptr;
   }
 
-  Private(const EngineEnvironment_ptr env, const std::string &fname, bool readonly) {
+  Private(const EngineEnvironment_ptr env, const std::string &fname, bool readonly,
+          const WALFileSummary_ptr &summary) {
     _env = env;
+    _summary = summary;
     _settings = _env->getResourceObject<Settings>(EngineEnvironment::Resource::SETTINGS);
-    _writed = WALFile::writed(fname);
+    init_tombstones();
+    // read-only file with summary is not scanned: queries seek to blocks by summary,
+    // values count and end of file stay unknown.
+    auto scan = !readonly || summary == nullptr;
+    auto info = read_info(fname, scan);
+    _writed = info.count;
+    _legacy = info.legacy;
+    _seq = info.seq;
+    _version = info.exists ? info.version : WAL_FORMAT;
+    _write_pos = scan || info.legacy ? info.end_pos : std::numeric_limits<uint64_t>::max();
+    _read_end = std::numeric_limits<uint64_t>::max();
     _is_readonly = readonly;
     _filename = fname;
     _file = nullptr;
@@ -50,26 +195,127 @@ public:
     }
   }
 
+  void init_tombstones() {
+    _tombstones = nullptr;
+    if (_env->hasResource(EngineEnvironment::Resource::TOMBSTONES)) {
+      _tombstones =
+          _env->getResourceObject<Tombstones>(EngineEnvironment::Resource::TOMBSTONES);
+    }
+  }
+
+  /// intervals of tombstones, which cover values of this file.
+  Id2Erased erased(const IdArray &ids) const {
+    if (_tombstones == nullptr) {
+      return Id2Erased();
+    }
+    return _tombstones->erased(ids, LEVEL::WAL, _seq);
+  }
+
+  static bool is_erased(const Id2Erased &erased, const Meas &m) {
+    if (erased.empty()) {
+      return false;
+    }
+    auto fres = erased.find(m.id);
+    return fres != erased.end() && fres->second.contains(m.time);
+  }
+
+  /// estimation of full file size. file grows, if encoded values are larger.
+  uint64_t preallocated_size() const {
+    auto values = _settings->wal_file_size.value();
+    auto blocks = values / std::max(_settings->wal_cache_size.value(), uint64_t(1)) + 1;
+    auto value_size = _version == WAL_FORMAT_RAW ? sizeof(Meas) : sizeof(Meas) / 2;
+    return sizeof(WALFileHeader) + values * value_size + blocks * sizeof(WALBlockHeader);
+  }
+
   void open_to_append() {
     if (_file != nullptr) {
       return;
     }
+    if (_legacy) {
+      _file = std::fopen(_filename.c_str(), "ab");
+      if (_file == nullptr) {
+        throw MAKE_EXCEPTION("WALFile: open_to_append error.");
+      }
+      return;
+    }
 
-    _file = std::fopen(_filename.c_str(), "ab");
-    if (_file == nullptr) {
-      throw MAKE_EXCEPTION("WALFile: open_to_append error.");
+    if (!utils::fs::file_exists(_filename)) {
+      WALFileHeader hdr;
+      hdr.magic = WAL_MAGIC;
+      hdr.version = _version;
+      hdr.seq = _seq;
+      if (!_recycled.empty() && utils::fs::file_exists(_recycled)) {
+        // new header is written before rename, so old blocks never become live.
+        auto free_segment = std::fopen(_recycled.c_str(), "r+b");
+        if (free_segment == nullptr) {
+          throw MAKE_EXCEPTION("WALFile: open_to_append error.");
+        }
+        std::fwrite(&hdr, sizeof(WALFileHeader), 1, free_segment);
+        std::fclose(free_segment);
+        utils::fs::rename(_recycled, _filename);
+        _file = std::fopen(_filename.c_str(), "r+b");
+      } else {
+        _file = std::fopen(_filename.c_str(), "w+b");
+        if (_file != nullptr) {
+          preallocate(_file, preallocated_size());
+          std::fwrite(&hdr, sizeof(WALFileHeader), 1, _file);
+        }
+      }
+      if (_file == nullptr) {
+        throw MAKE_EXCEPTION("WALFile: open_to_append error.");
+      }
+      _recycled.clear();
+      _write_pos = sizeof(WALFileHeader);
+    } else {
+      _file = std::fopen(_filename.c_str(), "r+b");
+      if (_file == nullptr) {
+        throw MAKE_EXCEPTION("WALFile: open_to_append error.");
+      }
     }
+    std::fseek(_file, long(_write_pos), SEEK_SET);
   }
 
-  void open_to_read() {
-    if (_file != nullptr) {
-      std::fclose(_file);
-      _file = nullptr;
-    }
-    _file = std::fopen(_filename.c_str(), "rb");
-    if (_file == nullptr) {
+  FILE *open_to_read() const {
+    auto file = std::fopen(_filename.c_str(), "rb");
+    if (file == nullptr) {
       throw_open_error_exception();
     }
+    return file;
+  }
+
+  /// write values with one write call.
+  void write_block(const Meas *values, size_t count) {
+    open_to_append();
+    auto block_offset = _write_pos;
+    if (_legacy) {
+      std::fwrite(values, sizeof(Meas), count, _file);
+      _write_pos += count * sizeof(Meas);
+    } else {
+      _write_buffer.resize(sizeof(WALBlockHeader));
+      if (_version == WAL_FORMAT_RAW) {
+        auto raw = reinterpret_cast<const uint8_t *>(values);
+        _write_buffer.insert(_write_buffer.end(), raw, raw + count * sizeof(Meas));
+      } else {
+        _encoder.encode(values, count, &_write_buffer);
+      }
+
+      WALBlockHeader bhdr;
+      bhdr.seq = _seq;
+      bhdr.count = uint32_t(count);
+      bhdr.size = uint32_t(_write_buffer.size() - sizeof(WALBlockHeader));
+      bhdr.crc = utils::crc32(_write_buffer.data() + sizeof(WALBlockHeader), bhdr.size);
+      std::memcpy(_write_buffer.data(), &bhdr, sizeof(WALBlockHeader));
+      std::fwrite(_write_buffer.data(), _write_buffer.size(), 1, _file);
+      _write_pos += _write_buffer.size();
+    }
+    std::fflush(_file);
+    _writed += count;
+    // values are visible for readers of summary only after write.
+    if (_summary != nullptr && !_legacy) {
+      for (size_t i = 0; i < count; ++i) {
+        _summary->append(block_offset, values[i]);
+      }
+    }
   }
 
   Status append(const Meas &value) {
@@ -78,10 +324,7 @@ public:
     if (_writed > _settings->wal_file_size.value()) {
       return Status(0, 1);
     }
-    open_to_append();
-    std::fwrite(&value, sizeof(Meas), size_t(1), _file);
-    std::fflush(_file);
-    _writed++;
+    write_block(&value, size_t(1));
     return Status(1, 0);
   }
 
@@ -90,12 +333,11 @@ public:
     ENSURE(!_is_readonly);
 
     auto sz = std::distance(begin, end);
-    open_to_append();
     auto max_size = _settings->wal_file_size.value();
     auto write_size = (sz + _writed) > max_size ? (max_size - _writed) : sz;
-    std::fwrite(&(*begin), sizeof(Meas), write_size, _file);
-    std::fflush(_file);
-    _writed += write_size;
+    if (write_size != 0) {
+      write_block(&(*begin), write_size);
+    }
     return Status(write_size, 0);
   }
 
@@ -104,55 +346,154 @@ public:
     ENSURE(!_is_readonly);
 
     auto list_size = std::distance(begin, end);
-    open_to_append();
-
     auto max_size = _settings->wal_file_size.value();
 
     auto write_size = (list_size + _writed) > max_size ? (max_size - _writed) : list_size;
-    MeasArray ma{begin, end};
-    std::fwrite(ma.data(), sizeof(Meas), write_size, _file);
-    std::fflush(_file);
-    _writed += write_size;
+    if (write_size != 0) {
+      MeasArray ma{begin, end};
+      write_block(ma.data(), write_size);
+    }
     return Status(write_size, 0);
   }
 
-  void foreach (const QueryInterval &q, IReaderClb * clbk) {
-    open_to_read();
+  /// call 'f' for each stored value. stop reading if 'f' return false.
+  template <class F> void read_values(F f) const {
+    read_values([&f](uint64_t, const Meas &val) { return f(val); }, nullptr);
+  }
 
-    while (1) {
-      if (clbk->is_canceled()) {
+  /**
+  call 'f(block_offset, value)' for each value from blocks with 'offsets'.
+  all blocks are readed if 'offsets' is nullptr. stop reading if 'f' return false.
+  */
+  template <class F>
+  void read_values(F f, const std::vector<uint64_t> *offsets) const {
+    auto file = open_to_read();
+    WALFileHeader hdr;
+    if (!read_file_header(file, &hdr)) {
+      std::fseek(file, 0, SEEK_SET);
+      MeasArray values(LEGACY_READ_BATCH);
+      bool stop = false;
+      uint64_t offset = 0;
+      while (!stop) {
+        auto readed = std::fread(values.data(), sizeof(Meas), values.size(), file);
+        for (size_t i = 0; i < readed; ++i) {
+          if (offset >= _read_end || !f(offset, values[i])) {
+            stop = true;
+            break;
+          }
+          offset += sizeof(Meas);
+        }
+        if (readed != values.size()) {
+          break;
+        }
+      }
+      std::fclose(file);
+      return;
+    }
+
+    WALBlockHeader bhdr;
+    std::vector<uint8_t> buffer;
+    size_t next_offset = 0;
+    while (true) {
+      uint64_t offset = 0;
+      if (offsets != nullptr) {
+        if (next_offset == offsets->size()) {
+          break;
+        }
+        offset = (*offsets)[next_offset++];
+        std::fseek(file, long(offset), SEEK_SET);
+      } else {
+        offset = uint64_t(std::ftell(file));
+      }
+      if (offset >= _read_end || !read_block(file, hdr, &bhdr, &buffer)) {
         break;
       }
-      Meas val = Meas::empty();
-      if (fread(&val, sizeof(Meas), size_t(1), _file) == 0) {
+      bool stop = false;
+      if (hdr.version == WAL_FORMAT_RAW) {
+        auto values = reinterpret_cast<const Meas *>(buffer.data());
+        for (size_t i = 0; i < bhdr.count; ++i) {
+          if (!f(offset, values[i])) {
+            stop = true;
+            break;
+          }
+        }
+      } else {
+        WALBlockReader reader(buffer.data(), buffer.size());
+        Meas value;
+        for (size_t i = 0; i < bhdr.count && reader.next(&value); ++i) {
+          if (!f(offset, value)) {
+            stop = true;
+            break;
+          }
+        }
+      }
+      if (stop) {
         break;
       }
-      if (val.inQuery(q.ids, q.flag, q.from, q.to)) {
-        clbk->call(val);
+    }
+    std::fclose(file);
+  }
+
+  /// read only blocks, which may contain values of 'ids' in [from, to].
+  template <class F> void read_query(const IdArray &ids, Time from, Time to, F f) {
+    auto s = summary();
+    if (s == nullptr) {
+      read_values(f);
+      return;
+    }
+    if (!s->contains(ids, from, to)) {
+      return;
+    }
+    auto offsets = s->blocks(ids, from, to);
+    read_values([&f](uint64_t, const Meas &val) { return f(val); }, &offsets);
+  }
+
+  WALFileSummary_ptr summary() {
+    if (_summary == nullptr && !_legacy) {
+      auto result = WALFileSummary::create();
+      if (utils::fs::file_exists(_filename)) {
+        auto raw = result.get();
+        read_values(
+            [raw](uint64_t offset, const Meas &val) {
+              raw->append(offset, val);
+              return true;
+            },
+            nullptr);
       }
+      _summary = result;
     }
-    std::fclose(_file);
-    _file = nullptr;
+    return _summary;
+  }
+
+  void foreach (const QueryInterval &q, IReaderClb * clbk) {
+    ReaderClb_Batch batch(clbk);
+    auto erased_values = erased(q.ids);
+    read_query(q.ids, q.from, q.to, [&q, clbk, &batch, &erased_values](const Meas &val) {
+      if (clbk->is_canceled()) {
+        return false;
+      }
+      if (val.inQuery(q.ids, q.flag, q.from, q.to) && !is_erased(erased_values, val)) {
+        batch.append(val);
+      }
+      return true;
+    });
   }
 
   Id2Meas readTimePoint(const QueryTimePoint &q) {
     dariadb::IdSet readed_ids;
     dariadb::Id2Meas sub_res;
+    dariadb::IdSet id_set(q.ids.begin(), q.ids.end());
+    auto erased_values = erased(q.ids);
 
-    open_to_read();
-
-    while (1) {
-      Meas val = Meas::empty();
-      if (fread(&val, sizeof(Meas), size_t(1), _file) == 0) {
-        break;
-      }
-      if (val.inQuery(q.ids, q.flag) && (val.time <= q.time_point)) {
+    read_query(q.ids, MIN_TIME, q.time_point,
+               [&q, &id_set, &readed_ids, &sub_res, &erased_values, this](const Meas &val) {
+      if (val.inQuery(id_set, q.flag) && (val.time <= q.time_point) &&
+          !is_erased(erased_values, val)) {
         replace_if_older(sub_res, val);
         readed_ids.insert(val.id);
       }
-    }
-    std::fclose(_file);
-    _file = nullptr;
+      return true;
+    });
 
     if (!q.ids.empty() && readed_ids.size() != q.ids.size()) {
       for (auto id : q.ids) {
@@ -174,7 +515,7 @@ public:
       s.emplace(std::make_pair(m.id, m));
     } else {
       if (fres->second.time < m.time) {
-        s.emplace(std::make_pair(m.id, m));
+        fres->second = m;
       }
     }
   }
@@ -182,20 +523,16 @@ public:
   Id2Meas currentValue(const IdArray &ids, const Flag &flag) {
     dariadb::Id2Meas sub_res;
     dariadb::IdSet readed_ids;
+    auto erased_values = erased(ids);
 
-    open_to_read();
-    while (1) {
-      Meas val = Meas::empty();
-      if (fread(&val, sizeof(Meas), size_t(1), _file) == 0) {
-        break;
-      }
-      if (val.inFlag(flag) && val.inIds(ids)) {
+    read_query(ids, MIN_TIME, MAX_TIME,
+               [&ids, flag, &readed_ids, &sub_res, &erased_values, this](const Meas &val) {
+      if (val.inFlag(flag) && val.inIds(ids) && !is_erased(erased_values, val)) {
         replace_if_older(sub_res, val);
         readed_ids.emplace(val.id);
       }
-    }
-    std::fclose(_file);
-    _file = nullptr;
+      return true;
+    });
 
     if (!ids.empty() && readed_ids.size() != ids.size()) {
       for (auto id : ids) {
@@ -212,81 +549,82 @@ public:
   }
 
   dariadb::Time minTime() {
-    open_to_read();
-
+    auto s = summary();
+    if (s != nullptr) {
+      return s->minTime();
+    }
     dariadb::Time result = dariadb::MAX_TIME;
-
-    while (1) {
-      Meas val = Meas::empty();
-      if (fread(&val, sizeof(Meas), size_t(1), _file) == 0) {
-        break;
-      }
+    read_values([&result](const Meas &val) {
       result = std::min(val.time, result);
-    }
-    std::fclose(_file);
-    _file = nullptr;
+      return true;
+    });
     return result;
   }
 
   dariadb::Time maxTime() {
-    open_to_read();
-
+    auto s = summary();
+    if (s != nullptr) {
+      return s->maxTime();
+    }
     dariadb::Time result = dariadb::MIN_TIME;
-
-    while (1) {
-      Meas val = Meas::empty();
-      if (fread(&val, sizeof(Meas), size_t(1), _file) == 0) {
-        break;
-      }
+    read_values([&result](const Meas &val) {
       result = std::max(val.time, result);
-    }
-    std::fclose(_file);
-    _file = nullptr;
+      return true;
+    });
     return result;
   }
 
   bool minMaxTime(dariadb::Id id, dariadb::Time *minResult, dariadb::Time *maxResult) {
-    open_to_read();
-
     *minResult = dariadb::MAX_TIME;
     *maxResult = dariadb::MIN_TIME;
+    auto s = summary();
+    if (s != nullptr) {
+      return s->minMaxTime(id, minResult, maxResult);
+    }
     bool result = false;
-    while (1) {
-      Meas val = Meas::empty();
-      if (fread(&val, sizeof(Meas), size_t(1), _file) == 0) {
-        break;
-      }
+    read_values([id, &result, minResult, maxResult](const Meas &val) {
       if (val.id == id) {
         result = true;
         *minResult = std::min(*minResult, val.time);
         *maxResult = std::max(*maxResult, val.time);
       }
-    }
-    std::fclose(_file);
-    _file = nullptr;
+      return true;
+    });
     return result;
   }
 
   void flush() {}
 
+  void sync() {
+    if (_file == nullptr) {
+      return;
+    }
+    std::fflush(_file);
+#ifdef MSVC
+    _commit(_fileno(_file));
+#else
+    fdatasync(fileno(_file));
+#endif
+  }
+
   std::string filename() const { return _filename; }
 
-  std::shared_ptr<MeasArray> readAll() {
-    open_to_read();
+  uint64_t end_offset() const { return _write_pos; }
+  void read_until(uint64_t end_offset) { _read_end = end_offset; }
 
-    auto ma = std::make_shared<MeasArray>(_settings->wal_file_size.value());
+  /// values without erased ones: they are moved to pages, where tombstones
+  /// do not cover them.
+  std::shared_ptr<MeasArray> readAll() {
+    auto ma = std::make_shared<MeasArray>();
+    ma->reserve(_writed);
     auto raw = ma.get();
-    size_t pos = 0;
-    while (1) {
-      Meas val = Meas::empty();
-      if (fread(&val, sizeof(Meas), size_t(1), _file) == 0) {
-        break;
+    auto erased_values = erased(IdArray{});
+    read_values([raw, &erased_values](const Meas &val) {
+      if (!is_erased(erased_values, val)) {
+        raw->push_back(val);
       }
-      (*raw)[pos] = val;
-      pos++;
-    }
-    std::fclose(_file);
-    _file = nullptr;
+      return true;
+    });
     return ma;
   }
 
@@ -308,14 +646,8 @@ public:
   }
 
   Id2MinMax loadMinMax() {
-    open_to_read();
     Id2MinMax result;
-    while (1) {
-      Meas val = Meas::empty();
-      if (fread(&val, sizeof(Meas), size_t(1), _file) == 0) {
-        break;
-      }
-
+    read_values([&result](const Meas &val) {
       auto fres = result.find(val.id);
       if (fres == result.end()) {
         result[val.id].min = val;
@@ -324,35 +656,49 @@ public:
         fres->second.updateMax(val);
         fres->second.updateMin(val);
       }
-    }
-    std::fclose(_file);
-    _file = nullptr;
+      return true;
+    });
     return result;
   }
 
 protected:
   std::string _filename;
+  std::string _recycled; // free segment, which will be used as this file.
   bool _is_readonly;
+  bool _legacy; // file without header.
+  uint64_t _seq;
+  uint32_t _version;
+  uint64_t _write_pos;
+  uint64_t _read_end; // blocks from this offset are not readed.
   size_t _writed;
   EngineEnvironment_ptr _env;
   Settings *_settings;
+  Tombstones *_tombstones;
   FILE *_file;
+  std::vector<uint8_t> _write_buffer;
+  WALBlockWriter _encoder;
+  WALFileSummary_ptr _summary; // nullptr for files without header.
 };
 
-WALFile_Ptr WALFile::create(const EngineEnvironment_ptr env) {
-	return WALFile_Ptr{ new WALFile(env) };
+WALFile_Ptr WALFile::create(const EngineEnvironment_ptr env, uint64_t seq,
+                            const std::string &recycled_file) {
+  return WALFile_Ptr{new WALFile(env, seq, recycled_file)};
 }
 
-WALFile_Ptr WALFile::open(const EngineEnvironment_ptr env, const std::string &fname, bool readonly) {
-	return WALFile_Ptr{ new WALFile(env, fname, readonly) };
+WALFile_Ptr WALFile::open(const EngineEnvironment_ptr env, const std::string &fname,
+                          bool readonly, const WALFileSummary_ptr &summary) {
+  return WALFile_Ptr{new WALFile(env, fname, readonly, summary)};
 }
 
 WALFile::~WALFile() {}
 
-WALFile::WALFile(const EngineEnvironment_ptr env) : _Impl(new WALFile::Private(env)) {}
+WALFile::WALFile(const EngineEnvironment_ptr env, uint64_t seq,
+                 const std::string &recycled_file)
+    : _Impl(new WALFile::Private(env, seq, recycled_file)) {}
 
-WALFile::WALFile(const EngineEnvironment_ptr env, const std::string &fname, bool readonly)
-    : _Impl(new WALFile::Private(env, fname, readonly)) {}
+WALFile::WALFile(const EngineEnvironment_ptr env, const std::string &fname, bool readonly,
+                 const WALFileSummary_ptr &summary)
+    : _Impl(new WALFile::Private(env, fname, readonly, summary)) {}
 
 dariadb::Time WALFile::minTime() {
   return _Impl->minTime();
@@ -370,6 +716,10 @@ void WALFile::flush() { // write all to storage;
   _Impl->flush();
 }
 
+void WALFile::sync() {
+  _Impl->sync();
+}
+
 Status WALFile::append(const Meas &value) {
   return _Impl->append(value);
 }
@@ -398,13 +748,28 @@ std::string WALFile::filename() const {
   return _Impl->filename();
 }
 
+uint64_t WALFile::end_offset() const {
+  return _Impl->end_offset();
+}
+
+void WALFile::read_until(uint64_t end_offset) {
+  _Impl->read_until(end_offset);
+}
+
 std::shared_ptr<MeasArray> WALFile::readAll() {
   return _Impl->readAll();
 }
 
 size_t WALFile::writed(std::string fname) {
-  std::ifstream in(fname, std::ifstream::ate | std::ifstream::binary);
-  return in.tellg() / sizeof(Meas);
+  return read_info(fname, true).count;
+}
+
+uint64_t WALFile::sequence(const std::string &fname) {
+  return read_info(fname, false).seq;
+}
+
+WALFileSummary_ptr WALFile::summary() {
+  return _Impl->summary();
 }
 
 Id2MinMax WALFile::loadMinMax() {
@@ -4,11 +4,13 @@
 #include <libdariadb/meas.h>
 #include <libdariadb/st_exports.h>
 #include <libdariadb/storage/engine_environment.h>
+#include <libdariadb/storage/wal/wal_summary.h>
 #include <memory>
 
 namespace dariadb {
 namespace storage {
 const std::string WAL_FILE_EXT = ".wal"; // append-only-file
+const std::string WAL_FREE_EXT = ".wal_free"; // free segment, ready to reuse.
 
 class WALFile;
 typedef std::shared_ptr<WALFile> WALFile_Ptr;
@@ -17,9 +19,17 @@ class WALFile : public IMeasStorage {
 public:
   EXPORT virtual ~WALFile();
 
-  EXPORT static WALFile_Ptr create(const EngineEnvironment_ptr env);
+  /**
+  seq - sequence number of segment.
+  recycled_file - free segment, which will be renamed and reused on first write.
+  */
+  EXPORT static WALFile_Ptr create(const EngineEnvironment_ptr env, uint64_t seq = 1,
+                                   const std::string &recycled_file = std::string());
+  /// summary - index of file, if nullptr it will be built on first query.
+  /// blocks of read-only file with summary are not readed on open.
   EXPORT static WALFile_Ptr open(const EngineEnvironment_ptr env,
-                                 const std::string &fname, bool readonly = false);
+                                 const std::string &fname, bool readonly = false,
+                                 const WALFileSummary_ptr &summary = nullptr);
   EXPORT Status append(const Meas &value) override;
   EXPORT Status append(const MeasArray::const_iterator &begin,
                        const MeasArray::const_iterator &end) override;
@@ -33,17 +43,30 @@ public:
   EXPORT bool minMaxTime(dariadb::Id id, dariadb::Time *minResult,
                          dariadb::Time *maxResult) override;
   EXPORT void flush() override;
+  /// write appended values to disk (fdatasync).
+  EXPORT void sync();
 
   EXPORT std::string filename() const;
+  /// offset after the last written block. unknown (max value) for read-only file,
+  /// opened with summary.
+  EXPORT uint64_t end_offset() const;
+  /// blocks from 'end_offset' are not readed: they are written after reader started.
+  EXPORT void read_until(uint64_t end_offset);
 
   EXPORT std::shared_ptr<MeasArray> readAll();
+  /// count of values. all blocks of file are readed.
   EXPORT static size_t writed(std::string fname);
+  /// sequence number from file header, blocks are not readed. 0 for files without header.
+  EXPORT static uint64_t sequence(const std::string &fname);
   EXPORT Id2MinMax loadMinMax() override;
+  /// per-id index of file. nullptr for files without header.
+  EXPORT WALFileSummary_ptr summary();
 
 protected:
-  EXPORT WALFile(const EngineEnvironment_ptr env);
+  EXPORT WALFile(const EngineEnvironment_ptr env, uint64_t seq,
+                 const std::string &recycled_file);
   EXPORT WALFile(const EngineEnvironment_ptr env, const std::string &fname,
-                 bool readonly);
+                 bool readonly, const WALFileSummary_ptr &summary);
 
 protected:
   class Private;
@@ -28,6 +28,11 @@ public:
   }
   EXPORT TaskResult_Ptr post(const ThreadKind kind, const AsyncTaskWrap_Ptr &task);
 
+  size_t threads_count(const THREAD_KINDS kind) const {
+    auto fres = _pools.find((ThreadKind)kind);
+    return fres == _pools.end() ? size_t(0) : fres->second->threads_count();
+  }
+
   size_t active_works() {
     size_t res = 0;
     for (auto &kv : _pools) {
@@ -2,6 +2,8 @@
 #include <libdariadb/utils/exception.h>
 #include <libdariadb/utils/fs.h>
 #include <boost/filesystem.hpp>
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <iterator>
 
@@ -70,6 +72,14 @@ bool rm(const std::string &rm_path) {
   }
 }
 
+void rename(const std::string &from, const std::string &to) {
+  try {
+    boost::filesystem::rename(from, to);
+  } catch (boost::filesystem::filesystem_error &ex) {
+    THROW_EXCEPTION("utils::rename exception: ", ex.what());
+  }
+}
+
 std::string filename(const std::string &fname) { // without ex
   boost::filesystem::path p(fname);
   return p.stem().string();
@@ -81,10 +91,21 @@ std::string extract_filename(const std::string &fname) {
 }
 
 std::string random_file_name(const std::string &ext) {
+  // names are unique inside process, even if called in one microsecond.
+  static std::atomic<int64_t> last_name{0};
   auto now = boost::posix_time::microsec_clock::local_time();
   auto duration = now - boost::posix_time::from_time_t(0);
+  int64_t name = duration.total_microseconds();
+  auto prev = last_name.load();
+  while (true) {
+    auto next = std::max(name, prev + 1);
+    if (last_name.compare_exchange_weak(prev, next)) {
+      name = next;
+      break;
+    }
+  }
   std::stringstream ss;
-  ss << duration.total_microseconds() << ext;
+  ss << name << ext;
   return ss.str();
 }
 
@@ -113,6 +134,10 @@ bool path_exists(const std::string &path) {
   return boost::filesystem::exists(path);
 }
 
+bool is_directory(const std::string &path) {
+  return boost::filesystem::is_directory(path);
+}
+
 void mkdir(const std::string &path) {
   if (!boost::filesystem::exists(path)) {
     boost::filesystem::create_directory(path);
@@ -13,6 +13,7 @@ EXPORT std::list<std::string> ls(const std::string &path);
 EXPORT std::list<std::string> ls(const std::string &path, const std::string &ext);
 
 EXPORT bool rm(const std::string &rm_path);
+EXPORT void rename(const std::string &from, const std::string &to);
 
 EXPORT std::string filename(const std::string &fname); // without ex
 EXPORT std::string extract_filename(const std::string &fname);
@@ -23,6 +24,7 @@ EXPORT std::string append_path(const std::string &p1, const std::string &p2);
 
 EXPORT bool path_exists(const std::string &path);
 EXPORT bool file_exists(const std::string &fname);
+EXPORT bool is_directory(const std::string &path);
 
 EXPORT void mkdir(const std::string &path);
 
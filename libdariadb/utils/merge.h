@@ -0,0 +1,52 @@
+#pragma once
+
+#include <libdariadb/flags.h>
+#include <libdariadb/meas.h>
+#include <algorithm>
+#include <vector>
+
+namespace dariadb {
+namespace utils {
+
+/// k-way merge of runs of one id by time. unordered run is sorted before merge.
+/// value of equal time is written once: from the first run, where it exists.
+/// values with _NO_DATA flag are skipped. result - end of written values.
+template <class OutputIt> OutputIt merge_runs(std::vector<MeasArray *> &runs, OutputIt out) {
+  auto by_time = [](const Meas &l, const Meas &r) { return l.time < r.time; };
+  std::vector<std::pair<MeasArray::const_iterator, MeasArray::const_iterator>> heads;
+  heads.reserve(runs.size());
+  for (auto r : runs) {
+    if (!std::is_sorted(r->begin(), r->end(), by_time)) {
+      std::stable_sort(r->begin(), r->end(), by_time);
+    }
+    if (!r->empty()) {
+      heads.emplace_back(r->cbegin(), r->cend());
+    }
+  }
+
+  bool is_first = true;
+  Time last_time = MIN_TIME;
+  while (!heads.empty()) {
+    // runs are few (one per storage level), so linear search of min is enough.
+    size_t min_pos = 0;
+    for (size_t i = 1; i < heads.size(); ++i) {
+      if (heads[i].first->time < heads[min_pos].first->time) {
+        min_pos = i;
+      }
+    }
+    auto &head = heads[min_pos];
+    auto &m = *head.first;
+    if (m.flag != Flags::_NO_DATA && (is_first || m.time != last_time)) {
+      *out = m;
+      ++out;
+      is_first = false;
+      last_time = m.time;
+    }
+    if (++head.first == head.second) {
+      heads.erase(heads.begin() + min_pos);
+    }
+  }
+  return out;
+}
+}
+}
@@ -0,0 +1,128 @@
+#include <libdariadb/utils/async/thread_manager.h>
+#include <libdariadb/utils/radix_sort.h>
+#include <algorithm>
+#include <list>
+
+using namespace dariadb;
+using namespace dariadb::utils;
+using namespace dariadb::utils::async;
+
+namespace {
+const size_t TIME_BITS = sizeof(Time) * 8;
+const size_t KEY_BITS = TIME_BITS + sizeof(Id) * 8;
+/// smaller parts are not worth a pool task.
+const size_t MIN_PART_SIZE = 16384;
+/// on big arrays 16-bit digits halve count of passes.
+const size_t WIDE_DIGIT_MIN_COUNT = size_t(1) << 16;
+
+/// digit of (id, time) key, from least significant.
+inline size_t key_digit(const Meas &m, size_t shift, size_t mask) {
+  if (shift < TIME_BITS) {
+    return size_t(m.time >> shift) & mask;
+  }
+  return size_t(m.id >> (shift - TIME_BITS)) & mask;
+}
+
+/// call f(part_number) for each part. parts are handled by COMMON pool.
+template <class F> void for_each_part(size_t parts, F f) {
+  if (parts == 1) {
+    f(size_t(0));
+    return;
+  }
+  std::list<TaskResult_Ptr> results;
+  for (size_t p = 0; p < parts; ++p) {
+    AsyncTask at = [p, &f](const ThreadInfo &ti) {
+      TKIND_CHECK(THREAD_KINDS::COMMON, ti.kind);
+      f(p);
+      return false;
+    };
+    results.push_back(ThreadManager::instance()->post(THREAD_KINDS::COMMON, AT(at)));
+  }
+  for (auto &r : results) {
+    r->wait();
+  }
+}
+}
+
+bool dariadb::utils::is_sorted_by_id(const MeasArray &values) {
+  return std::is_sorted(values.begin(), values.end(),
+                        [](const Meas &l, const Meas &r) {
+                          return l.id < r.id || (l.id == r.id && l.time < r.time);
+                        });
+}
+
+void dariadb::utils::radix_sort(MeasArray &values) {
+  auto count = values.size();
+  if (count < 2 || is_sorted_by_id(values)) {
+    return;
+  }
+
+  size_t parts = 1;
+  auto tm = ThreadManager::instance();
+  if (tm != nullptr && count >= 2 * MIN_PART_SIZE) {
+    parts = std::max(size_t(1), std::min(tm->threads_count(THREAD_KINDS::COMMON),
+                                         count / MIN_PART_SIZE));
+  }
+  auto part_size = (count + parts - 1) / parts;
+
+  const size_t digit_bits = count >= WIDE_DIGIT_MIN_COUNT ? 16 : 8;
+  const size_t buckets = size_t(1) << digit_bits;
+  const size_t mask = buckets - 1;
+
+  // passes over digits, equal for all values, are skipped.
+  Meas diff;
+  diff.id = 0;
+  diff.time = 0;
+  auto &first = values.front();
+  for (auto &m : values) {
+    diff.id |= m.id ^ first.id;
+    diff.time |= m.time ^ first.time;
+  }
+  // values are appended mostly in time order: stable sort by id is enough.
+  size_t first_shift = 0;
+  if (std::is_sorted(values.begin(), values.end(), meas_time_compare_less())) {
+    first_shift = TIME_BITS;
+  }
+
+  MeasArray buffer(count);
+  Meas *src = values.data();
+  Meas *dst = buffer.data();
+  std::vector<std::vector<size_t>> histograms(parts, std::vector<size_t>(buckets));
+
+  for (size_t shift = first_shift; shift < KEY_BITS; shift += digit_bits) {
+    if (key_digit(diff, shift, mask) == 0) {
+      continue;
+    }
+    for_each_part(parts, [&](size_t p) {
+      auto &h = histograms[p];
+      std::fill(h.begin(), h.end(), size_t(0));
+      auto end = std::min(count, (p + 1) * part_size);
+      for (auto i = p * part_size; i < end; ++i) {
+        h[key_digit(src[i], shift, mask)]++;
+      }
+    });
+
+    // offsets: all parts for smaller buckets, then previous parts for this bucket.
+    size_t offset = 0;
+    for (size_t bucket = 0; bucket < buckets; ++bucket) {
+      for (auto &h : histograms) {
+        auto c = h[bucket];
+        h[bucket] = offset;
+        offset += c;
+      }
+    }
+
+    for_each_part(parts, [&](size_t p) {
+      auto &h = histograms[p];
+      auto end = std::min(count, (p + 1) * part_size);
+      for (auto i = p * part_size; i < end; ++i) {
+        dst[h[key_digit(src[i], shift, mask)]++] = src[i];
+      }
+    });
+    std::swap(src, dst);
+  }
+
+  if (src != values.data()) {
+    values.swap(buffer);
+  }
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <libdariadb/meas.h>
+#include <libdariadb/st_exports.h>
+
+namespace dariadb {
+namespace utils {
+/// stable LSD radix sort by (id, time). passes are split over COMMON pool.
+EXPORT void radix_sort(MeasArray &values);
+/// true if 'values' are sorted by (id, time).
+EXPORT bool is_sorted_by_id(const MeasArray &values);
+}
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <libdariadb/meas.h>
+#include <libdariadb/utils/utils.h>
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace dariadb {
+namespace utils {
+
+/// Id -> T map, split into power-of-two shards of open addressing tables.
+/// lookups are lock-free, a new id takes lock of one shard.
+/// values are owned by map and not removed until clear(), so T* stays valid.
+template <class T> class ShardedIdMap : public NonCopy {
+public:
+  static const size_t SHARDS = 64;
+  static const size_t SHARD_BITS = 6; // log2(SHARDS)
+  static const size_t MIN_SHARD_CAPACITY = 16;
+
+  ShardedIdMap(size_t reserve = 0) : _shards(new Shard[SHARDS]), _reserve(reserve) {
+    static_assert((SHARDS & (SHARDS - 1)) == 0, "SHARDS must be power of two");
+    static_assert((size_t(1) << SHARD_BITS) == SHARDS, "SHARD_BITS != log2(SHARDS)");
+    clear();
+  }
+
+  /// nullptr if not exists. lock-free.
+  T *find(Id id) const {
+    auto h = hash(id);
+    return find_in(shard(h).table.load(std::memory_order_acquire), id, h);
+  }
+
+  /// return existing value or add result of 'make'.
+  T *insert(Id id, const std::function<std::shared_ptr<T>()> &make) {
+    auto h = hash(id);
+    auto &s = shard(h);
+    std::lock_guard<std::mutex> lg(s.locker);
+    auto table = s.table.load(std::memory_order_relaxed);
+    auto exists = find_in(table, id, h);
+    if (exists != nullptr) {
+      return exists;
+    }
+
+    // load factor <= 0.5
+    if ((s.count + 1) * 2 > table->mask + 1) {
+      std::unique_ptr<Table> bigger{new Table((table->mask + 1) * 2)};
+      for (size_t i = 0; i <= table->mask; ++i) {
+        auto value = table->slots[i].value.load(std::memory_order_relaxed);
+        if (value != nullptr) {
+          auto slot_id = table->slots[i].id;
+          insert_to(bigger.get(), slot_id, hash(slot_id), value);
+        }
+      }
+      table = bigger.get();
+      s.tables.push_back(std::move(bigger));
+      s.table.store(table, std::memory_order_release);
+    }
+
+    auto value = make();
+    s.values.push_back(value);
+    insert_to(table, id, h, value.get());
+    s.count++;
+    return value.get();
+  }
+
+  /// call f for each value. lock-free, values added concurrently may be skipped.
+  void foreach (const std::function<void(Id, T *)> &f) const {
+    for (size_t i = 0; i < SHARDS; ++i) {
+      auto table = _shards[i].table.load(std::memory_order_acquire);
+      for (size_t pos = 0; pos <= table->mask; ++pos) {
+        auto value = table->slots[pos].value.load(std::memory_order_acquire);
+        if (value != nullptr) {
+          f(table->slots[pos].id, value);
+        }
+      }
+    }
+  }
+
+  size_t size() const {
+    size_t result = 0;
+    for (size_t i = 0; i < SHARDS; ++i) {
+      std::lock_guard<std::mutex> lg(_shards[i].locker);
+      result += _shards[i].count;
+    }
+    return result;
+  }
+
+  /// not thread-safe.
+  void clear() {
+    size_t capacity = MIN_SHARD_CAPACITY;
+    while (capacity < 2 * _reserve / SHARDS) {
+      capacity <<= 1;
+    }
+    for (size_t i = 0; i < SHARDS; ++i) {
+      auto &s = _shards[i];
+      s.tables.clear();
+      s.tables.emplace_back(new Table(capacity));
+      s.table.store(s.tables.back().get(), std::memory_order_release);
+      s.count = 0;
+      s.values.clear();
+    }
+  }
+
+protected:
+  struct Slot {
+    Id id;
+    std::atomic<T *> value;
+  };
+
+  struct Table {
+    Table(size_t capacity) : mask(capacity - 1), slots(new Slot[capacity]) {
+      for (size_t i = 0; i < capacity; ++i) {
+        slots[i].id = 0;
+        slots[i].value.store(nullptr, std::memory_order_relaxed);
+      }
+    }
+    size_t mask;
+    std::unique_ptr<Slot[]> slots;
+  };
+
+  struct alignas(64) Shard {
+    std::atomic<Table *> table;
+    mutable std::mutex locker;
+    size_t count;
+    std::vector<std::shared_ptr<T>> values;
+    /// replaced tables. kept alive for readers.
+    std::list<std::unique_ptr<Table>> tables;
+  };
+
+  static uint64_t hash(Id id) {
+    auto h = uint64_t(id) * uint64_t(0x9E3779B97F4A7C15);
+    return h ^ (h >> 29);
+  }
+
+  Shard &shard(uint64_t h) const { return _shards[h & (SHARDS - 1)]; }
+
+  static T *find_in(const Table *t, Id id, uint64_t h) {
+    for (auto pos = (h >> SHARD_BITS) & t->mask;; pos = (pos + 1) & t->mask) {
+      auto value = t->slots[pos].value.load(std::memory_order_acquire);
+      if (value == nullptr) {
+        return nullptr;
+      }
+      if (t->slots[pos].id == id) {
+        return value;
+      }
+    }
+  }
+
+  static void insert_to(Table *t, Id id, uint64_t h, T *value) {
+    for (auto pos = (h >> SHARD_BITS) & t->mask;; pos = (pos + 1) & t->mask) {
+      auto &slot = t->slots[pos];
+      if (slot.value.load(std::memory_order_relaxed) == nullptr) {
+        slot.id = id;
+        slot.value.store(value, std::memory_order_release);
+        return;
+      }
+    }
+  }
+
+  std::unique_ptr<Shard[]> _shards;
+  size_t _reserve;
+};
+}
+}
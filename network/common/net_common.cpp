@@ -34,6 +34,9 @@ std::ostream &operator<<(std::ostream &stream, const ERRORS &state) {
   case dariadb::net::ERRORS::APPEND_ERROR:
     stream << "ERRORS::APPEND_ERROR";
     break;
+  case dariadb::net::ERRORS::APPEND_BUSY:
+    stream << "ERRORS::APPEND_BUSY";
+    break;
   }
   return stream;
 }
@@ -6,6 +6,8 @@
 #include <common/net_common.h>
 
 #include <boost/asio.hpp>
+#include <algorithm>
+#include <chrono>
 #include <functional>
 #include <map>
 #include <memory>
@@ -21,6 +23,12 @@ using namespace dariadb::net::client;
 
 typedef boost::shared_ptr<ip::tcp::socket> socket_ptr;
 
+namespace {
+/// delay before resend of pack, rejected by overloaded server. doubled on each retry.
+const size_t APPEND_BACKOFF_MIN = 10;   // ms
+const size_t APPEND_BACKOFF_MAX = 1000; // ms
+}
+
 class Client::Private {
 public:
   Private(const Client::Param &p) : _params(p) {
@@ -161,8 +169,8 @@ public:
       if (this->state() == CLIENT_STATE::WORK) {
         auto subres = this->_query_results[qh_e->id];
         subres->is_closed = true;
-        subres->is_error = true;
         subres->errc = err;
+        subres->is_error = true;
         subres->locker.unlock();
         _query_results.erase(qh_e->id);
       }
@@ -225,44 +233,81 @@ public:
   size_t pings_answers() const { return _pings_answers.load(); }
   CLIENT_STATE state() const { return _state; }
 
-  void append(const MeasArray &ma) {
-    this->_locker.lock();
-    logger_info("client: send ", ma.size());
-    size_t writed = 0;
-    std::list<ReadResult_ptr> results;
+  /// send values from 'offset' in one message. must be called under _locker.
+  ReadResult_ptr send_append_pack(const MeasArray &ma, size_t offset, size_t *count) {
+    auto cur_id = _query_num;
+    _query_num += 1;
 
-    while (writed != ma.size()) {
-      auto cur_id = _query_num;
-      _query_num += 1;
+    auto qres = std::make_shared<ReadResult>();
+    qres->id = cur_id;
+    qres->kind = DATA_KINDS::APPEND;
+    this->_query_results[qres->id] = qres;
+
+    auto nd = this->_pool.construct(DATA_KINDS::APPEND);
+    nd->size = sizeof(QueryAppend_header);
 
-      auto qres = std::make_shared<ReadResult>();
-      qres->id = cur_id;
-      qres->kind = DATA_KINDS::APPEND;
-      results.push_back(qres);
-      this->_query_results[qres->id] = qres;
+    auto hdr = reinterpret_cast<QueryAppend_header *>(&nd->data);
+    hdr->id = cur_id;
+    size_t space_left = 0;
+    QueryAppend_header::make_query(hdr, ma.data(), ma.size(), offset, &space_left);
 
-      auto nd = this->_pool.construct(DATA_KINDS::APPEND);
-      nd->size = sizeof(QueryAppend_header);
+    logger_info("client: pack count: ", hdr->count);
 
-      auto hdr = reinterpret_cast<QueryAppend_header *>(&nd->data);
-      hdr->id = cur_id;
-      size_t space_left = 0;
-      QueryAppend_header::make_query(hdr, ma.data(), ma.size(), writed, &space_left);
+    nd->size = NetData::MAX_MESSAGE_SIZE - MARKER_SIZE - space_left;
+    *count = hdr->count;
 
-      logger_info("client: pack count: ", hdr->count);
+    _async_connection->send(nd);
+    return qres;
+  }
 
-      nd->size = NetData::MAX_MESSAGE_SIZE - MARKER_SIZE - space_left;
-      writed += hdr->count;
+  void append(const MeasArray &ma) {
+    struct Pack {
+      ReadResult_ptr result;
+      size_t offset;
+    };
+    std::list<Pack> packs;
 
-      _async_connection->send(nd);
+    this->_locker.lock();
+    logger_info("client: send ", ma.size());
+    size_t writed = 0;
+    while (writed != ma.size()) {
+      size_t count = 0;
+      auto r = send_append_pack(ma, writed, &count);
+      packs.push_back(Pack{r, writed});
+      writed += count;
     }
     this->_locker.unlock();
-    for (auto &r : results) {
-      while (!r->is_ok && !r->is_error) {
-        std::this_thread::yield();
+
+    auto backoff = APPEND_BACKOFF_MIN;
+    while (!packs.empty()) {
+      std::list<Pack> busy;
+      for (auto &p : packs) {
+        auto r = p.result;
+        while (!r->is_ok && !r->is_error) {
+          std::this_thread::yield();
+        }
+        this->_locker.lock();
+        this->_query_results.erase(r->id);
+        this->_locker.unlock();
+        if (r->is_error && r->errc == ERRORS::APPEND_BUSY) {
+          busy.push_back(p);
+        }
       }
+      packs.clear();
+      if (busy.empty()) {
+        break;
+      }
+      // server is overloaded: pack was not written, resend it later.
+      logger_info("client: server is busy. resend ", busy.size(), " packs after ", backoff,
+                  " ms.");
+      std::this_thread::sleep_for(std::chrono::milliseconds(backoff));
+      backoff = std::min(backoff * 2, APPEND_BACKOFF_MAX);
+
       this->_locker.lock();
-      this->_query_results.erase(r->id);
+      for (auto &p : busy) {
+        size_t count = 0;
+        packs.push_back(Pack{send_append_pack(ma, p.offset, &count), p.offset});
+      }
       this->_locker.unlock();
     }
   }
@@ -2,6 +2,7 @@
 #include <libdariadb/timeutil.h>
 #include <libdariadb/utils/exception.h>
 #include <libserver/ioclient.h>
+#include <algorithm>
 #include <cassert>
 
 using namespace std::placeholders;
@@ -54,6 +55,21 @@ void IOClient::ClientDataReader::call(const Meas &m) {
   _buffer[pos++] = m;
 }
 
+void IOClient::ClientDataReader::call_batch(const Meas *begin, size_t n) {
+  std::lock_guard<utils::async::Locker> lg(_locker);
+  while (n != 0) {
+    if (pos == BUFFER_LENGTH) {
+      send_buffer();
+      pos = 0;
+    }
+    auto count = std::min(n, BUFFER_LENGTH - pos);
+    std::copy(begin, begin + count, _buffer.begin() + pos);
+    pos += count;
+    begin += count;
+    n -= count;
+  }
+}
+
 void IOClient::ClientDataReader::is_end() {
   IReaderClb::is_end();
   send_buffer();
@@ -329,7 +345,7 @@ void IOClient::sendOk(QueryNumber query_num) {
 }
 
 void IOClient::sendError(QueryNumber query_num, const ERRORS &err) {
-  auto err_nd = env->nd_pool->construct(DATA_KINDS::OK);
+  auto err_nd = env->nd_pool->construct(DATA_KINDS::ERR);
   auto qh = reinterpret_cast<QueryError_header *>(err_nd->data);
   qh->id = query_num;
   qh->error_code = (uint16_t)err;
@@ -341,11 +357,20 @@ void IOClient::append(const NetData_ptr &d) {
   auto hdr = reinterpret_cast<QueryAppend_header *>(d->data);
   auto count = hdr->count;
   logger_info("server: #", this->_async_connection->id(), " begin writing ", count);
+  if (env->storage->overloaded()) { // dont block network thread, client will resend.
+    this->env->srv->write_end();
+    logger_info("server: #", this->_async_connection->id(), " storage is overloaded.");
+    sendError(hdr->id, ERRORS::APPEND_BUSY);
+    return;
+  }
   MeasArray ma = hdr->read_measarray();
 
   auto ar = env->storage->append(ma.begin(), ma.end());
   this->env->srv->write_end();
-  if (ar.ignored != size_t(0)) {
+  if (ar.writed == 0 && ar.error != APPEND_ERROR::OK) { // nothing written, can be resent.
+    logger_info("server: write error - ", ar.error_message);
+    sendError(hdr->id, ERRORS::APPEND_BUSY);
+  } else if (ar.ignored != size_t(0)) {
     logger_info("server: write error - ", ar.error_message);
     sendError(hdr->id, ERRORS::APPEND_ERROR);
   } else {
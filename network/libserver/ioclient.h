@@ -41,6 +41,7 @@ struct IOClient {
     ClientDataReader(IOClient *parent, QueryNumber query_num);
     ~ClientDataReader();
     void call(const Meas &m) override;
+    void call_batch(const Meas *begin, size_t n) override;
     void is_end() override;
     void send_buffer();
   };
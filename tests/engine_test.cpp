@@ -6,6 +6,7 @@
 #include <libdariadb/engine.h>
 #include <libdariadb/storage/bloom_filter.h>
 #include <libdariadb/storage/bystep/step_kind.h>
+#include <libdariadb/storage/last_value_table.h>
 #include <libdariadb/storage/manifest.h>
 #include <libdariadb/storage/pages/page_manager.h>
 #include <libdariadb/timeutil.h>
@@ -13,6 +14,7 @@
 #include <libdariadb/utils/logger.h>
 #include <algorithm>
 #include <iostream>
+#include <thread>
 
 class BenchCallback : public dariadb::storage::IReaderClb {
 public:
@@ -72,6 +74,87 @@ BOOST_AUTO_TEST_CASE(inFilter) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(LastValueTableTest) {
+  const size_t writers = 4;
+  const size_t ids_per_writer = 100;
+  const dariadb::Time max_time = 50;
+
+  dariadb::storage::LastValueTable table;
+  std::vector<std::thread> threads;
+  for (size_t w = 0; w < writers; ++w) {
+    threads.emplace_back([&table, w]() {
+      auto m = dariadb::Meas::empty();
+      // newer and older values of each id, in turn.
+      for (dariadb::Time t = 0; t < max_time; ++t) {
+        for (size_t i = 0; i < ids_per_writer; ++i) {
+          m.id = dariadb::Id(w * ids_per_writer + i);
+          m.time = t % 2 == 0 ? t : t - 1;
+          m.value = dariadb::Value(m.time);
+          m.flag = dariadb::Flag(m.time);
+          table.updateMax(m);
+        }
+      }
+    });
+  }
+  // reader sees consistent values only.
+  for (size_t i = 0; i < 1000; ++i) {
+    table.foreach([](const dariadb::Meas &m) {
+      BOOST_CHECK_EQUAL(m.flag, dariadb::Flag(m.time));
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  BOOST_CHECK_EQUAL(table.size(), writers * ids_per_writer);
+  dariadb::Meas m;
+  for (size_t i = 0; i < writers * ids_per_writer; ++i) {
+    BOOST_CHECK(table.find(dariadb::Id(i), &m));
+    BOOST_CHECK_EQUAL(m.id, dariadb::Id(i));
+    BOOST_CHECK_EQUAL(m.time, max_time - 2);
+    BOOST_CHECK_EQUAL(m.value, dariadb::Value(max_time - 2));
+  }
+  BOOST_CHECK(!table.find(dariadb::Id(writers * ids_per_writer), &m));
+
+  m = dariadb::Meas::empty(1);
+  table.set(m);
+  BOOST_CHECK(table.find(1, &m));
+  BOOST_CHECK_EQUAL(m.time, dariadb::Time(0));
+
+  table.erase(2);
+  BOOST_CHECK(!table.find(2, &m));
+  size_t count = 0;
+  table.foreach([&count](const dariadb::Meas &) { count++; });
+  BOOST_CHECK_EQUAL(count, writers * ids_per_writer - 1);
+}
+
+BOOST_AUTO_TEST_CASE(LevelCatalogTest) {
+  using dariadb::storage::LEVEL;
+  dariadb::storage::LevelCatalog catalog;
+  BOOST_CHECK(!catalog.intersects(LEVEL::PAGES, 1, 0, 100));
+
+  catalog.extend(LEVEL::PAGES, 1, 10, 20);
+  catalog.extend(LEVEL::PAGES, 1, 5, 15);
+  auto m = dariadb::Meas::empty(1);
+  m.time = 30;
+  catalog.extend(LEVEL::WAL, m);
+
+  dariadb::Time minT, maxT;
+  BOOST_CHECK(catalog.minMaxTime(LEVEL::PAGES, 1, &minT, &maxT));
+  BOOST_CHECK_EQUAL(minT, dariadb::Time(5));
+  BOOST_CHECK_EQUAL(maxT, dariadb::Time(20));
+  BOOST_CHECK(!catalog.minMaxTime(LEVEL::MEMORY, 1, &minT, &maxT));
+
+  BOOST_CHECK(catalog.intersects(LEVEL::PAGES, 1, 20, 100));
+  BOOST_CHECK(!catalog.intersects(LEVEL::PAGES, 1, 21, 100));
+  BOOST_CHECK(!catalog.intersects(LEVEL::WAL, 1, 0, 29));
+  BOOST_CHECK(!catalog.intersects(LEVEL::WAL, 2, 0, 100));
+
+  // incomplete catalog prunes nothing.
+  catalog.setComplete(false);
+  BOOST_CHECK(catalog.intersects(LEVEL::WAL, 2, 0, 100));
+}
+
 BOOST_AUTO_TEST_CASE(Options_Instance) {
 
   const std::string storage_path = "testStorage";
@@ -198,6 +281,13 @@ BOOST_AUTO_TEST_CASE(Engine_compress_all_test) {
     auto wals_count = ms->description().wal_count;
     BOOST_CHECK_GE(pages_count, size_t(1));
     BOOST_CHECK_EQUAL(wals_count, size_t(0));
+
+    auto dropper = ms->description().dropper;
+    BOOST_CHECK_EQUAL(dropper.wal, size_t(0));
+    BOOST_CHECK_GE(dropper.dropped, size_t(1));
+    for (size_t i = 0; i < Dropper::STAGES_COUNT; ++i) {
+      BOOST_CHECK_EQUAL(dropper.queue[i], size_t(0));
+    }
   }
   if (dariadb::utils::fs::path_exists(storage_path)) {
     dariadb::utils::fs::rm(storage_path);
@@ -269,6 +359,66 @@ BOOST_AUTO_TEST_CASE(Subscribe) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(Engine_BatchAppend_test) {
+  const std::string storage_path = "testStorage";
+  const size_t id_count = 5;
+  const size_t total_count = 1000;
+
+  using namespace dariadb::storage;
+  for (auto strategy : {STRATEGY::COMPRESSED, STRATEGY::MEMORY, STRATEGY::CACHE}) {
+    std::cout << "Engine_BatchAppend_test " << strategy << std::endl;
+    if (dariadb::utils::fs::path_exists(storage_path)) {
+      dariadb::utils::fs::rm(storage_path);
+    }
+    auto c = std::make_shared<Moc_SubscribeClbk>();
+    {
+      auto settings = dariadb::storage::Settings::create(storage_path);
+      settings->strategy.setValue(strategy);
+      settings->chunk_size.setValue(128);
+      settings->wal_cache_size.setValue(100);
+      std::unique_ptr<Engine> ms{new Engine(settings)};
+      ms->subscribe(dariadb::IdArray{}, 0, c);
+
+      // ids are interleaved.
+      dariadb::MeasArray values(total_count);
+      for (size_t i = 0; i < total_count; ++i) {
+        values[i] = dariadb::Meas::empty(dariadb::Id(i % id_count));
+        values[i].time = dariadb::Time(i);
+        values[i].value = dariadb::Value(i);
+      }
+      auto status = ms->append(values.begin(), values.end());
+      BOOST_CHECK_EQUAL(status.writed, total_count);
+      BOOST_CHECK_EQUAL(status.ignored, size_t(0));
+      BOOST_CHECK_EQUAL(c->values.size(), total_count);
+
+      // value from past at begin of run.
+      dariadb::MeasList second;
+      second.push_back(values.front());
+      second.front().time = 1;
+      auto m = dariadb::Meas::empty(0);
+      m.time = total_count * 2;
+      second.push_back(m);
+      status = ms->append(second.begin(), second.end());
+      BOOST_CHECK_EQUAL(status.writed + status.ignored, second.size());
+      BOOST_CHECK_EQUAL(c->values.size(), total_count + status.writed);
+
+      auto cur = ms->currentValue(dariadb::IdArray{}, 0);
+      BOOST_CHECK_EQUAL(cur.size(), id_count);
+      BOOST_CHECK_EQUAL(cur[0].time, m.time);
+      for (dariadb::Id id = 1; id < id_count; ++id) {
+        BOOST_CHECK_EQUAL(cur[id].time, dariadb::Time(total_count - id_count + id));
+      }
+
+      dariadb::IdArray ids{0, 1, 2, 3, 4};
+      auto readed = ms->readInterval(QueryInterval(ids, 0, 0, total_count * 2));
+      BOOST_CHECK_EQUAL(readed.size(), total_count + status.writed);
+    }
+    if (dariadb::utils::fs::path_exists(storage_path)) {
+      dariadb::utils::fs::rm(storage_path);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_CASE(Engine_MemStorage_common_test) {
   const std::string storage_path = "testStorage";
   const size_t chunk_size = 256;
@@ -408,3 +558,446 @@ BOOST_AUTO_TEST_CASE(Engine_ByStep_common_test) {
     dariadb::utils::fs::rm(storage_path);
   }
 }
+
+BOOST_AUTO_TEST_CASE(Engine_Erase_test) {
+  const std::string storage_path = "testStorage";
+  const dariadb::Time from = 0;
+  const dariadb::Time to = 100;
+
+  using namespace dariadb::storage;
+
+  {
+    std::cout << "Engine_Erase_test\n";
+    if (dariadb::utils::fs::path_exists(storage_path)) {
+      dariadb::utils::fs::rm(storage_path);
+    }
+
+    auto settings = dariadb::storage::Settings::create(storage_path);
+    settings->wal_cache_size.setValue(50);
+    settings->wal_file_size.setValue(100);
+    settings->chunk_size.setValue(256);
+    settings->strategy.setValue(STRATEGY::WAL);
+    std::unique_ptr<Engine> ms{new Engine(settings)};
+
+    auto m = dariadb::Meas::empty();
+    for (dariadb::Id id = 0; id < 3; ++id) {
+      for (auto t = from; t < to; ++t) {
+        m.id = id;
+        m.time = t;
+        m.value = dariadb::Value(t);
+        ms->append(m);
+      }
+    }
+    ms->compress_all();
+    BOOST_CHECK_GE(ms->description().pages_count, size_t(1));
+
+    // one value in wal level.
+    m.id = 1;
+    m.time = to + 1;
+    ms->append(m);
+
+    ms->erase({1}, 10, 39);
+    ms->erase({2}, dariadb::MIN_TIME, dariadb::MAX_TIME);
+
+    QueryInterval qi({0, 1, 2}, 0, from, to * 2);
+    auto values = ms->readInterval(qi);
+    size_t id1_count = 0;
+    for (auto &v : values) {
+      BOOST_CHECK(v.id != dariadb::Id(2));
+      if (v.id == dariadb::Id(1)) {
+        BOOST_CHECK(v.time < 10 || v.time > 39);
+        id1_count++;
+      }
+    }
+    BOOST_CHECK_EQUAL(id1_count, size_t(to - from - 30 + 1));
+
+    QueryTimePoint qp({1, 2}, 0, 20);
+    auto tp = ms->readTimePoint(qp);
+    BOOST_CHECK_EQUAL(tp[1].time, dariadb::Time(9));
+    BOOST_CHECK_EQUAL(tp[2].flag, dariadb::Flag(dariadb::Flags::_NO_DATA));
+
+    auto cur = ms->currentValue({0, 1, 2}, 0);
+    BOOST_CHECK(cur.find(2) == cur.end());
+    BOOST_CHECK_EQUAL(cur[1].time, dariadb::Time(to + 1));
+
+    // values appended after erase are not covered by its tombstone.
+    for (dariadb::Time t = 20; t < 25; ++t) {
+      m.id = 1;
+      m.time = t;
+      m.value = dariadb::Value(t);
+      ms->append(m);
+    }
+    qi.ids = {1};
+    BOOST_CHECK_EQUAL(ms->readInterval(qi).size(), size_t(to - from - 30 + 1 + 5));
+    tp = ms->readTimePoint(qp);
+    BOOST_CHECK_EQUAL(tp[1].time, dariadb::Time(20));
+  }
+  {
+    std::cout << "Reopen storage to load tombstones\n";
+    auto settings = dariadb::storage::Settings::create(storage_path);
+    std::unique_ptr<Engine> ms{new Engine(settings)};
+
+    QueryInterval qi({2}, 0, from, to * 2);
+    BOOST_CHECK(ms->readInterval(qi).empty());
+    qi.ids = {1};
+    BOOST_CHECK_EQUAL(ms->readInterval(qi).size(), size_t(to - from - 30 + 1 + 5));
+
+    ms->compress_all();
+    ms->compactbyTime(dariadb::MIN_TIME, dariadb::MAX_TIME);
+    BOOST_CHECK_EQUAL(ms->readInterval(qi).size(), size_t(to - from - 30 + 1 + 5));
+    qi.ids = {2};
+    BOOST_CHECK(ms->readInterval(qi).empty());
+  }
+  {
+    auto settings = dariadb::storage::Settings::create(storage_path);
+    auto manifest = Manifest::create(settings);
+    BOOST_CHECK(manifest->tombstone_list().empty());
+  }
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+}
+
+class IdOrderCallback : public dariadb::storage::IReaderClb {
+public:
+  void call(const dariadb::Meas &m) override { ids.push_back(m.id); }
+  void call_batch(const dariadb::Meas *begin, size_t n) override {
+    batches++;
+    IReaderClb::call_batch(begin, n);
+  }
+  std::vector<dariadb::Id> ids;
+  size_t batches = 0;
+};
+
+BOOST_AUTO_TEST_CASE(Engine_MultiIdForeach_test) {
+  const std::string storage_path = "testStorage";
+  const dariadb::Time to = 100;
+
+  using namespace dariadb::storage;
+
+  {
+    std::cout << "Engine_MultiIdForeach_test\n";
+    if (dariadb::utils::fs::path_exists(storage_path)) {
+      dariadb::utils::fs::rm(storage_path);
+    }
+
+    auto settings = dariadb::storage::Settings::create(storage_path);
+    settings->wal_cache_size.setValue(50);
+    settings->wal_file_size.setValue(100);
+    settings->chunk_size.setValue(256);
+    settings->strategy.setValue(STRATEGY::WAL);
+    std::unique_ptr<Engine> ms{new Engine(settings)};
+
+    auto m = dariadb::Meas::empty();
+    for (auto t = dariadb::Time(0); t < to; ++t) {
+      for (dariadb::Id id = 0; id < 5; ++id) {
+        m.id = id;
+        m.time = t;
+        ms->append(m);
+      }
+      if (t == to / 2) {
+        ms->compress_all();
+      }
+    }
+
+    // values are grouped by id in order of query.
+    dariadb::IdArray ids{3, 0, 4};
+    IdOrderCallback clbk;
+    ms->foreach (QueryInterval(ids, 0, 0, to), &clbk);
+    clbk.wait();
+    BOOST_CHECK_EQUAL(clbk.ids.size(), ids.size() * to);
+    for (size_t i = 0; i < clbk.ids.size(); ++i) {
+      BOOST_CHECK_EQUAL(clbk.ids[i], ids[i / to]);
+    }
+    // values of each level are sended by batches.
+    BOOST_CHECK(clbk.batches > size_t(0));
+    BOOST_CHECK(clbk.batches < clbk.ids.size());
+  }
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Engine_Cursor_test) {
+  const std::string storage_path = "testStorage";
+  const dariadb::Time to = 100;
+  const size_t batch_size = 16;
+
+  using namespace dariadb::storage;
+
+  {
+    std::cout << "Engine_Cursor_test\n";
+    if (dariadb::utils::fs::path_exists(storage_path)) {
+      dariadb::utils::fs::rm(storage_path);
+    }
+
+    auto settings = dariadb::storage::Settings::create(storage_path);
+    settings->wal_cache_size.setValue(50);
+    settings->wal_file_size.setValue(100);
+    settings->chunk_size.setValue(256);
+    settings->strategy.setValue(STRATEGY::WAL);
+    std::unique_ptr<Engine> ms{new Engine(settings)};
+
+    auto m = dariadb::Meas::empty();
+    for (auto t = dariadb::Time(0); t < to; ++t) {
+      for (dariadb::Id id = 0; id < 5; ++id) {
+        m.id = id;
+        m.time = t;
+        ms->append(m);
+      }
+      if (t == to / 2) {
+        ms->compress_all();
+      }
+    }
+
+    dariadb::IdArray ids{3, 0, 4};
+    QueryInterval qi(ids, 0, 0, to);
+    auto expected = ms->readInterval(qi);
+    BOOST_CHECK_EQUAL(expected.size(), ids.size() * to);
+
+    // values of open cursor are not changed by compaction.
+    auto cursor = ms->openCursor(qi, batch_size);
+    ms->compress_all();
+    dariadb::MeasArray readed;
+    MeasBatch batch;
+    while (cursor->next(&batch)) {
+      BOOST_CHECK(!batch.empty());
+      BOOST_CHECK(batch.size <= batch_size);
+      readed.insert(readed.end(), batch.begin(), batch.end());
+    }
+    BOOST_CHECK(cursor->is_closed());
+    BOOST_CHECK_EQUAL(readed.size(), expected.size());
+    auto it = expected.begin();
+    for (auto &v : readed) {
+      BOOST_CHECK_EQUAL(v.id, it->id);
+      BOOST_CHECK_EQUAL(v.time, it->time);
+      ++it;
+    }
+
+    // early termination.
+    cursor = ms->openCursor(qi, batch_size);
+    BOOST_CHECK(cursor->next(&batch));
+    BOOST_CHECK_EQUAL(batch.size, batch_size);
+    BOOST_CHECK_EQUAL(batch[0].id, ids.front());
+    cursor->close();
+    BOOST_CHECK(!cursor->next(&batch));
+    cursor = nullptr;
+    BOOST_CHECK_EQUAL(ms->readInterval(qi).size(), expected.size());
+  }
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Engine_ParallelQuery_test) {
+  const std::string storage_path = "testStorage";
+  const dariadb::Time to = 50;
+  // more batches of ids, than parallel tasks.
+  const dariadb::Id id_count = 300;
+
+  using namespace dariadb::storage;
+
+  {
+    std::cout << "Engine_ParallelQuery_test\n";
+    if (dariadb::utils::fs::path_exists(storage_path)) {
+      dariadb::utils::fs::rm(storage_path);
+    }
+
+    auto settings = dariadb::storage::Settings::create(storage_path);
+    settings->wal_cache_size.setValue(50);
+    settings->wal_file_size.setValue(500);
+    settings->chunk_size.setValue(256);
+    settings->strategy.setValue(STRATEGY::WAL);
+    settings->query_fanout.setValue(4);
+    std::unique_ptr<Engine> ms{new Engine(settings)};
+
+    auto m = dariadb::Meas::empty();
+    for (auto t = dariadb::Time(0); t < to; ++t) {
+      for (dariadb::Id id = 0; id < id_count; ++id) {
+        m.id = id;
+        m.time = t;
+        ms->append(m);
+      }
+      if (t == to / 2) {
+        ms->compress_all();
+      }
+    }
+
+    dariadb::IdArray ids;
+    for (dariadb::Id id = 0; id < id_count; ++id) {
+      ids.push_back(id_count - id - 1);
+    }
+    QueryInterval qi(ids, 0, 0, to);
+
+    // batches of ids are readed in parallel, but sended in order of query.
+    IdOrderCallback clbk;
+    ms->foreach (qi, &clbk);
+    clbk.wait();
+    BOOST_CHECK_EQUAL(clbk.ids.size(), ids.size() * to);
+    for (size_t i = 0; i < clbk.ids.size(); ++i) {
+      BOOST_CHECK_EQUAL(clbk.ids[i], ids[i / to]);
+    }
+
+    auto readed = ms->readInterval(qi);
+    BOOST_CHECK_EQUAL(readed.size(), ids.size() * to);
+    size_t pos = 0;
+    for (auto &v : readed) {
+      BOOST_CHECK_EQUAL(v.id, ids[pos / to]);
+      BOOST_CHECK_EQUAL(v.time, dariadb::Time(pos % to));
+      ++pos;
+    }
+
+    // cursor reads ids by groups.
+    auto cursor = ms->openCursor(qi);
+    MeasBatch batch;
+    pos = 0;
+    while (cursor->next(&batch)) {
+      for (auto &v : batch) {
+        BOOST_CHECK_EQUAL(v.id, ids[pos / to]);
+        BOOST_CHECK_EQUAL(v.time, dariadb::Time(pos % to));
+        ++pos;
+      }
+    }
+    BOOST_CHECK_EQUAL(pos, ids.size() * to);
+  }
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Engine_Explain_test) {
+  const std::string storage_path = "testStorage";
+  const dariadb::Time to = 100;
+
+  using namespace dariadb::storage;
+
+  {
+    std::cout << "Engine_Explain_test\n";
+    if (dariadb::utils::fs::path_exists(storage_path)) {
+      dariadb::utils::fs::rm(storage_path);
+    }
+
+    auto settings = dariadb::storage::Settings::create(storage_path);
+    settings->wal_cache_size.setValue(50);
+    settings->wal_file_size.setValue(1000);
+    settings->chunk_size.setValue(256);
+    settings->strategy.setValue(STRATEGY::WAL);
+    std::unique_ptr<Engine> ms{new Engine(settings)};
+
+    auto m = dariadb::Meas::empty();
+    for (auto t = dariadb::Time(0); t < to; ++t) {
+      for (dariadb::Id id = 0; id < 5; ++id) {
+        m.id = id;
+        m.time = t;
+        ms->append(m);
+      }
+      if (t == to / 2) {
+        ms->compress_all();
+      }
+    }
+
+    // recent values are only in wal.
+    dariadb::IdArray ids{0, 1, 7};
+    QueryInterval recent(ids, 0, 80, to);
+    auto plan = ms->explain(recent);
+    BOOST_CHECK(plan[LEVEL::PAGES].exists);
+    BOOST_CHECK(plan[LEVEL::WAL].exists);
+    BOOST_CHECK(!plan[LEVEL::MEMORY].exists);
+    BOOST_CHECK(plan[LEVEL::PAGES].scan.empty());
+    BOOST_CHECK_EQUAL(plan[LEVEL::PAGES].pruned.size(), ids.size());
+    BOOST_CHECK_EQUAL(plan[LEVEL::WAL].scan.size(), size_t(2));
+    BOOST_CHECK_EQUAL(plan[LEVEL::WAL].pruned.size(), size_t(1));
+    BOOST_CHECK_EQUAL(plan[LEVEL::WAL].pruned.front(), dariadb::Id(7));
+    BOOST_CHECK(!plan.to_string().empty());
+
+    auto readed = ms->readInterval(recent);
+    BOOST_CHECK_EQUAL(readed.size(), size_t(2 * (to - 80)));
+
+    QueryInterval old(ids, 0, 0, 10);
+    plan = ms->explain(old);
+    BOOST_CHECK_EQUAL(plan[LEVEL::PAGES].scan.size(), size_t(2));
+    readed = ms->readInterval(old);
+    BOOST_CHECK_EQUAL(readed.size(), size_t(2 * 11));
+
+    dariadb::Time minT, maxT;
+    BOOST_CHECK(ms->minMaxTime(1, &minT, &maxT));
+    BOOST_CHECK_EQUAL(minT, dariadb::Time(0));
+    BOOST_CHECK_EQUAL(maxT, to - 1);
+    BOOST_CHECK(!ms->minMaxTime(7, &minT, &maxT));
+  }
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Engine_TimePoint_test) {
+  const std::string storage_path = "testStorage";
+  const dariadb::Time to = 300;
+  const dariadb::Id ids_count = 30;
+
+  using namespace dariadb::storage;
+
+  // id writes each (id%3+1) time, until id*10.
+  auto last_before = [](dariadb::Id id, dariadb::Time tp) {
+    auto step = dariadb::Time(id % 3 + 1);
+    auto last = std::min(tp, dariadb::Time(id * 10));
+    return last - last % step;
+  };
+
+  {
+    std::cout << "Engine_TimePoint_test\n";
+    if (dariadb::utils::fs::path_exists(storage_path)) {
+      dariadb::utils::fs::rm(storage_path);
+    }
+
+    auto settings = dariadb::storage::Settings::create(storage_path);
+    settings->wal_cache_size.setValue(50);
+    settings->wal_file_size.setValue(1000);
+    settings->chunk_size.setValue(256);
+    settings->strategy.setValue(STRATEGY::WAL);
+    std::unique_ptr<Engine> ms{new Engine(settings)};
+
+    auto m = dariadb::Meas::empty();
+    for (auto t = dariadb::Time(0); t < to; ++t) {
+      for (dariadb::Id id = 0; id < ids_count; ++id) {
+        if (t % (id % 3 + 1) != 0 || t > dariadb::Time(id * 10)) {
+          continue;
+        }
+        m.id = id;
+        m.time = t;
+        m.value = dariadb::Value(t);
+        ms->append(m);
+      }
+      if (t != 0 && t % 70 == 0) {
+        ms->compress_all();
+      }
+    }
+
+    dariadb::IdArray ids;
+    for (dariadb::Id id = 0; id < ids_count; ++id) {
+      ids.push_back(id);
+    }
+    ids.push_back(ids_count + 1); // not writed.
+
+    for (auto tp : {dariadb::Time(5), dariadb::Time(69), dariadb::Time(150),
+                    dariadb::Time(to)}) {
+      QueryTimePoint qp(ids, 0, tp);
+      auto values = ms->readTimePoint(qp);
+      BOOST_CHECK_EQUAL(values.size(), ids.size());
+      for (dariadb::Id id = 0; id < ids_count; ++id) {
+        auto v = values[id];
+        BOOST_CHECK(v.flag != dariadb::Flags::_NO_DATA);
+        BOOST_CHECK_EQUAL(v.time, last_before(id, tp));
+        BOOST_CHECK_EQUAL(v.value, dariadb::Value(v.time));
+
+        // batched read is equal to read of one id.
+        QueryTimePoint one({id}, 0, tp);
+        BOOST_CHECK_EQUAL(ms->readTimePoint(one)[id].time, v.time);
+      }
+      BOOST_CHECK_EQUAL(values[ids_count + 1].flag, dariadb::Flags::_NO_DATA);
+    }
+  }
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+}
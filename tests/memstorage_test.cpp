@@ -11,6 +11,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <thread>
 
 #include "test_common.h"
 
@@ -43,6 +44,20 @@ struct MokChunkWriter : public dariadb::storage::IChunkContainer {
                  dariadb::storage::IReaderClb *clb) override {}
 };
 
+/// remember ids of first dropped chunks.
+struct MokIdsChunkWriter : public MokChunkWriter {
+  std::set<dariadb::Id> ids;
+  void appendChunks(const std::vector<dariadb::storage::Chunk *> &a,
+                    size_t count) override {
+    if (droped == 0) {
+      for (size_t i = 0; i < count; ++i) {
+        ids.insert(a[i]->header->meas_id);
+      }
+    }
+    MokChunkWriter::appendChunks(a, count);
+  }
+};
+
 struct MocDiskStorage : public dariadb::storage::IMeasWriter {
   size_t droped;
   MocDiskStorage() { droped = 0; }
@@ -87,6 +102,51 @@ BOOST_AUTO_TEST_CASE(MemChunkAllocatorTest) {
   BOOST_CHECK_EQUAL(new_obj.position, last.position);
 }
 
+BOOST_AUTO_TEST_CASE(MemChunkAllocatorSlabsTest) {
+  std::cout << "MemChunkAllocatorSlabsTest" << std::endl;
+  using dariadb::storage::MemChunkAllocator;
+  const uint32_t buffer_size = 1024;
+  const size_t slabs = 4;
+  const size_t max_size = MemChunkAllocator::SLAB_SIZE * slabs;
+  MemChunkAllocator allocator(max_size, buffer_size);
+  BOOST_CHECK_EQUAL(allocator.mapped_size(), size_t(0));
+
+  std::vector<MemChunkAllocator::AllocatedData> all;
+  std::set<size_t> positions;
+  while (true) {
+    auto allocated = allocator.allocate();
+    if (allocated.header == nullptr) {
+      break;
+    }
+    BOOST_CHECK_EQUAL(allocated.header->size, uint32_t(0));
+    allocated.header->size = buffer_size;
+    positions.insert(allocated.position);
+    all.push_back(allocated);
+  }
+  BOOST_CHECK_EQUAL(all.size(), allocator._capacity);
+  BOOST_CHECK_EQUAL(positions.size(), all.size());
+  auto slabs_count = allocator._slabs.size();
+  BOOST_CHECK_GE(slabs_count, slabs);
+  BOOST_CHECK_EQUAL(allocator.mapped_size(), slabs_count * allocator._slab_size);
+
+  for (auto &a : all) {
+    allocator.free(a);
+  }
+  BOOST_CHECK_EQUAL(allocator._allocated.load(), size_t(0));
+  BOOST_CHECK_EQUAL(allocator.shrink(), slabs_count - MemChunkAllocator::SPARE_SLABS);
+  BOOST_CHECK_EQUAL(allocator.mapped_size(),
+                    allocator._slab_size * MemChunkAllocator::SPARE_SLABS);
+
+  // memory is mapped again on demand.
+  all.clear();
+  for (size_t i = 0; i < allocator._capacity; ++i) {
+    auto allocated = allocator.allocate();
+    BOOST_CHECK(allocated.header != nullptr);
+    BOOST_CHECK_EQUAL(allocated.header->size, uint32_t(0));
+  }
+  BOOST_CHECK_EQUAL(allocator.mapped_size(), slabs_count * allocator._slab_size);
+}
+
 BOOST_AUTO_TEST_CASE(MemStorageCommonTest) {
   std::cout << "MemStorageCommonTest" << std::endl;
   auto storage_path = "testMemoryStorage";
@@ -112,6 +172,185 @@ BOOST_AUTO_TEST_CASE(MemStorageCommonTest) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(MemStorageConcurrentIdsTest) {
+  std::cout << "MemStorageConcurrentIdsTest" << std::endl;
+  auto storage_path = "testMemoryStorage";
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+  const size_t threads_count = 4;
+  const size_t ids_per_thread = 500;
+  const size_t values_per_id = 10;
+  {
+    auto settings = dariadb::storage::Settings::create(storage_path);
+    settings->strategy.setValue(dariadb::storage::STRATEGY::MEMORY);
+    settings->chunk_size.setValue(128);
+    auto _engine_env = dariadb::storage::EngineEnvironment::create();
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::SETTINGS,
+                             settings.get());
+    dariadb::utils::async::ThreadManager::start(settings->thread_pools_params());
+
+    auto ms = dariadb::storage::MemStorage::create(_engine_env, size_t(0));
+
+    // new ids are added from all threads at once.
+    std::vector<std::thread> writers;
+    for (size_t t = 0; t < threads_count; ++t) {
+      writers.emplace_back([&ms, t, ids_per_thread, values_per_id, threads_count]() {
+        auto m = dariadb::Meas::empty();
+        for (size_t v = 0; v < values_per_id; ++v) {
+          for (size_t i = 0; i < ids_per_thread; ++i) {
+            m.id = dariadb::Id(i * threads_count + t);
+            m.time = v;
+            ms->append(m);
+          }
+        }
+      });
+    }
+    for (auto &w : writers) {
+      w.join();
+    }
+
+    auto mm = ms->loadMinMax();
+    BOOST_CHECK_EQUAL(mm.size(), threads_count * ids_per_thread);
+    for (auto &kv : mm) {
+      BOOST_CHECK_EQUAL(kv.second.min.time, dariadb::Time(0));
+      BOOST_CHECK_EQUAL(kv.second.max.time, dariadb::Time(values_per_id - 1));
+    }
+    auto sync_map = ms->getSyncMap();
+    BOOST_CHECK_EQUAL(sync_map.size(), threads_count * ids_per_thread);
+
+    dariadb::IdArray ids{dariadb::Id(0), dariadb::Id(threads_count * ids_per_thread - 1)};
+    dariadb::storage::QueryInterval qi(ids, 0, 0, values_per_id);
+    auto values = ms->readInterval(qi);
+    BOOST_CHECK_EQUAL(values.size(), ids.size() * values_per_id);
+  }
+  dariadb::utils::async::ThreadManager::stop();
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(MemStorageReorderTest) {
+  std::cout << "MemStorageReorderTest" << std::endl;
+  auto storage_path = "testMemoryStorage";
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+  {
+    auto settings = dariadb::storage::Settings::create(storage_path);
+    settings->strategy.setValue(dariadb::storage::STRATEGY::MEMORY);
+    settings->chunk_size.setValue(128);
+    settings->memory_reorder_window.setValue(10);
+    auto _engine_env = dariadb::storage::EngineEnvironment::create();
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::SETTINGS,
+                             settings.get());
+    dariadb::utils::async::ThreadManager::start(settings->thread_pools_params());
+
+    auto ms = dariadb::storage::MemStorage::create(_engine_env, size_t(0));
+
+    auto append = [&ms](dariadb::Time t) {
+      auto m = dariadb::Meas::empty(1);
+      m.time = t;
+      m.value = dariadb::Value(t);
+      return ms->append(m);
+    };
+    for (auto t : {5, 3, 4, 1, 2, 10, 8, 9, 20, 15}) {
+      BOOST_CHECK_EQUAL(append(dariadb::Time(t)).writed, size_t(1));
+    }
+    // 1..9 are moved to chunks by 20.
+    BOOST_CHECK_EQUAL(append(dariadb::Time(7)).ignored, size_t(1));
+    BOOST_CHECK_EQUAL(append(dariadb::Time(11)).writed, size_t(1));
+    BOOST_CHECK_EQUAL(append(dariadb::Time(30)).writed, size_t(1));
+    // older than window, but newer than chunks.
+    BOOST_CHECK_EQUAL(append(dariadb::Time(17)).writed, size_t(1));
+
+    std::vector<dariadb::Time> expected{1, 2, 3, 4, 5, 8, 9, 10, 11, 15, 17, 20, 30};
+    auto check_values = [&]() {
+      dariadb::storage::QueryInterval qi({1}, 0, 0, 100);
+      auto values = ms->readInterval(qi);
+      BOOST_CHECK_EQUAL(values.size(), expected.size());
+      size_t i = 0;
+      for (auto &v : values) {
+        BOOST_CHECK_EQUAL(v.time, expected[i++]);
+      }
+
+      dariadb::storage::QueryTimePoint qp({1}, 0, 12);
+      BOOST_CHECK_EQUAL(ms->readTimePoint(qp)[1].time, dariadb::Time(11));
+      BOOST_CHECK_EQUAL(ms->currentValue({1}, 0)[1].time, dariadb::Time(30));
+
+      dariadb::Time minT, maxT;
+      BOOST_CHECK(ms->minMaxTime(1, &minT, &maxT));
+      BOOST_CHECK_EQUAL(minT, dariadb::Time(1));
+      BOOST_CHECK_EQUAL(maxT, dariadb::Time(30));
+    };
+    check_values();
+    ms->flush();
+    check_values();
+  }
+  dariadb::utils::async::ThreadManager::stop();
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(MemStorageReadWhileWriteTest) {
+  std::cout << "MemStorageReadWhileWriteTest" << std::endl;
+  auto storage_path = "testMemoryStorage";
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+  for (auto window : {0, 4}) {
+    auto settings = dariadb::storage::Settings::create(storage_path);
+    settings->strategy.setValue(dariadb::storage::STRATEGY::MEMORY);
+    settings->chunk_size.setValue(128);
+    settings->memory_reorder_window.setValue(window);
+    auto _engine_env = dariadb::storage::EngineEnvironment::create();
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::SETTINGS,
+                             settings.get());
+    dariadb::utils::async::ThreadManager::start(settings->thread_pools_params());
+    {
+      auto ms = dariadb::storage::MemStorage::create(_engine_env, size_t(0));
+      const dariadb::Time count = 5000;
+
+      std::atomic_bool stoped{false};
+      std::thread writer([&ms, &stoped, window, count]() {
+        auto m = dariadb::Meas::empty(1);
+        for (dariadb::Time t = 1; t <= count; t += 2) {
+          // pairs are swapped, when reorder window is enabled.
+          for (auto time : {window == 0 ? t : t + 1, window == 0 ? t + 1 : t}) {
+            m.time = time;
+            m.value = dariadb::Value(time);
+            BOOST_CHECK_EQUAL(ms->append(m).writed, size_t(1));
+          }
+        }
+        stoped = true;
+      });
+
+      size_t prev_size = 0;
+      dariadb::storage::QueryInterval qi({1}, 0, 0, count);
+      while (!stoped.load()) {
+        // raw values of foreach, without sorting and deduplication of readInterval.
+        dariadb::storage::MList_ReaderClb clbk;
+        ms->foreach (qi, &clbk);
+        auto &values = clbk.mlist;
+        BOOST_CHECK_GE(values.size(), prev_size);
+        prev_size = values.size();
+        auto not_increased =
+            std::adjacent_find(values.cbegin(), values.cend(),
+                               [](auto &l, auto &r) { return l.time >= r.time; });
+        BOOST_CHECK(not_increased == values.cend());
+      }
+      writer.join();
+      ms->flush();
+      BOOST_CHECK_EQUAL(ms->readInterval(qi).size(), size_t(count));
+    }
+    dariadb::utils::async::ThreadManager::stop();
+  }
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(MemStorageDropByLimitTest) {
   std::cout << "MemStorageDropByLimitTest" << std::endl;
   auto storage_path = "testMemoryStorage";
@@ -150,6 +389,186 @@ BOOST_AUTO_TEST_CASE(MemStorageDropByLimitTest) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(MemStorageDropOldestTest) {
+  std::cout << "MemStorageDropOldestTest" << std::endl;
+  auto storage_path = "testMemoryStorage";
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+  MokIdsChunkWriter *cw = new MokIdsChunkWriter;
+  {
+    auto settings = dariadb::storage::Settings::create(storage_path);
+    settings->strategy.setValue(dariadb::storage::STRATEGY::MEMORY);
+    settings->memory_limit.setValue(1024 * 1024);
+    settings->chunk_size.setValue(128);
+    auto _engine_env = dariadb::storage::EngineEnvironment::create();
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::SETTINGS,
+                             settings.get());
+    dariadb::utils::async::ThreadManager::start(settings->thread_pools_params());
+
+    auto ms = dariadb::storage::MemStorage::create(_engine_env, size_t(0));
+    ms->setDownLevel(cw);
+
+    // newer values are written first, older - later.
+    auto e = dariadb::Meas::empty(2);
+    e.time = 1000000000;
+    auto capacity = ms->description().allocator_capacity;
+    while (ms->description().allocated < capacity / 2) {
+      e.time++;
+      ms->append(e);
+    }
+    e = dariadb::Meas::empty(1);
+    while (cw->droped == 0) {
+      e.time++;
+      ms->append(e);
+    }
+    ms->stop();
+    // first drop takes only chunks with older values.
+    BOOST_CHECK_EQUAL(cw->ids.size(), size_t(1));
+    BOOST_CHECK_EQUAL(*cw->ids.begin(), dariadb::Id(1));
+  }
+  delete cw;
+  dariadb::utils::async::ThreadManager::stop();
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(BackpressureTest) {
+  std::cout << "BackpressureTest" << std::endl;
+  using dariadb::storage::Backpressure;
+  Backpressure::Params p;
+  p.high = 10;
+  p.low = 5;
+  p.timeout = 20;
+  Backpressure bp("test", p);
+
+  bp.update(9);
+  BOOST_CHECK(!bp.overloaded());
+  BOOST_CHECK(bp.admit() == dariadb::APPEND_ERROR::OK);
+  bp.update(10);
+  BOOST_CHECK(bp.overloaded());
+  bp.update(6); // above low watermark.
+  BOOST_CHECK(bp.overloaded());
+  size_t kicks = 0;
+  BOOST_CHECK(bp.admit([&kicks]() { kicks++; }) == dariadb::APPEND_ERROR::TIMEOUT);
+  BOOST_CHECK_GT(kicks, size_t(0));
+
+  std::thread consumer([&bp]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    bp.update(5);
+  });
+  p.timeout = 0;
+  Backpressure::Params fast = p;
+  fast.fail_fast = true;
+  Backpressure bp_fast("test_fast", fast);
+  bp_fast.update(10);
+  BOOST_CHECK(bp_fast.admit() == dariadb::APPEND_ERROR::OVERLOADED);
+
+  bp.wait();
+  consumer.join();
+  BOOST_CHECK(!bp.overloaded());
+
+  auto d = bp.description();
+  BOOST_CHECK_EQUAL(d.level, size_t(5));
+  BOOST_CHECK_GE(d.waits, size_t(1));
+  BOOST_CHECK_EQUAL(d.rejected, size_t(1));
+  BOOST_CHECK_EQUAL(bp_fast.description().rejected, size_t(1));
+  BOOST_CHECK_EQUAL(bp_fast.description().waits, size_t(0));
+}
+
+BOOST_AUTO_TEST_CASE(MemStorageBackpressureTest) {
+  std::cout << "MemStorageBackpressureTest" << std::endl;
+  auto storage_path = "testMemoryStorage";
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+  MokChunkWriter *cw = new MokChunkWriter;
+  {
+    auto settings = dariadb::storage::Settings::create(storage_path);
+    settings->strategy.setValue(dariadb::storage::STRATEGY::MEMORY);
+    settings->memory_limit.setValue(256 * 1024);
+    settings->chunk_size.setValue(128);
+    settings->write_timeout.setValue(20);
+    auto _engine_env = dariadb::storage::EngineEnvironment::create();
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::SETTINGS,
+                             settings.get());
+    dariadb::utils::async::ThreadManager::start(settings->thread_pools_params());
+
+    auto ms = dariadb::storage::MemStorage::create(_engine_env, size_t(0));
+    ms->setDownLevel(cw);
+
+    // chunk per id, all chunks are not closed - nothing to drop.
+    auto capacity = ms->description().allocator_capacity;
+    dariadb::Status status;
+    dariadb::Id id = 0;
+    for (; id < capacity * 2; ++id) {
+      status = ms->append(dariadb::Meas::empty(id));
+      if (status.writed == 0) {
+        break;
+      }
+    }
+    BOOST_CHECK_EQUAL(id, dariadb::Id(capacity));
+    BOOST_CHECK(status.error == dariadb::APPEND_ERROR::TIMEOUT);
+    BOOST_CHECK_EQUAL(status.ignored, size_t(1));
+
+    auto d = ms->description().backpressure;
+    BOOST_CHECK(d.overloaded);
+    BOOST_CHECK_EQUAL(d.rejected, size_t(1));
+    BOOST_CHECK_GE(d.wait_time, uint64_t(20));
+    ms->stop();
+  }
+  delete cw;
+  dariadb::utils::async::ThreadManager::stop();
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(MemStorageWatermarksTest) {
+  std::cout << "MemStorageWatermarksTest" << std::endl;
+  auto storage_path = "testMemoryStorage";
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+  MokChunkWriter *cw = new MokChunkWriter;
+  {
+    auto settings = dariadb::storage::Settings::create(storage_path);
+    settings->strategy.setValue(dariadb::storage::STRATEGY::MEMORY);
+    settings->memory_limit.setValue(256 * 1024);
+    settings->chunk_size.setValue(128);
+    settings->memory_high.setValue(float(0.5));
+    settings->memory_low.setValue(float(0.25));
+    settings->write_fail_fast.setValue(true);
+    auto _engine_env = dariadb::storage::EngineEnvironment::create();
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::SETTINGS,
+                             settings.get());
+    dariadb::utils::async::ThreadManager::start(settings->thread_pools_params());
+
+    auto ms = dariadb::storage::MemStorage::create(_engine_env, size_t(0));
+    ms->setDownLevel(cw);
+
+    // writers are stopped by memory_high, before all chunks are used.
+    auto capacity = ms->description().allocator_capacity;
+    dariadb::Status status;
+    dariadb::Id id = 0;
+    for (; id < capacity; ++id) {
+      status = ms->append(dariadb::Meas::empty(id));
+      if (status.writed == 0) {
+        break;
+      }
+    }
+    BOOST_CHECK_EQUAL(id, dariadb::Id(capacity / 2));
+    BOOST_CHECK(ms->description().backpressure.overloaded);
+    ms->stop();
+  }
+  delete cw;
+  dariadb::utils::async::ThreadManager::stop();
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(MemStorageCacheTest) {
   std::cout << "MemStorageCacheTest" << std::endl;
   auto storage_path = "testMemoryStorage";
@@ -12,6 +12,7 @@
 #include <libdariadb/storage/pages/page.h>
 #include <libdariadb/storage/pages/page_manager.h>
 #include <libdariadb/storage/settings.h>
+#include <libdariadb/storage/version_set.h>
 #include <libdariadb/utils/async/thread_manager.h>
 #include <libdariadb/utils/fs.h>
 #include <libdariadb/utils/logger.h>
@@ -466,6 +467,83 @@ BOOST_AUTO_TEST_CASE(PageManagerCompaction) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(PageManagerSnapshotRead) {
+  const std::string storagePath = "testStorage";
+  const size_t chunks_size = 256;
+
+  if (dariadb::utils::fs::path_exists(storagePath)) {
+    dariadb::utils::fs::rm(storagePath);
+  }
+  auto settings = dariadb::storage::Settings::create(storagePath);
+  settings->chunk_size.setValue(chunks_size);
+
+  auto manifest = dariadb::storage::Manifest::create(settings);
+  dariadb::storage::VersionSet versions;
+
+  auto _engine_env = dariadb::storage::EngineEnvironment::create();
+  _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::SETTINGS,
+                           settings.get());
+  _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::MANIFEST,
+                           manifest.get());
+  _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::VERSIONS,
+                           &versions);
+
+  dariadb::utils::async::ThreadManager::start(settings->thread_pools_params());
+
+  auto pm = dariadb::storage::PageManager::create(_engine_env);
+
+  const size_t count = 100;
+  const size_t pages = 3;
+  auto e = dariadb::Meas::empty(1);
+  for (size_t p = 0; p < pages; ++p) {
+    dariadb::MeasArray a(count);
+    for (size_t i = 0; i < count; i++) {
+      e.time++;
+      e.value = dariadb::Value(i);
+      a[i] = e;
+    }
+    pm->append("page_prefix" + std::to_string(p), a);
+  }
+
+  auto read_all = [&pm](uint64_t version) {
+    dariadb::storage::QueryInterval qi({1}, 0, 0, dariadb::MAX_TIME);
+    qi.version = version;
+    auto link_list = pm->chunksByIterval(qi);
+    dariadb::storage::MList_ReaderClb clb;
+    pm->readLinks(qi, link_list, &clb);
+    return clb.mlist.size();
+  };
+
+  auto snapshot = versions.pin();
+  pm->compactTo(1);
+  // old pages are kept for the snapshot.
+  BOOST_CHECK_EQUAL(dariadb::utils::fs::ls(settings->raw_path.value(), ".page").size(),
+                    pages + 1);
+  BOOST_CHECK_EQUAL(pm->files_count(), size_t(1));
+  BOOST_CHECK_EQUAL(versions.description().retired, pages);
+  BOOST_CHECK_EQUAL(read_all(snapshot->version()), count * pages);
+  BOOST_CHECK_EQUAL(read_all(dariadb::storage::NEWEST_VERSION), count * pages);
+  BOOST_CHECK_EQUAL(pm->chunksByIterval(dariadb::storage::QueryInterval(
+                                            {1}, 0, 0, dariadb::MAX_TIME))
+                        .front()
+                        .page_name.find("page_prefix"),
+                    std::string::npos);
+
+  snapshot = nullptr;
+  BOOST_CHECK_EQUAL(versions.description().retired, size_t(0));
+  BOOST_CHECK_EQUAL(dariadb::utils::fs::ls(settings->raw_path.value(), ".page").size(),
+                    size_t(1));
+  BOOST_CHECK_EQUAL(read_all(versions.current()), count * pages);
+
+  pm = nullptr;
+  manifest = nullptr;
+  dariadb::utils::async::ThreadManager::stop();
+
+  if (dariadb::utils::fs::path_exists(storagePath)) {
+    dariadb::utils::fs::rm(storagePath);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(PageManagerCompactionByTime) {
   const std::string storagePath = "testStorage";
   const size_t chunks_size = 256;
@@ -516,3 +594,95 @@ BOOST_AUTO_TEST_CASE(PageManagerCompactionByTime) {
     dariadb::utils::fs::rm(storagePath);
   }
 }
+
+BOOST_AUTO_TEST_CASE(PageManagerPartitions) {
+  const std::string storagePath = "testStorage";
+  const size_t chunks_size = 256;
+  const dariadb::Time day = dariadb::Time(24) * 3600 * 1000;
+  const size_t days = 3;
+
+  if (dariadb::utils::fs::path_exists(storagePath)) {
+    dariadb::utils::fs::rm(storagePath);
+  }
+  auto settings = dariadb::storage::Settings::create(storagePath);
+  settings->chunk_size.setValue(chunks_size);
+  settings->partition.setValue(dariadb::storage::PARTITION_KIND::DAY);
+
+  auto manifest = dariadb::storage::Manifest::create(settings);
+
+  auto _engine_env = dariadb::storage::EngineEnvironment::create();
+  _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::SETTINGS,
+                           settings.get());
+  _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::MANIFEST,
+                           manifest.get());
+
+  dariadb::utils::async::ThreadManager::start(settings->thread_pools_params());
+
+  auto pm = dariadb::storage::PageManager::create(_engine_env);
+
+  dariadb::MeasArray a;
+  auto e = dariadb::Meas::empty(1);
+  for (e.time = 0; e.time < day * days; e.time += 3600 * 1000) {
+    e.value++;
+    a.push_back(e);
+  }
+  pm->append("page_prefix", a);
+
+  auto partitions = manifest->partition_list();
+  BOOST_CHECK_EQUAL(partitions.size(), days);
+  for (auto &p : partitions) {
+    auto partition_path = dariadb::utils::fs::append_path(settings->raw_path.value(), p.name);
+    BOOST_CHECK(dariadb::utils::fs::is_directory(partition_path));
+    BOOST_CHECK_EQUAL(
+        dariadb::utils::fs::ls(partition_path, dariadb::storage::PAGE_FILE_EXT).size(),
+        size_t(1));
+    BOOST_CHECK_EQUAL(p.name, dariadb::storage::partition_name(
+                                  dariadb::storage::PARTITION_KIND::DAY, p.minTime));
+  }
+  // 1970-01-11 is sunday, 1970-01-12 - monday.
+  BOOST_CHECK_EQUAL(
+      dariadb::storage::partition_name(dariadb::storage::PARTITION_KIND::WEEK, day * 10),
+      "1970-01-05");
+  BOOST_CHECK_EQUAL(
+      dariadb::storage::partition_name(dariadb::storage::PARTITION_KIND::WEEK, day * 11),
+      "1970-01-12");
+  BOOST_CHECK_EQUAL(pm->files_count(), days);
+
+  { // query of one day touch only one partition.
+    dariadb::storage::QueryInterval qi(dariadb::IdArray{1}, 0, day, day * 2 - 1);
+    auto links = pm->chunksByIterval(qi);
+    BOOST_CHECK(!links.empty());
+    for (auto &l : links) {
+      BOOST_CHECK(l.page_name.find(partitions.begin()->name) == std::string::npos);
+    }
+    auto clb = std::unique_ptr<dariadb::storage::MList_ReaderClb>{
+        new dariadb::storage::MList_ReaderClb};
+    pm->readLinks(qi, links, clb.get());
+    BOOST_CHECK_EQUAL(clb->mlist.size(), size_t(24));
+  }
+
+  pm->eraseOld(day * 2 - 1);
+  partitions = manifest->partition_list();
+  BOOST_CHECK_EQUAL(partitions.size(), size_t(1));
+  BOOST_CHECK_EQUAL(pm->files_count(), size_t(1));
+  BOOST_CHECK_EQUAL(dariadb::utils::fs::ls(settings->raw_path.value()).size(), size_t(1));
+
+  pm = nullptr;
+  pm = dariadb::storage::PageManager::create(_engine_env);
+  {
+    dariadb::storage::QueryInterval qi(dariadb::IdArray{1}, 0, 0, day * days);
+    auto links = pm->chunksByIterval(qi);
+    auto clb = std::unique_ptr<dariadb::storage::MList_ReaderClb>{
+        new dariadb::storage::MList_ReaderClb};
+    pm->readLinks(qi, links, clb.get());
+    BOOST_CHECK_EQUAL(clb->mlist.size(), size_t(24));
+  }
+
+  pm = nullptr;
+  manifest = nullptr;
+  dariadb::utils::async::ThreadManager::stop();
+
+  if (dariadb::utils::fs::path_exists(storagePath)) {
+    dariadb::utils::fs::rm(storagePath);
+  }
+}
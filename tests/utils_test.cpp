@@ -7,12 +7,17 @@
 #include <libdariadb/utils/cz.h>
 #include <libdariadb/utils/fs.h>
 #include <libdariadb/utils/in_interval.h>
+#include <libdariadb/utils/merge.h>
+#include <libdariadb/utils/radix_sort.h>
+#include <libdariadb/utils/sharded_id_map.h>
 #include <libdariadb/utils/strings.h>
 #include <libdariadb/utils/utils.h>
 #include <boost/test/unit_test.hpp>
 #include <chrono>
 #include <ctime>
 #include <ctime>
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <thread>
 
@@ -242,3 +247,112 @@ BOOST_AUTO_TEST_CASE(SplitString) {
   splitted = dariadb::utils::strings::split(str, ' ');
   BOOST_CHECK_EQUAL(splitted.size(), size_t(8));
 }
+
+BOOST_AUTO_TEST_CASE(RadixSort) {
+  using namespace dariadb::utils::async;
+
+  auto by_id_time = [](const dariadb::Meas &l, const dariadb::Meas &r) {
+    return l.id < r.id || (l.id == r.id && l.time < r.time);
+  };
+
+  dariadb::MeasArray values(100000);
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i].id = dariadb::Id(std::rand() % 300);
+    values[i].time = dariadb::Time(std::rand() % 5000) + (dariadb::Time(1) << 40);
+    values[i].value = dariadb::Value(i);
+  }
+  auto expected = values;
+  std::stable_sort(expected.begin(), expected.end(), by_id_time);
+
+  // without thread manager
+  auto small = dariadb::MeasArray(values.begin(), values.begin() + 1000);
+  auto small_expected = small;
+  std::stable_sort(small_expected.begin(), small_expected.end(), by_id_time);
+  dariadb::utils::radix_sort(small);
+  BOOST_CHECK(dariadb::utils::is_sorted_by_id(small));
+  for (size_t i = 0; i < small.size(); ++i) {
+    BOOST_CHECK_EQUAL(small[i].value, small_expected[i].value);
+  }
+
+  ThreadPool::Params tp(size_t(4), (ThreadKind)THREAD_KINDS::COMMON);
+  ThreadManager::start(ThreadManager::Params(std::vector<ThreadPool::Params>{tp}));
+  dariadb::utils::radix_sort(values);
+  ThreadManager::stop();
+
+  BOOST_CHECK(dariadb::utils::is_sorted_by_id(values));
+  size_t mismatch = 0;
+  for (size_t i = 0; i < values.size(); ++i) {
+    if (values[i].value != expected[i].value) { // sort is stable
+      ++mismatch;
+    }
+  }
+  BOOST_CHECK_EQUAL(mismatch, size_t(0));
+}
+
+BOOST_AUTO_TEST_CASE(MergeRuns) {
+  auto make_run = [](std::vector<dariadb::Time> times, dariadb::Value value) {
+    dariadb::MeasArray result;
+    for (auto t : times) {
+      auto m = dariadb::Meas::empty(1);
+      m.time = t;
+      m.value = value;
+      result.push_back(m);
+    }
+    return result;
+  };
+  auto pages = make_run({1, 3, 5, 7}, 1);
+  auto wal = make_run({6, 2, 4, 2}, 2); // unordered, with duplicate.
+  auto memory = make_run({7, 8, 9}, 3);
+  memory[1].flag = dariadb::Flags::_NO_DATA;
+  dariadb::MeasArray empty;
+
+  std::vector<dariadb::MeasArray *> runs{&pages, &empty, &wal, &memory};
+  dariadb::MeasArray out(pages.size() + wal.size() + memory.size());
+  auto end = dariadb::utils::merge_runs(runs, out.begin());
+  out.erase(end, out.end());
+
+  std::vector<dariadb::Time> times{1, 2, 3, 4, 5, 6, 7, 9};
+  BOOST_CHECK_EQUAL(out.size(), times.size());
+  for (size_t i = 0; i < times.size() && i < out.size(); ++i) {
+    BOOST_CHECK_EQUAL(out[i].time, times[i]);
+  }
+  // value of equal time is taken from the first run.
+  BOOST_CHECK_EQUAL(out[6].value, dariadb::Value(1));
+}
+
+BOOST_AUTO_TEST_CASE(ShardedIdMap) {
+  dariadb::utils::ShardedIdMap<dariadb::Id> map(10);
+  const dariadb::Id ids_count = 1000;
+  std::atomic<size_t> mismatch{0};
+  std::vector<std::thread> writers;
+  for (size_t t = 0; t < 4; ++t) {
+    writers.emplace_back([&map, &mismatch, ids_count]() {
+      for (dariadb::Id i = 1; i <= ids_count; ++i) {
+        auto v = map.insert(i, [i]() { return std::make_shared<dariadb::Id>(i); });
+        if (*v != i) {
+          mismatch++;
+        }
+      }
+    });
+  }
+  for (auto &t : writers) {
+    t.join();
+  }
+  BOOST_CHECK_EQUAL(mismatch.load(), size_t(0));
+  BOOST_CHECK_EQUAL(map.size(), size_t(ids_count));
+  BOOST_CHECK(map.find(ids_count + 1) == nullptr);
+  for (dariadb::Id i = 1; i <= ids_count; ++i) {
+    auto v = map.find(i);
+    BOOST_CHECK(v != nullptr && *v == i);
+  }
+  size_t visited = 0;
+  map.foreach ([&visited](dariadb::Id id, dariadb::Id *v) {
+    BOOST_CHECK_EQUAL(id, *v);
+    visited++;
+  });
+  BOOST_CHECK_EQUAL(visited, size_t(ids_count));
+
+  map.clear();
+  BOOST_CHECK_EQUAL(map.size(), size_t(0));
+  BOOST_CHECK(map.find(1) == nullptr);
+}
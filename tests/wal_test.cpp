@@ -3,13 +3,17 @@
 #include <boost/test/unit_test.hpp>
 #include <atomic>
 #include <cassert>
+#include <limits>
 #include <map>
+#include <set>
 #include <thread>
 
 #include "test_common.h"
+#include <libdariadb/storage/callbacks.h>
 #include <libdariadb/storage/engine_environment.h>
 #include <libdariadb/storage/manifest.h>
 #include <libdariadb/storage/settings.h>
+#include <libdariadb/storage/wal/wal_block.h>
 #include <libdariadb/storage/wal/wal_manager.h>
 #include <libdariadb/storage/wal/walfile.h>
 #include <libdariadb/timeutil.h>
@@ -45,6 +49,45 @@ public:
   }
 };
 
+BOOST_AUTO_TEST_CASE(WalBlockEncodeTest) {
+  const size_t count = 1000;
+  dariadb::MeasArray values(count);
+  for (size_t i = 0; i < count; ++i) {
+    values[i].id = dariadb::Id(i % 7);
+    values[i].time = dariadb::Time(1000 + i * 10 - (i % 3) * 15);
+    values[i].value = dariadb::Value(i % 5 == 0 ? i * 0.5 : 42.0);
+    values[i].flag = dariadb::Flag(i % 11 == 0 ? i : 0);
+  }
+
+  dariadb::storage::WALBlockWriter writer;
+  std::vector<uint8_t> buffer;
+  writer.encode(values.data(), values.size(), &buffer);
+  BOOST_CHECK(buffer.size() < count * sizeof(dariadb::Meas) / 2);
+
+  dariadb::storage::WALBlockReader reader(buffer.data(), buffer.size());
+  BOOST_CHECK(reader.is_valid());
+  dariadb::Meas m;
+  size_t readed = 0;
+  while (reader.next(&m)) {
+    auto &expected = values[readed];
+    BOOST_CHECK_EQUAL(m.id, expected.id);
+    BOOST_CHECK_EQUAL(m.time, expected.time);
+    BOOST_CHECK_EQUAL(m.value, expected.value);
+    BOOST_CHECK_EQUAL(m.flag, expected.flag);
+    ++readed;
+  }
+  BOOST_CHECK_EQUAL(readed, count);
+  BOOST_CHECK(reader.is_valid());
+
+  // truncated block
+  dariadb::storage::WALBlockReader broken(buffer.data(), buffer.size() / 2);
+  readed = 0;
+  while (broken.next(&m)) {
+    ++readed;
+  }
+  BOOST_CHECK(readed < count);
+}
+
 BOOST_AUTO_TEST_CASE(WalInitTest) {
   const size_t block_size = 1000;
   auto storage_path = "testStorage";
@@ -167,6 +210,80 @@ BOOST_AUTO_TEST_CASE(WALFileCommonTest) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(WALFileSummaryTest) {
+  const size_t block_size = 10;
+  auto storage_path = "testStorage";
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+  {
+    dariadb::utils::fs::mkdir(storage_path);
+
+    auto settings = dariadb::storage::Settings::create(storage_path);
+    settings->wal_cache_size.setValue(block_size);
+    settings->wal_file_size.setValue(block_size * 10);
+
+    auto manifest = dariadb::storage::Manifest::create(settings);
+
+    auto _engine_env = dariadb::storage::EngineEnvironment::create();
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::SETTINGS,
+                             settings.get());
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::MANIFEST,
+                             manifest.get());
+
+    auto wal = dariadb::storage::WALFile::create(_engine_env);
+    // block N contains ids {N, N+1}
+    for (size_t block = 0; block < 5; ++block) {
+      dariadb::MeasArray ma(block_size);
+      for (size_t i = 0; i < block_size; ++i) {
+        ma[i].id = dariadb::Id(block + i % 2);
+        ma[i].time = dariadb::Time(block * block_size + i);
+      }
+      wal->append(ma.begin(), ma.end());
+    }
+
+    auto summary = wal->summary();
+    BOOST_CHECK_EQUAL(summary->minTime(), dariadb::Time(0));
+    BOOST_CHECK_EQUAL(summary->maxTime(), dariadb::Time(block_size * 5 - 1));
+    BOOST_CHECK_EQUAL(summary->blocks(dariadb::IdArray{2}, 0, dariadb::MAX_TIME).size(),
+                      size_t(2));
+    BOOST_CHECK_EQUAL(summary->blocks(dariadb::IdArray{2}, 0, block_size * 2 - 1).size(),
+                      size_t(1));
+    BOOST_CHECK_EQUAL(summary->blocks(dariadb::IdArray{}, 0, dariadb::MAX_TIME).size(),
+                      size_t(5));
+    BOOST_CHECK(!summary->contains(dariadb::IdArray{10}, 0, dariadb::MAX_TIME));
+    BOOST_CHECK(!summary->contains(dariadb::IdArray{0}, block_size, dariadb::MAX_TIME));
+
+    // rebuilt on open.
+    auto reopened = dariadb::storage::WALFile::open(_engine_env, wal->filename(), true);
+    auto rebuilded = reopened->summary();
+    BOOST_CHECK(rebuilded != summary);
+    BOOST_CHECK(rebuilded->blocks(dariadb::IdArray{2}, 0, dariadb::MAX_TIME) ==
+                summary->blocks(dariadb::IdArray{2}, 0, dariadb::MAX_TIME));
+    dariadb::Time mn, mx;
+    BOOST_CHECK(reopened->minMaxTime(2, &mn, &mx));
+    BOOST_CHECK_EQUAL(mn, dariadb::Time(block_size + 1));
+    BOOST_CHECK_EQUAL(mx, dariadb::Time(block_size * 3 - 2));
+
+    auto out = reopened->readInterval(
+        dariadb::storage::QueryInterval(dariadb::IdArray{2}, 0, 0, dariadb::MAX_TIME));
+    BOOST_CHECK_EQUAL(out.size(), block_size);
+
+    // with summary blocks are not scanned on open, but readed by query.
+    auto with_summary =
+        dariadb::storage::WALFile::open(_engine_env, wal->filename(), true, summary);
+    BOOST_CHECK_EQUAL(with_summary->end_offset(), std::numeric_limits<uint64_t>::max());
+    out = with_summary->readInterval(
+        dariadb::storage::QueryInterval(dariadb::IdArray{2}, 0, 0, dariadb::MAX_TIME));
+    BOOST_CHECK_EQUAL(out.size(), block_size);
+    manifest = nullptr;
+  }
+
+  if (dariadb::utils::fs::path_exists(storage_path)) {
+    dariadb::utils::fs::rm(storage_path);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(WalManager_CommonTest) {
   const std::string storagePath = "testStorage";
   const size_t max_size = 150;
@@ -242,3 +359,365 @@ BOOST_AUTO_TEST_CASE(WalManager_CommonTest) {
     dariadb::utils::fs::rm(storagePath);
   }
 }
+
+BOOST_AUTO_TEST_CASE(WalManager_GroupCommitTest) {
+  const std::string storagePath = "testStorage";
+  const size_t threads_count = 4;
+  const size_t writes_per_thread = 250;
+
+  if (dariadb::utils::fs::path_exists(storagePath)) {
+    dariadb::utils::fs::rm(storagePath);
+  }
+  dariadb::utils::fs::mkdir(storagePath);
+  {
+    auto settings = dariadb::storage::Settings::create(storagePath);
+    settings->wal_file_size.setValue(100);
+    settings->wal_cache_size.setValue(16);
+    settings->wal_sync.setValue(dariadb::storage::WAL_SYNC::ALWAYS);
+    settings->save();
+
+    auto manifest = dariadb::storage::Manifest::create(settings);
+
+    auto _engine_env = dariadb::storage::EngineEnvironment::create();
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::SETTINGS,
+                             settings.get());
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::MANIFEST,
+                             manifest.get());
+
+    dariadb::utils::async::ThreadManager::start(settings->thread_pools_params());
+
+    auto am = dariadb::storage::WALManager::create(_engine_env);
+
+    std::vector<std::thread> writers;
+    for (size_t i = 0; i < threads_count; ++i) {
+      writers.emplace_back([&am, i, writes_per_thread]() {
+        auto m = dariadb::Meas::empty(dariadb::Id(i));
+        for (size_t t = 0; t < writes_per_thread; ++t) {
+          m.time = dariadb::Time(t);
+          am->append(m);
+        }
+      });
+    }
+    for (auto &t : writers) {
+      t.join();
+    }
+
+    // all values are in files without flush.
+    size_t in_files = 0;
+    for (auto &f : manifest->wal_list()) {
+      in_files += dariadb::storage::WALFile::writed(
+          dariadb::utils::fs::append_path(settings->raw_path.value(), f));
+    }
+    BOOST_CHECK_EQUAL(in_files, threads_count * writes_per_thread);
+
+    dariadb::storage::QueryInterval qi(dariadb::IdArray{0, 1, 2, 3}, dariadb::Flag(), 0,
+                                       dariadb::Time(writes_per_thread));
+    BOOST_CHECK_EQUAL(am->readInterval(qi).size(), threads_count * writes_per_thread);
+
+    am = nullptr;
+    dariadb::utils::async::ThreadManager::stop();
+  }
+  {
+    auto settings = dariadb::storage::Settings::create(storagePath);
+    BOOST_CHECK(settings->wal_sync.value() == dariadb::storage::WAL_SYNC::ALWAYS);
+  }
+  if (dariadb::utils::fs::path_exists(storagePath)) {
+    dariadb::utils::fs::rm(storagePath);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(WalManager_IntervalSyncTest) {
+  const std::string storagePath = "testStorage";
+
+  if (dariadb::utils::fs::path_exists(storagePath)) {
+    dariadb::utils::fs::rm(storagePath);
+  }
+  dariadb::utils::fs::mkdir(storagePath);
+  {
+    auto settings = dariadb::storage::Settings::create(storagePath);
+    settings->wal_file_size.setValue(100);
+    settings->wal_cache_size.setValue(50);
+    settings->wal_sync.setValue(dariadb::storage::WAL_SYNC::INTERVAL);
+    settings->wal_sync_interval.setValue(10);
+    settings->save();
+
+    auto manifest = dariadb::storage::Manifest::create(settings);
+
+    auto _engine_env = dariadb::storage::EngineEnvironment::create();
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::SETTINGS,
+                             settings.get());
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::MANIFEST,
+                             manifest.get());
+
+    dariadb::utils::async::ThreadManager::start(settings->thread_pools_params());
+
+    auto am = dariadb::storage::WALManager::create(_engine_env);
+
+    auto m = dariadb::Meas::empty(dariadb::Id(1));
+    am->append(m);
+
+    // buffer is flushed without new appends.
+    size_t in_files = 0;
+    for (size_t i = 0; i < 100 && in_files == 0; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      for (auto &f : manifest->wal_list()) {
+        in_files += dariadb::storage::WALFile::writed(
+            dariadb::utils::fs::append_path(settings->raw_path.value(), f));
+      }
+    }
+    BOOST_CHECK_EQUAL(in_files, size_t(1));
+
+    am = nullptr;
+    dariadb::utils::async::ThreadManager::stop();
+  }
+  if (dariadb::utils::fs::path_exists(storagePath)) {
+    dariadb::utils::fs::rm(storagePath);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(WalManager_RecycleTest) {
+  const std::string storagePath = "testStorage";
+  const size_t max_size = 50;
+  const size_t writes_count = max_size * 5;
+
+  if (dariadb::utils::fs::path_exists(storagePath)) {
+    dariadb::utils::fs::rm(storagePath);
+  }
+  dariadb::utils::fs::mkdir(storagePath);
+  {
+    auto settings = dariadb::storage::Settings::create(storagePath);
+    settings->wal_file_size.setValue(max_size);
+    settings->wal_cache_size.setValue(max_size / 5);
+
+    auto manifest = dariadb::storage::Manifest::create(settings);
+
+    auto _engine_env = dariadb::storage::EngineEnvironment::create();
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::SETTINGS,
+                             settings.get());
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::MANIFEST,
+                             manifest.get());
+
+    dariadb::utils::async::ThreadManager::start(settings->thread_pools_params());
+
+    auto am = dariadb::storage::WALManager::create(_engine_env);
+    auto m = dariadb::Meas::empty(dariadb::Id(1));
+    for (size_t i = 0; i < writes_count; ++i) {
+      m.time = dariadb::Time(i);
+      am->append(m);
+    }
+    am->flush();
+
+    auto closed = am->closedWals();
+    BOOST_CHECK(closed.size() > size_t(1));
+    uint64_t max_seq = 0;
+    for (auto &f : closed) {
+      auto seq = dariadb::storage::WALFile::sequence(f);
+      BOOST_CHECK(seq > max_seq);
+      max_seq = seq;
+      am->erase(dariadb::utils::fs::extract_filename(f));
+    }
+    auto free_segments = dariadb::utils::fs::ls(settings->raw_path.value(),
+                                                dariadb::storage::WAL_FREE_EXT);
+    BOOST_CHECK(free_segments.size() != size_t(0));
+    BOOST_CHECK_EQUAL(am->filesCount(), size_t(1));
+    auto current = manifest->wal_list().front();
+    max_seq = dariadb::storage::WALFile::sequence(
+        dariadb::utils::fs::append_path(settings->raw_path.value(), current));
+
+    // new files reuse free segments, old values are not visible.
+    for (size_t i = 0; i < max_size * 2; ++i) {
+      m.time = dariadb::Time(writes_count + i);
+      am->append(m);
+    }
+    am->flush();
+    BOOST_CHECK(dariadb::utils::fs::ls(settings->raw_path.value(),
+                                       dariadb::storage::WAL_FREE_EXT)
+                    .size() < free_segments.size());
+
+    size_t in_files = 0;
+    for (auto &f : manifest->wal_list()) {
+      if (f == current) {
+        continue;
+      }
+      auto full_path = dariadb::utils::fs::append_path(settings->raw_path.value(), f);
+      BOOST_CHECK(dariadb::storage::WALFile::sequence(full_path) > max_seq);
+      in_files +=
+          dariadb::storage::WALFile::open(_engine_env, full_path, true)->readAll()->size();
+    }
+    BOOST_CHECK_EQUAL(in_files, max_size * 2);
+
+    dariadb::storage::QueryInterval qi(dariadb::IdArray{1}, dariadb::Flag(), 0,
+                                       dariadb::Time(writes_count + max_size * 2));
+    BOOST_CHECK_EQUAL(am->readInterval(qi).size(), max_size * 3);
+
+    am = nullptr;
+    dariadb::utils::async::ThreadManager::stop();
+  }
+  if (dariadb::utils::fs::path_exists(storagePath)) {
+    dariadb::utils::fs::rm(storagePath);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(WalManager_ShardsTest) {
+  const std::string storagePath = "testStorage";
+  const size_t shards = 4;
+  const size_t threads_count = 8;
+  const size_t writes_per_thread = 500;
+
+  if (dariadb::utils::fs::path_exists(storagePath)) {
+    dariadb::utils::fs::rm(storagePath);
+  }
+  dariadb::utils::fs::mkdir(storagePath);
+  dariadb::IdArray all_ids;
+  for (size_t i = 0; i < threads_count; ++i) {
+    all_ids.push_back(dariadb::Id(i));
+  }
+  dariadb::storage::QueryInterval qi(all_ids, dariadb::Flag(), 0,
+                                     dariadb::Time(writes_per_thread));
+  {
+    auto settings = dariadb::storage::Settings::create(storagePath);
+    settings->wal_file_size.setValue(300);
+    settings->wal_cache_size.setValue(50);
+    settings->wal_shards.setValue(shards);
+    settings->save();
+
+    auto manifest = dariadb::storage::Manifest::create(settings);
+
+    auto _engine_env = dariadb::storage::EngineEnvironment::create();
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::SETTINGS,
+                             settings.get());
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::MANIFEST,
+                             manifest.get());
+
+    dariadb::utils::async::ThreadManager::start(settings->thread_pools_params());
+
+    auto am = dariadb::storage::WALManager::create(_engine_env);
+
+    std::vector<std::thread> writers;
+    for (size_t i = 0; i < threads_count; ++i) {
+      writers.emplace_back([&am, i, writes_per_thread]() {
+        auto m = dariadb::Meas::empty(dariadb::Id(i));
+        for (size_t t = 0; t < writes_per_thread; ++t) {
+          m.time = dariadb::Time(t);
+          am->append(m);
+        }
+      });
+    }
+    for (auto &t : writers) {
+      t.join();
+    }
+
+    // values in buffers and in files of all shards are visible.
+    BOOST_CHECK_EQUAL(am->readInterval(qi).size(), threads_count * writes_per_thread);
+    BOOST_CHECK(am->filesCount() - am->closedWals().size() <= shards);
+    BOOST_CHECK(am->filesCount() - am->closedWals().size() > size_t(1));
+
+    am = nullptr;
+    dariadb::utils::async::ThreadManager::stop();
+  }
+  {
+    auto settings = dariadb::storage::Settings::create(storagePath);
+    BOOST_CHECK_EQUAL(settings->wal_shards.value(), shards);
+    auto manifest = dariadb::storage::Manifest::create(settings);
+
+    auto _engine_env = dariadb::storage::EngineEnvironment::create();
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::SETTINGS,
+                             settings.get());
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::MANIFEST,
+                             manifest.get());
+
+    dariadb::utils::async::ThreadManager::start(settings->thread_pools_params());
+    auto am = dariadb::storage::WALManager::create(_engine_env);
+    auto out = am->readInterval(qi);
+    BOOST_CHECK_EQUAL(out.size(), threads_count * writes_per_thread);
+
+    am = nullptr;
+    dariadb::utils::async::ThreadManager::stop();
+  }
+  if (dariadb::utils::fs::path_exists(storagePath)) {
+    dariadb::utils::fs::rm(storagePath);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(WalManager_ReadWhileWriteTest) {
+  const std::string storagePath = "testStorage";
+  const size_t threads_count = 4;
+  const size_t writes_per_thread = 10000;
+
+  if (dariadb::utils::fs::path_exists(storagePath)) {
+    dariadb::utils::fs::rm(storagePath);
+  }
+  dariadb::utils::fs::mkdir(storagePath);
+  dariadb::IdArray all_ids;
+  for (size_t i = 0; i < threads_count; ++i) {
+    all_ids.push_back(dariadb::Id(i));
+  }
+  dariadb::storage::QueryInterval qi(all_ids, dariadb::Flag(), dariadb::MIN_TIME,
+                                     dariadb::MAX_TIME);
+  {
+    auto settings = dariadb::storage::Settings::create(storagePath);
+    settings->wal_file_size.setValue(1000);
+    settings->wal_cache_size.setValue(10);
+    settings->wal_shards.setValue(threads_count);
+    settings->save();
+
+    auto manifest = dariadb::storage::Manifest::create(settings);
+
+    auto _engine_env = dariadb::storage::EngineEnvironment::create();
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::SETTINGS,
+                             settings.get());
+    _engine_env->addResource(dariadb::storage::EngineEnvironment::Resource::MANIFEST,
+                             manifest.get());
+
+    dariadb::utils::async::ThreadManager::start(settings->thread_pools_params());
+
+    auto am = dariadb::storage::WALManager::create(_engine_env);
+
+    std::atomic<size_t> writers_done{0};
+    std::vector<std::thread> writers;
+    for (size_t i = 0; i < threads_count; ++i) {
+      writers.emplace_back([&am, &writers_done, i, writes_per_thread]() {
+        auto m = dariadb::Meas::empty(dariadb::Id(i));
+        for (size_t t = 0; t < writes_per_thread; ++t) {
+          m.time = dariadb::Time(t);
+          am->append(m);
+        }
+        writers_done++;
+      });
+    }
+
+    // files are readed without shard locks: values, flushed from buffers after
+    // the start of read, are not readed twice.
+    bool read_is_consistent = true;
+    while (writers_done.load() != threads_count) {
+      dariadb::storage::MList_ReaderClb clbk;
+      am->foreach (qi, &clbk);
+      std::map<dariadb::Id, std::set<dariadb::Time>> readed;
+      for (auto &m : clbk.mlist) {
+        readed[m.id].insert(m.time);
+      }
+      size_t unique = 0;
+      for (auto &kv : readed) {
+        unique += kv.second.size();
+        // values of one id are appended in order of time.
+        if (*kv.second.rbegin() + 1 != kv.second.size()) {
+          read_is_consistent = false;
+        }
+      }
+      if (unique != clbk.mlist.size()) {
+        read_is_consistent = false;
+      }
+    }
+    for (auto &t : writers) {
+      t.join();
+    }
+    BOOST_CHECK(read_is_consistent);
+    BOOST_CHECK_EQUAL(am->readInterval(qi).size(), threads_count * writes_per_thread);
+
+    am = nullptr;
+    dariadb::utils::async::ThreadManager::stop();
+  }
+  if (dariadb::utils::fs::path_exists(storagePath)) {
+    dariadb::utils::fs::rm(storagePath);
+  }
+}